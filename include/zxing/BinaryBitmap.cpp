@@ -16,8 +16,14 @@
  */
 
 #include <zxing/BinaryBitmap.h>
+#include <zxing/IllegalStateException.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/common/GreyscaleLuminanceSource.h>
+#include <string.h>
 
+using std::vector;
 using zxing::Ref;
+using zxing::ArrayRef;
 using zxing::BitArray;
 using zxing::BitMatrix;
 using zxing::LuminanceSource;
@@ -25,46 +31,153 @@ using zxing::BinaryBitmap;
 	
 // VC++
 using zxing::Binarizer;
+using zxing::IllegalArgumentException;
+using zxing::IllegalStateException;
+using zxing::GreyscaleLuminanceSource;
 
-BinaryBitmap::BinaryBitmap(Ref<Binarizer> binarizer) : binarizer_(binarizer) {
+namespace {
+
+// A copy of the rectangle's rows, for sources that cannot crop themselves
+Ref<LuminanceSource> copyRegion(Ref<LuminanceSource> source, int left, int top, int width, int height) {
+  ArrayRef<char> pixels(width * height);
+  ArrayRef<char> row;
+  for (int y = 0; y < height; y++) {
+    row = source->getRow(top + y, row);
+    memcpy(&pixels[y * width], &row[left], width);
+  }
+  return Ref<LuminanceSource>(new GreyscaleLuminanceSource(pixels, width, height, 0, 0, width, height));
+}
+
+// The 32 bits of words starting at bit from, with bits past the end of words read as 0
+int windowWord(int const* words, int wordCount, int from) {
+  int word = from >> 5;
+  int shift = from & 0x1f;
+  unsigned int value = (unsigned int) words[word] >> shift;
+  if (shift != 0 && word + 1 < wordCount) {
+    value |= (unsigned int) words[word + 1] << (32 - shift);
+  }
+  return (int) value;
+}
+
+}
+
+BinaryBitmap::BinaryBitmap(Ref<Binarizer> binarizer)
+    : binarizer_(binarizer), left_(0), top_(0),
+      width_(binarizer->getWidth()), height_(binarizer->getHeight()) {
+}
+
+BinaryBitmap::BinaryBitmap(Ref<BinaryBitmap> parent, int left, int top, int width, int height)
+    : binarizer_(parent->binarizer_), parent_(parent),
+      left_(left), top_(top), width_(width), height_(height) {
+}
+	
+BinaryBitmap::BinaryBitmap(Ref<BitMatrix> matrix)
+    : matrix_(matrix), left_(0), top_(0),
+      width_(matrix->getWidth()), height_(matrix->getHeight()) {
 }
 	
 BinaryBitmap::~BinaryBitmap() {
 }
 	
 Ref<BitArray> BinaryBitmap::getBlackRow(int y, Ref<BitArray> row) {
-  return binarizer_->getBlackRow(y, row);
+  // A crop of a bitmap made from a matrix has neither a binarizer nor,
+  // until asked for, a matrix of its own; its rows come from the parent
+  if (!parent_) {
+    if (!binarizer_) {
+      return matrix_->getRow(y, row);
+    }
+    return binarizer_->getBlackRow(y, row);
+  }
+  Ref<BitArray> parentRow = parent_->getBlackRow(top_ + y, Ref<BitArray>());
+  if (row == NULL || row->getSize() < width_) {
+    row = new BitArray(width_);
+  } else {
+    row->clear();
+  }
+  vector<int>& words = parentRow->getBitArray();
+  for (int x = 0; x < width_; x += 32) {
+    int value = windowWord(&words[0], (int) words.size(), left_ + x);
+    if (width_ - x < 32) {
+      value &= (1 << (width_ - x)) - 1;
+    }
+    row->setBulk(x, value);
+  }
+  return row;
 }
 	
 Ref<BitMatrix> BinaryBitmap::getBlackMatrix() {
-  return binarizer_->getBlackMatrix();
+  if (!matrix_) {
+    if (parent_) {
+      matrix_ = parent_->getBlackMatrix()->crop(left_, top_, width_, height_);
+    } else {
+      matrix_ = binarizer_->getBlackMatrix();
+    }
+  }
+  return matrix_;
 }
 	
 int BinaryBitmap::getWidth() const {
-  return getLuminanceSource()->getWidth();
+  return width_;
 }
 	
 int BinaryBitmap::getHeight() const {
-  return getLuminanceSource()->getHeight();
+  return height_;
+}
+
+int BinaryBitmap::getLeft() const {
+  return parent_ ? parent_->getLeft() + left_ : 0;
+}
+
+int BinaryBitmap::getTop() const {
+  return parent_ ? parent_->getTop() + top_ : 0;
 }
 	
 Ref<LuminanceSource> BinaryBitmap::getLuminanceSource() const {
+  if (!binarizer_) {
+    throw IllegalStateException("This bitmap has no luminance source.");
+  }
+  if (parent_) {
+    Ref<LuminanceSource> source = parent_->getLuminanceSource();
+    if (!source->isCropSupported()) {
+      return copyRegion(source, left_, top_, width_, height_);
+    }
+    return source->crop(left_, top_, width_, height_);
+  }
   return binarizer_->getLuminanceSource();
 }
 	
 
 bool BinaryBitmap::isCropSupported() const {
-  return getLuminanceSource()->isCropSupported();
+  return true;
 }
 
 Ref<BinaryBitmap> BinaryBitmap::crop(int left, int top, int width, int height) {
-  return Ref<BinaryBitmap> (new BinaryBitmap(binarizer_->createBinarizer(getLuminanceSource()->crop(left, top, width, height))));
+  if (left < 0 || top < 0 || width < 1 || height < 1 ||
+      left + width > width_ || top + height > height_) {
+    throw IllegalArgumentException("Crop rectangle does not fit within image data.");
+  }
+  if (parent_) {
+    return Ref<BinaryBitmap>(new BinaryBitmap(parent_, left_ + left, top_ + top, width, height));
+  }
+  return Ref<BinaryBitmap>(new BinaryBitmap(Ref<BinaryBitmap>(this), left, top, width, height));
+}
+
+Ref<BinaryBitmap> BinaryBitmap::invert() {
+  if (!inverted_) {
+    Ref<BitMatrix> matrix = getBlackMatrix()->crop(0, 0, width_, height_);
+    matrix->flip();
+    inverted_ = new BinaryBitmap(matrix);
+  }
+  return inverted_;
 }
 
 bool BinaryBitmap::isRotateSupported() const {
-  return getLuminanceSource()->isRotateSupported();
+  return true;
 }
 
 Ref<BinaryBitmap> BinaryBitmap::rotateCounterClockwise() {
-  return Ref<BinaryBitmap> (new BinaryBitmap(binarizer_->createBinarizer(getLuminanceSource()->rotateCounterClockwise())));
+  if (!rotated_) {
+    rotated_ = new BinaryBitmap(getBlackMatrix()->rotateCounterClockwise());
+  }
+  return rotated_;
 }
@@ -30,25 +30,52 @@ namespace zxing {
 	class BinaryBitmap : public Counted {
 	private:
 		Ref<Binarizer> binarizer_;
+		Ref<BitMatrix> matrix_;
+
+		// Crops are windows into the bitmap they were taken from: they share its binarizer and
+		// black matrix instead of binarizing the cropped region again.
+		Ref<BinaryBitmap> parent_;
+		int left_;
+		int top_;
+		int width_;
+		int height_;
+
+		// Rotating reads the columns of the black matrix that was already computed, the result is
+		// cached for the frame. Rotated bitmaps have no binarizer, only their matrix.
+		Ref<BinaryBitmap> rotated_;
+		Ref<BinaryBitmap> inverted_;
+
+		BinaryBitmap(Ref<BinaryBitmap> parent, int left, int top, int width, int height);
 		
 	public:
 		BinaryBitmap(Ref<Binarizer> binarizer);
+		// Wraps a matrix that has already been binarized. There is no luminance source behind it.
+		BinaryBitmap(Ref<BitMatrix> matrix);
 		virtual ~BinaryBitmap();
 		
 		Ref<BitArray> getBlackRow(int y, Ref<BitArray> row);
 		Ref<BitMatrix> getBlackMatrix();
 		
+		// A crop's source is cropped from the frame's, or copied from its rows if that source cannot crop
 		Ref<LuminanceSource> getLuminanceSource() const;
 
 		int getWidth() const;
 		int getHeight() const;
 
+		// Black and white swapped, from the black matrix flipped word by word. Cached for the
+		// frame like rotations.
+		Ref<BinaryBitmap> invert();
+
 		bool isRotateSupported() const;
 		Ref<BinaryBitmap> rotateCounterClockwise();
 
 		bool isCropSupported() const;
 		Ref<BinaryBitmap> crop(int left, int top, int width, int height);
 
+		// Offset of this bitmap within the frame it was cropped from, 0 if it is not a crop
+		int getLeft() const;
+		int getTop() const;
+
 	};
 	
 }
@@ -0,0 +1,51 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  CancellationToken.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/CancellationToken.h>
+#include <zxing/TimeoutException.h>
+#include <zxing/common/IllegalArgumentException.h>
+
+using zxing::CancellationToken;
+
+CancellationToken::CancellationToken() : cancelled_(false), hasDeadline_(false) {}
+
+CancellationToken::CancellationToken(int budgetMillis) : cancelled_(false), hasDeadline_(true) {
+  if (budgetMillis < 0) {
+    throw IllegalArgumentException("Time budget must not be negative");
+  }
+  deadline_ = std::chrono::steady_clock::now() + std::chrono::milliseconds(budgetMillis);
+}
+
+void CancellationToken::cancel() {
+  cancelled_.store(true, std::memory_order_relaxed);
+}
+
+bool CancellationToken::isCancelled() const {
+  if (cancelled_.load(std::memory_order_relaxed)) {
+    return true;
+  }
+  return hasDeadline_ && std::chrono::steady_clock::now() >= deadline_;
+}
+
+void CancellationToken::check() const {
+  if (isCancelled()) {
+    throw TimeoutException("Decode timed out");
+  }
+}
@@ -0,0 +1,58 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __CANCELLATION_TOKEN_H__
+#define __CANCELLATION_TOKEN_H__
+
+/*
+ *  CancellationToken.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+#include <atomic>
+#include <chrono>
+
+namespace zxing {
+
+/**
+ * Bounds how long a decode may run. Readers and detectors poll it at row,
+ * candidate and recursion boundaries and throw TimeoutException once it
+ * has expired or been cancelled.
+ *
+ * cancel() may be called from another thread, but the reference count is
+ * not atomic: that thread should hold a plain pointer, not a Ref.
+ */
+class CancellationToken : public Counted {
+private:
+  std::atomic<bool> cancelled_;
+  bool hasDeadline_;
+  std::chrono::steady_clock::time_point deadline_;
+
+public:
+  // Never expires on its own; only cancel() stops the decode
+  CancellationToken();
+  // Expires budgetMillis milliseconds from now
+  explicit CancellationToken(int budgetMillis);
+
+  void cancel();
+  bool isCancelled() const;
+  // Throws TimeoutException if cancelled or past the deadline
+  void check() const;
+};
+
+}
+
+#endif // __CANCELLATION_TOKEN_H__
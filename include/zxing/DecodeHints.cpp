@@ -20,9 +20,14 @@
 
 #include <zxing/DecodeHints.h>
 #include <zxing/common/IllegalArgumentException.h>
+#include <zxing/Result.h>
+#include <algorithm>
+#include <thread>
 
 using zxing::Ref;
 using zxing::ResultPointCallback;
+using zxing::CancellationToken;
+using zxing::Result;
 using zxing::DecodeHintType;
 using zxing::DecodeHints;
 
@@ -56,12 +61,45 @@ const DecodeHints DecodeHints::DEFAULT_HINT(
   PDF_417_HINT
   );
 
+namespace {
+  // Module sizes estimated from a single run of pixels are off by up to
+  // about half a module either way
+  const float MODULE_SIZE_TOLERANCE = 1.5f;
+
+  // The hint bits that select barcode formats
+  const DecodeHintType FORMAT_HINTS = (1u << (BarcodeFormat::UPC_EAN_EXTENSION + 1)) - 1;
+
+  int countFormats(DecodeHintType formats) {
+    int count = 0;
+    for (; formats != 0; formats &= formats - 1) {
+      count++;
+    }
+    return count;
+  }
+}
+
 DecodeHints::DecodeHints() {
   hints = 0;
+  scanlineAngleStep = DEFAULT_SCANLINE_ANGLE_STEP;
+  minModuleSize = 0;
+  maxModuleSize = 0;
+  orientation = ORIENTATION_ANY;
+  expectedCount = 0;
+  requiredFormats = 0;
+  wantedFormats = 0;
+  threads = 1;
 }
 
 DecodeHints::DecodeHints(DecodeHintType init) {
   hints = init;
+  scanlineAngleStep = DEFAULT_SCANLINE_ANGLE_STEP;
+  minModuleSize = 0;
+  maxModuleSize = 0;
+  orientation = ORIENTATION_ANY;
+  expectedCount = 0;
+  requiredFormats = 0;
+  wantedFormats = 0;
+  threads = 1;
 }
 
 void DecodeHints::addFormat(BarcodeFormat toadd) {
@@ -124,6 +162,42 @@ bool DecodeHints::getTryHarder() const {
   return (hints & TRYHARDER_HINT) != 0;
 }
 
+void DecodeHints::setAlsoInverted(bool toset) {
+  if (toset) {
+    hints |= ALSO_INVERTED;
+  } else {
+    hints &= ~ALSO_INVERTED;
+  }
+}
+
+bool DecodeHints::getAlsoInverted() const {
+  return (hints & ALSO_INVERTED) != 0;
+}
+
+void DecodeHints::setAdaptiveOrder(bool toset) {
+  if (toset) {
+    hints |= ADAPTIVE_ORDER;
+  } else {
+    hints &= ~ADAPTIVE_ORDER;
+  }
+}
+
+bool DecodeHints::getAdaptiveOrder() const {
+  return (hints & ADAPTIVE_ORDER) != 0;
+}
+
+void DecodeHints::setProposeRegions(bool toset) {
+  if (toset) {
+    hints |= PROPOSE_REGIONS;
+  } else {
+    hints &= ~PROPOSE_REGIONS;
+  }
+}
+
+bool DecodeHints::getProposeRegions() const {
+  return (hints & PROPOSE_REGIONS) != 0;
+}
+
 void DecodeHints::setResultPointCallback(Ref<ResultPointCallback> const& _callback) {
   callback = _callback;
 }
@@ -132,11 +206,171 @@ Ref<ResultPointCallback> DecodeHints::getResultPointCallback() const {
   return callback;
 }
 
+void DecodeHints::setCancellationToken(Ref<CancellationToken> const& _cancellation) {
+  cancellation = _cancellation;
+}
+
+Ref<CancellationToken> DecodeHints::getCancellationToken() const {
+  return cancellation;
+}
+
+void DecodeHints::setScanlineAngleStep(int degrees) {
+  if (degrees < 0 || degrees >= 90) {
+    throw IllegalArgumentException("Scanline angle step must be in [0, 90)");
+  }
+  scanlineAngleStep = degrees;
+}
+
+int DecodeHints::getScanlineAngleStep() const {
+  return scanlineAngleStep;
+}
+
+void DecodeHints::addSearchRegion(int left, int top, int width, int height) {
+  if (left < 0 || top < 0 || width <= 0 || height <= 0) {
+    throw IllegalArgumentException("Search region must be a non-empty rectangle");
+  }
+  searchRegions.push_back(Region(left, top, width, height));
+}
+
+std::vector<DecodeHints::Region> const& DecodeHints::getSearchRegions() const {
+  return searchRegions;
+}
+
+void DecodeHints::clearSearchRegions() {
+  searchRegions.clear();
+}
+
+void DecodeHints::setModuleSizeRange(float minPixels, float maxPixels) {
+  if (minPixels < 0 || maxPixels < 0 || (maxPixels > 0 && minPixels > maxPixels)) {
+    throw IllegalArgumentException("Module size range must satisfy 0 <= min <= max");
+  }
+  minModuleSize = minPixels;
+  maxModuleSize = maxPixels;
+}
+
+float DecodeHints::getMinModuleSize() const {
+  return minModuleSize;
+}
+
+float DecodeHints::getMaxModuleSize() const {
+  return maxModuleSize;
+}
+
+bool DecodeHints::acceptsModuleSize(float moduleSize) const {
+  if (minModuleSize > 0 && moduleSize * MODULE_SIZE_TOLERANCE < minModuleSize) {
+    return false;
+  }
+  if (maxModuleSize > 0 && moduleSize > maxModuleSize * MODULE_SIZE_TOLERANCE) {
+    return false;
+  }
+  return true;
+}
+
+void DecodeHints::setOrientation(Orientation toset) {
+  orientation = toset;
+}
+
+DecodeHints::Orientation DecodeHints::getOrientation() const {
+  return orientation;
+}
+
+void DecodeHints::setExpectedCount(int count) {
+  if (count < 0) {
+    throw IllegalArgumentException("Expected symbol count must not be negative");
+  }
+  expectedCount = count;
+}
+
+int DecodeHints::getExpectedCount() const {
+  return expectedCount;
+}
+
+void DecodeHints::setThreads(int count) {
+  if (count < 0) {
+    throw IllegalArgumentException("Thread count must not be negative");
+  }
+  threads = count;
+}
+
+int DecodeHints::getThreads() const {
+  if (threads > 0) {
+    return threads;
+  }
+  return std::max(1, (int) std::thread::hardware_concurrency());
+}
+
+void DecodeHints::addRequiredFormat(BarcodeFormat format) {
+  DecodeHints single;
+  single.addFormat(format);
+  requiredFormats |= single.hints;
+}
+
+DecodeHintType DecodeHints::missingFormats(std::vector<Ref<Result> > const& results) const {
+  DecodeHintType missing = requiredFormats;
+  for (size_t i = 0; i < results.size(); i++) {
+    missing &= ~(1u << results[i]->getBarcodeFormat());
+  }
+  return missing;
+}
+
+bool DecodeHints::isSatisfiedBy(std::vector<Ref<Result> > const& results) const {
+  if (expectedCount == 0 && requiredFormats == 0) {
+    return false;
+  }
+  return (int) results.size() >= expectedCount && missingFormats(results) == 0;
+}
+
+DecodeHints DecodeHints::forRemainingSymbols(std::vector<Ref<Result> > const& results) const {
+  DecodeHintType missing = missingFormats(results);
+  int remaining = expectedCount - (int) results.size();
+  if (missing == 0 || remaining != countFormats(missing)) {
+    return *this;
+  }
+  DecodeHints narrowed(*this);
+  narrowed.wantedFormats = missing;
+  return narrowed;
+}
+
+bool DecodeHints::wantsFormats(DecodeHintType formats) const {
+  return wantedFormats == 0 || (wantedFormats & formats) != 0;
+}
+
+DecodeHints DecodeHints::withoutFormats(DecodeHints const& formats) const {
+  DecodeHints narrowed(*this);
+  narrowed.hints &= ~(formats.hints & FORMAT_HINTS);
+  return narrowed;
+}
+
 DecodeHints zxing::operator | (DecodeHints const& l, DecodeHints const& r) {
   DecodeHints result (l);
   result.hints |= r.hints;
   if (!result.callback) {
     result.callback = r.callback;
   }
+  if (!result.cancellation) {
+    result.cancellation = r.cancellation;
+  }
+  if (result.searchRegions.empty()) {
+    result.searchRegions = r.searchRegions;
+  }
+  if (result.minModuleSize == 0 && result.maxModuleSize == 0) {
+    result.minModuleSize = r.minModuleSize;
+    result.maxModuleSize = r.maxModuleSize;
+  }
+  if (result.orientation == DecodeHints::ORIENTATION_ANY) {
+    result.orientation = r.orientation;
+  }
+  if (result.expectedCount == 0) {
+    result.expectedCount = r.expectedCount;
+  }
+  result.requiredFormats |= r.requiredFormats;
+  if (result.wantedFormats != 0 && r.wantedFormats != 0) {
+    result.wantedFormats |= r.wantedFormats;
+  } else {
+    result.wantedFormats = 0;
+  }
+  if (result.threads == 1) {
+    result.threads = r.threads;
+  }
   return result;
 }
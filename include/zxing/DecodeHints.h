@@ -22,17 +22,52 @@
 
 #include <zxing/BarcodeFormat.h>
 #include <zxing/ResultPointCallback.h>
+#include <zxing/CancellationToken.h>
+#include <vector>
 
 namespace zxing {
 
 typedef unsigned int DecodeHintType;
 class DecodeHints;
+class Result;
 DecodeHints operator | (DecodeHints const&, DecodeHints const&);
 
 class DecodeHints {
+ public:
+  // A rectangle of the image to search, in pixels
+  struct Region {
+    int left;
+    int top;
+    int width;
+    int height;
+    Region(int left_, int top_, int width_, int height_)
+      : left(left_), top(top_), width(width_), height(height_) {}
+  };
+
+  // Direction a symbol is read in: horizontal symbols are read along the
+  // image rows, vertical ones along the columns
+  enum Orientation {
+    ORIENTATION_ANY,
+    ORIENTATION_HORIZONTAL,
+    ORIENTATION_VERTICAL
+  };
+
  private:
   DecodeHintType hints;
   Ref<ResultPointCallback> callback;
+  Ref<CancellationToken> cancellation;
+  int scanlineAngleStep;
+  std::vector<Region> searchRegions;
+  float minModuleSize;
+  float maxModuleSize;
+  Orientation orientation;
+  int expectedCount;
+  DecodeHintType requiredFormats;
+  // Formats still worth a reader's attempt, 0 for all of them
+  DecodeHintType wantedFormats;
+  int threads;
+
+  DecodeHintType missingFormats(std::vector<Ref<Result> > const& results) const;
 
  public:
   static const DecodeHintType AZTEC_HINT = 1 << BarcodeFormat::AZTEC;
@@ -59,11 +94,21 @@ class DecodeHints {
   // static const DecodeHintType ASSUME_CODE_39_CHECK_DIGIT = 1 << 28;
   static const DecodeHintType  ASSUME_GS1 = 1 << 27;
   // static const DecodeHintType NEED_RESULT_POINT_CALLBACK = 1 << 26;
+  // Also try the frame with black and white swapped, for light-on-dark symbols
+  static const DecodeHintType ALSO_INVERTED = 1 << 25;
+  // Let MultiFormatReader reorder its readers by observed hit rate and cost
+  static const DecodeHintType ADAPTIVE_ORDER = 1 << 24;
+  // Let MultiFormatReader find barcode-like regions first and run only the
+  // readers that fit each region, on that region alone. When none of them
+  // decodes, exploration frames still search the whole frame
+  static const DecodeHintType PROPOSE_REGIONS = 1 << 23;
   
   static const DecodeHints PRODUCT_HINT;
   static const DecodeHints ONED_HINT;
   static const DecodeHints DEFAULT_HINT;
 
+  static const int DEFAULT_SCANLINE_ANGLE_STEP = 15;
+
   DecodeHints();
   DecodeHints(DecodeHintType init);
 
@@ -73,10 +118,75 @@ class DecodeHints {
   void clear() {hints=0;}
   void setTryHarder(bool toset);
   bool getTryHarder() const;
+  void setAlsoInverted(bool toset);
+  bool getAlsoInverted() const;
+  void setAdaptiveOrder(bool toset);
+  bool getAdaptiveOrder() const;
+  void setProposeRegions(bool toset);
+  bool getProposeRegions() const;
 
   void setResultPointCallback(Ref<ResultPointCallback> const&);
   Ref<ResultPointCallback> getResultPointCallback() const;
 
+  // Bounds the decode; readers throw TimeoutException once it expires
+  void setCancellationToken(Ref<CancellationToken> const&);
+  Ref<CancellationToken> getCancellationToken() const;
+  // Throws TimeoutException if the cancellation token has expired
+  void checkCancelled() const {
+    if (cancellation) {
+      cancellation->check();
+    }
+  }
+
+  // Angle in degrees between the tilted scanlines 1D readers try when trying harder;
+  // 0 turns tilted scanning off
+  void setScanlineAngleStep(int degrees);
+  int getScanlineAngleStep() const;
+
+  // Only search these rectangles, in the order added; none means the whole image
+  void addSearchRegion(int left, int top, int width, int height);
+  std::vector<Region> const& getSearchRegions() const;
+  void clearSearchRegions();
+
+  // Expected size of one module in pixels; 0 means unknown
+  void setModuleSizeRange(float minPixels, float maxPixels);
+  float getMinModuleSize() const;
+  float getMaxModuleSize() const;
+  // True if a detector's module size estimate is plausible for the range,
+  // allowing for estimation error; always true with no range set
+  bool acceptsModuleSize(float moduleSize) const;
+
+  void setOrientation(Orientation toset);
+  Orientation getOrientation() const;
+
+  // Number of symbols in view; multi-symbol readers stop once they have
+  // found this many. 0 means unknown
+  void setExpectedCount(int count);
+  int getExpectedCount() const;
+
+  // Threads one decode may use for work it splits up itself, the calling
+  // thread included. 1, the default, keeps it all on the calling thread,
+  // as a decode already running on a pool of threads should; 0 means one
+  // per core
+  void setThreads(int count);
+  int getThreads() const;
+
+  // Formats that must all be among the results before a multi-symbol
+  // decode stops early
+  void addRequiredFormat(BarcodeFormat format);
+  // True once results hold the expected number of symbols and every
+  // required format; always false when neither is set
+  bool isSatisfiedBy(std::vector<Ref<Result> > const& results) const;
+  // Hints for finding the rest of the symbols. When the symbols still
+  // missing can only be the required formats not yet found, only those
+  // are wanted. The formats themselves are left as they are, so a reader
+  // built from them, such as MultiFormatReader's, is kept
+  DecodeHints forRemainingSymbols(std::vector<Ref<Result> > const& results) const;
+  // False if none of formats, a set of format hints, is still wanted
+  bool wantsFormats(DecodeHintType formats) const;
+  // The same hints without the formats selected in formats, e.g. ONED_HINT
+  DecodeHints withoutFormats(DecodeHints const& formats) const;
+
   friend DecodeHints operator | (DecodeHints const&, DecodeHints const&);
 };
 
@@ -24,16 +24,64 @@
 #include <zxing/oned/MultiFormatUPCEANReader.h>
 #include <zxing/oned/MultiFormatOneDReader.h>
 #include <zxing/ReaderException.h>
+#include <zxing/TimeoutException.h>
+#include <zxing/ResultPoint.h>
+#include <algorithm>
+#include <chrono>
+#include <limits>
 
 using zxing::Ref;
 using zxing::Result;
 using zxing::MultiFormatReader;
+using zxing::RegionProposer;
+using zxing::Metrics;
 
 // VC++
 using zxing::DecodeHints;
 using zxing::BinaryBitmap;
+using zxing::BarcodeFormat;
+using zxing::ArrayRef;
+using zxing::ResultPoint;
 
-MultiFormatReader::MultiFormatReader() {}
+const float MultiFormatReader::DROP_HIT_RATE = 0.02f;
+const float MultiFormatReader::SMOOTHING = 1.0f / 16;
+
+namespace {
+  // The formats MultiFormatOneDReader reads
+  const zxing::DecodeHintType ONED_FORMATS =
+    DecodeHints::UPC_A_HINT | DecodeHints::UPC_E_HINT | DecodeHints::EAN_13_HINT | DecodeHints::EAN_8_HINT |
+    DecodeHints::CODABAR_HINT | DecodeHints::CODE_39_HINT | DecodeHints::CODE_93_HINT |
+    DecodeHints::CODE_128_HINT | DecodeHints::ITF_HINT | DecodeHints::RSS_14_HINT |
+    DecodeHints::RSS_EXPANDED_HINT;
+
+  Ref<Result> translateResultPoints(Ref<Result> result, int xOffset, int yOffset) {
+    ArrayRef< Ref<ResultPoint> > oldResultPoints = result->getResultPoints();
+    if (!oldResultPoints || oldResultPoints->empty()) {
+      return result;
+    }
+    ArrayRef< Ref<ResultPoint> > newResultPoints(oldResultPoints->size());
+    for (int i = 0; i < oldResultPoints->size(); i++) {
+      Ref<ResultPoint> oldPoint = oldResultPoints[i];
+      newResultPoints[i] = Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset));
+    }
+    return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints,
+                                  result->getBarcodeFormat()));
+  }
+
+  // Expected time to first success is minimized by trying readers in
+  // decreasing order of hit rate per unit cost.
+  class ByPriorityDescending {
+  private:
+    std::vector<float> const& priority_;
+  public:
+    ByPriorityDescending(std::vector<float> const& priority) : priority_(priority) {}
+    bool operator()(int a, int b) const {
+      return priority_[a] > priority_[b];
+    }
+  };
+}
+
+MultiFormatReader::MultiFormatReader() : frames_(0), proposalsMissed_(false) {}
   
 Ref<Result> MultiFormatReader::decode(Ref<BinaryBitmap> image) {
   setHints(DecodeHints::DEFAULT_HINT);
@@ -53,9 +101,30 @@ Ref<Result> MultiFormatReader::decodeWithState(Ref<BinaryBitmap> image) {
   return decodeInternal(image);
 }
 
+bool MultiFormatReader::sameReaders(DecodeHints const& a, DecodeHints const& b) {
+  if (a.getTryHarder() != b.getTryHarder()) {
+    return false;
+  }
+  for (int format = BarcodeFormat::AZTEC; format <= BarcodeFormat::UPC_EAN_EXTENSION; format++) {
+    BarcodeFormat f((BarcodeFormat::Value)format);
+    if (a.containsFormat(f) != b.containsFormat(f)) {
+      return false;
+    }
+  }
+  return true;
+}
+
 void MultiFormatReader::setHints(DecodeHints hints) {
+  if (!readers_.empty() && sameReaders(hints, hints_)) {
+    // Same reader set as before: keep the readers, their caches and statistics
+    hints_ = hints;
+    return;
+  }
   hints_ = hints;
   readers_.clear();
+  kinds_.clear();
+  formats_.clear();
+  metrics_.clear();
   bool tryHarder = hints.getTryHarder();
 
   bool addOneDReader = hints.containsFormat(BarcodeFormat::UPC_E) ||
@@ -71,19 +140,19 @@ void MultiFormatReader::setHints(DecodeHints hints) {
     hints.containsFormat(BarcodeFormat::RSS_14) ||
     hints.containsFormat(BarcodeFormat::RSS_EXPANDED);
   if (addOneDReader && !tryHarder) {
-    readers_.push_back(Ref<Reader>(new zxing::oned::MultiFormatOneDReader(hints)));
+    addReader(new zxing::oned::MultiFormatOneDReader(hints), RegionProposer::LINEAR, ONED_FORMATS, "one_d");
   }
   if (hints.containsFormat(BarcodeFormat::QR_CODE)) {
-    readers_.push_back(Ref<Reader>(new zxing::qrcode::QRCodeReader()));
+    addReader(new zxing::qrcode::QRCodeReader(), RegionProposer::MATRIX, DecodeHints::QR_CODE_HINT, "qr_code");
   }
   if (hints.containsFormat(BarcodeFormat::DATA_MATRIX)) {
-    readers_.push_back(Ref<Reader>(new zxing::datamatrix::DataMatrixReader()));
+    addReader(new zxing::datamatrix::DataMatrixReader(), RegionProposer::MATRIX, DecodeHints::DATA_MATRIX_HINT, "data_matrix");
   }
   if (hints.containsFormat(BarcodeFormat::AZTEC)) {
-    readers_.push_back(Ref<Reader>(new zxing::aztec::AztecReader()));
+    addReader(new zxing::aztec::AztecReader(), RegionProposer::MATRIX, DecodeHints::AZTEC_HINT, "aztec");
   }
   if (hints.containsFormat(BarcodeFormat::PDF_417)) {
-    readers_.push_back(Ref<Reader>(new zxing::pdf417::PDF417Reader()));
+    addReader(new zxing::pdf417::PDF417Reader(), RegionProposer::STACKED, DecodeHints::PDF_417_HINT, "pdf_417");
   }
   /*
   if (hints.contains(BarcodeFormat.MAXICODE)) {
@@ -91,34 +160,237 @@ void MultiFormatReader::setHints(DecodeHints hints) {
   }
   */
   if (addOneDReader && tryHarder) {
-    readers_.push_back(Ref<Reader>(new zxing::oned::MultiFormatOneDReader(hints)));
+    addReader(new zxing::oned::MultiFormatOneDReader(hints), RegionProposer::LINEAR, ONED_FORMATS, "one_d");
   }
   if (readers_.size() == 0) {
     if (!tryHarder) {
-      readers_.push_back(Ref<Reader>(new zxing::oned::MultiFormatOneDReader(hints)));
+      addReader(new zxing::oned::MultiFormatOneDReader(hints), RegionProposer::LINEAR, ONED_FORMATS, "one_d");
     }
-    readers_.push_back(Ref<Reader>(new zxing::qrcode::QRCodeReader()));
-    readers_.push_back(Ref<Reader>(new zxing::datamatrix::DataMatrixReader()));
-    readers_.push_back(Ref<Reader>(new zxing::aztec::AztecReader()));
-    readers_.push_back(Ref<Reader>(new zxing::pdf417::PDF417Reader()));
+    addReader(new zxing::qrcode::QRCodeReader(), RegionProposer::MATRIX, DecodeHints::QR_CODE_HINT, "qr_code");
+    addReader(new zxing::datamatrix::DataMatrixReader(), RegionProposer::MATRIX, DecodeHints::DATA_MATRIX_HINT, "data_matrix");
+    addReader(new zxing::aztec::AztecReader(), RegionProposer::MATRIX, DecodeHints::AZTEC_HINT, "aztec");
+    addReader(new zxing::pdf417::PDF417Reader(), RegionProposer::STACKED, DecodeHints::PDF_417_HINT, "pdf_417");
     // readers.add(new MaxiCodeReader());
 
     if (tryHarder) {
-      readers_.push_back(Ref<Reader>(new zxing::oned::MultiFormatOneDReader(hints)));
+      addReader(new zxing::oned::MultiFormatOneDReader(hints), RegionProposer::LINEAR, ONED_FORMATS, "one_d");
     }
   }
+
+  stats_.assign(readers_.size(), ReaderStats());
+  order_.resize(readers_.size());
+  for (size_t i = 0; i < order_.size(); i++) {
+    order_[i] = (int)i;
+  }
+  frames_ = 0;
+  proposalsMissed_ = false;
 }
 
 Ref<Result> MultiFormatReader::decodeInternal(Ref<BinaryBitmap> image) {
-  for (unsigned int i = 0; i < readers_.size(); i++) {
+  bool adaptive = hints_.getAdaptiveOrder();
+  bool exploring = !adaptive || frames_++ % EXPLORATION_INTERVAL == 0;
+
+  // A frame is searched a region at a time, so a reader's attempts are
+  // summed over the frame and recorded once, when it is done
+  if (adaptive) {
+    frameAttempts_.assign(readers_.size(), FrameAttempts());
+  }
+  Ref<Result> result;
+  try {
+    std::vector<DecodeHints::Region> const& regions = hints_.getSearchRegions();
+    if (regions.empty()) {
+      result = hints_.getProposeRegions() ? decodeProposals(image, exploring)
+        : decodeImage(image, exploring, ANY_KIND);
+    }
+    for (size_t i = 0; i < regions.size() && result.empty(); i++) {
+      // Clip to the image; regions that miss it entirely are skipped
+      int left = std::min(regions[i].left, image->getWidth());
+      int top = std::min(regions[i].top, image->getHeight());
+      int width = std::min(regions[i].width, image->getWidth() - left);
+      int height = std::min(regions[i].height, image->getHeight() - top);
+      if (width <= 0 || height <= 0) {
+        continue;
+      }
+      result = decodeImage(image->crop(left, top, width, height), exploring, ANY_KIND);
+      if (!result.empty()) {
+        result = translateResultPoints(result, left, top);
+      }
+    }
+  } catch (zxing::TimeoutException const&) {
+    if (adaptive) {
+      recordFrame();
+    }
+    throw;
+  }
+
+  if (adaptive) {
+    recordFrame();
+  }
+  if (result.empty()) {
+    throw ReaderException("No code detected");
+  }
+  return result;
+}
+
+// Regions that do not look like any barcode are never searched, so a frame
+// of background costs one pass over its black matrix. The proposer misses
+// some symbols, such as ones with modules too large to make a cell busy,
+// so when no proposal decodes, exploration frames search the whole frame
+// as well; once that finds a symbol, every frame does until one finds none.
+Ref<Result> MultiFormatReader::decodeProposals(Ref<BinaryBitmap> image, bool exploring) {
+  std::vector<RegionProposer::Proposal> proposals = RegionProposer::propose(image->getBlackMatrix());
+  for (size_t i = 0; i < proposals.size(); i++) {
+    DecodeHints::Region const& region = proposals[i].region;
+    Ref<Result> result = decodeImage(image->crop(region.left, region.top, region.width, region.height),
+                                     exploring, proposals[i].kind);
+    if (!result.empty()) {
+      return translateResultPoints(result, region.left, region.top);
+    }
+  }
+  if (!exploring && !proposalsMissed_) {
+    return Ref<Result>();
+  }
+  Ref<Result> result = decodeImage(image, exploring, ANY_KIND);
+  proposalsMissed_ = !result.empty();
+  return result;
+}
+
+Ref<Result> MultiFormatReader::decodeImage(Ref<BinaryBitmap> image, bool exploring, int kind) {
+  Ref<Result> result = tryReaders(image, exploring, kind);
+  if (result.empty() && hints_.getAlsoInverted()) {
+    // Light-on-dark symbols: reuse the frame's binarization with black and white swapped
+    Ref<BinaryBitmap> inverted;
     try {
-      return readers_[i]->decode(image, hints_);
+      inverted = image->invert();
     } catch (ReaderException const& re) {
       (void)re;
-      // continue
+      return result;
+    }
+    result = tryReaders(inverted, exploring, kind);
+  }
+  return result;
+}
+
+Ref<Result> MultiFormatReader::tryReaders(Ref<BinaryBitmap> image, bool exploring, int kind) {
+  if (!hints_.getAdaptiveOrder()) {
+    for (unsigned int i = 0; i < readers_.size(); i++) {
+      if (!runsOn(kinds_[i], kind) || !hints_.wantsFormats(formats_[i])) {
+        continue;
+      }
+      Ref<Result> result = attempt(i, image);
+      if (!result.empty()) {
+        return result;
+      }
+    }
+    return Ref<Result>();
+  }
+
+  // Only skip readers while some other reader is still finding codes;
+  // on a line with nothing in view everything keeps running
+  bool pruning = false;
+  if (!exploring) {
+    for (size_t i = 0; i < stats_.size(); i++) {
+      pruning = pruning || stats_[i].hitRate >= DROP_HIT_RATE;
     }
   }
-  throw ReaderException("No code detected");
+
+  for (unsigned int k = 0; k < readers_.size(); k++) {
+    int i = exploring ? k : order_[k];
+    ReaderStats const& stats = stats_[i];
+    if (pruning && stats.attempts >= MIN_ATTEMPTS_TO_DROP && stats.hitRate < DROP_HIT_RATE) {
+      continue;
+    }
+    if (!runsOn(kinds_[i], kind) || !hints_.wantsFormats(formats_[i])) {
+      continue;
+    }
+    Ref<Result> result = attempt(i, image);
+    if (!result.empty()) {
+      return result;
+    }
+  }
+  return Ref<Result>();
+}
+
+// One reader on the image, empty when it finds nothing. Timed for
+// ADAPTIVE_ORDER and the metrics alike, so the clock is read once.
+Ref<Result> MultiFormatReader::attempt(int reader, Ref<BinaryBitmap> image) {
+  hints_.checkCancelled();
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  Ref<Result> result;
+  try {
+    result = readers_[reader]->decode(image, hints_);
+  } catch (ReaderException const& re) {
+    (void)re;
+  }
+  std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+  if (hints_.getAdaptiveOrder()) {
+    FrameAttempts& frame = frameAttempts_[reader];
+    frame.tried = true;
+    frame.hit = frame.hit || !result.empty();
+    frame.cost += std::chrono::duration<float, std::micro>(elapsed).count();
+  }
+  ReaderMetrics const& metrics = metrics_[reader];
+  metrics.latency.observe(elapsed);
+  (result.empty() ? metrics.misses : metrics.hits).add();
+  return result;
+}
+
+// Stacked symbols are rows of bars, and the line between them and a tilted
+// 1D symbol is the least certain, so the 1D readers try those regions too
+bool MultiFormatReader::runsOn(RegionProposer::Kind readerKind, int kind) {
+  return kind == ANY_KIND || readerKind == kind ||
+    (kind == RegionProposer::STACKED && readerKind == RegionProposer::LINEAR);
+}
+
+void MultiFormatReader::addReader(Reader* reader, RegionProposer::Kind kind, DecodeHintType formats,
+                                  char const* name) {
+  readers_.push_back(Ref<Reader>(reader));
+  kinds_.push_back(kind);
+  formats_.push_back(formats);
+  std::string label = std::string("reader=\"") + name + "\"";
+  ReaderMetrics metrics;
+  metrics.latency = Metrics::histogram("zxing_reader_seconds", "Time per reader attempt", label);
+  metrics.hits = Metrics::counter("zxing_reader_attempts_total", "Reader attempts, by reader and outcome",
+                                  label + ",result=\"hit\"");
+  metrics.misses = Metrics::counter("zxing_reader_attempts_total", "Reader attempts, by reader and outcome",
+                                    label + ",result=\"miss\"");
+  metrics_.push_back(metrics);
+}
+
+void MultiFormatReader::record(int reader, bool hit, float cost) {
+  ReaderStats& stats = stats_[reader];
+  float sample = hit ? 1.0f : 0.0f;
+  if (stats.attempts == 0) {
+    stats.hitRate = sample;
+    stats.meanCost = cost;
+  } else {
+    stats.hitRate += SMOOTHING * (sample - stats.hitRate);
+    stats.meanCost += SMOOTHING * (cost - stats.meanCost);
+  }
+  stats.attempts++;
+}
+
+void MultiFormatReader::recordFrame() {
+  for (size_t i = 0; i < frameAttempts_.size(); i++) {
+    FrameAttempts const& frame = frameAttempts_[i];
+    if (frame.tried) {
+      record((int)i, frame.hit, frame.cost);
+    }
+  }
+  updateOrder();
+}
+
+void MultiFormatReader::updateOrder() {
+  // Untried readers go first so every reader gets measured; ties keep
+  // the fixed order chosen in setHints
+  std::vector<float> priority(readers_.size());
+  for (size_t i = 0; i < readers_.size(); i++) {
+    ReaderStats const& stats = stats_[i];
+    priority[i] = stats.attempts == 0 ? std::numeric_limits<float>::infinity()
+      : stats.hitRate / std::max(stats.meanCost, 1.0f);
+    order_[i] = (int)i;
+  }
+  std::stable_sort(order_.begin(), order_.end(), ByPriorityDescending(priority));
 }
   
 MultiFormatReader::~MultiFormatReader() {}
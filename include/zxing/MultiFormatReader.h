@@ -25,13 +25,75 @@
 #include <zxing/common/BitArray.h>
 #include <zxing/Result.h>
 #include <zxing/DecodeHints.h>
+#include <zxing/common/detector/RegionProposer.h>
+#include <zxing/common/Metrics.h>
 
 namespace zxing {
   class MultiFormatReader : public Reader {
   private:
+    // Moving averages kept per entry of readers_ for ADAPTIVE_ORDER, one
+    // sample per frame the reader ran on
+    struct ReaderStats {
+      int attempts;
+      float hitRate;
+      float meanCost; // microseconds per frame
+      ReaderStats() : attempts(0), hitRate(0), meanCost(0) {}
+    };
+
+    // What a reader did on the current frame, over every region and
+    // inverted pass it was run on
+    struct FrameAttempts {
+      bool tried;
+      bool hit;
+      float cost;
+      FrameAttempts() : tried(false), hit(false), cost(0) {}
+    };
+
+    // Kept per entry of readers_ as well, labelled with the reader's name
+    struct ReaderMetrics {
+      Metrics::Histogram latency;
+      Metrics::Counter hits;
+      Metrics::Counter misses;
+    };
+
+    // Every EXPLORATION_INTERVAL-th frame runs the readers in their fixed
+    // order with none skipped, so a change of format on the line is noticed
+    static const unsigned int EXPLORATION_INTERVAL = 32;
+    // A reader is skipped outside exploration frames once it has run on
+    // this many frames and its hit rate is below DROP_HIT_RATE, provided
+    // another is hitting
+    static const int MIN_ATTEMPTS_TO_DROP = 16;
+    static const float DROP_HIT_RATE;
+    static const float SMOOTHING;
+
+    // Passed for kind to run every reader, whatever kind of symbol it reads
+    static const int ANY_KIND = -1;
+
     Ref<Result> decodeInternal(Ref<BinaryBitmap> image);
+    Ref<Result> decodeProposals(Ref<BinaryBitmap> image, bool exploring);
+    Ref<Result> decodeImage(Ref<BinaryBitmap> image, bool exploring, int kind);
+    Ref<Result> tryReaders(Ref<BinaryBitmap> image, bool exploring, int kind);
+    Ref<Result> attempt(int reader, Ref<BinaryBitmap> image);
+    void addReader(Reader* reader, RegionProposer::Kind kind, DecodeHintType formats, char const* name);
+    static bool runsOn(RegionProposer::Kind readerKind, int kind);
+    void record(int reader, bool hit, float cost);
+    void recordFrame();
+    void updateOrder();
+    static bool sameReaders(DecodeHints const& a, DecodeHints const& b);
   
     std::vector<Ref<Reader> > readers_;
+    // The kind of region from RegionProposer each reader is run on
+    std::vector<RegionProposer::Kind> kinds_;
+    // The format hints of the symbols each reader reads
+    std::vector<DecodeHintType> formats_;
+    std::vector<ReaderStats> stats_;
+    std::vector<FrameAttempts> frameAttempts_;
+    std::vector<ReaderMetrics> metrics_;
+    std::vector<int> order_;
+    unsigned int frames_;
+    // Whether the last whole frame decoded after the proposals had all
+    // failed found a symbol they missed, so the next should be searched too
+    bool proposalsMissed_;
     DecodeHints hints_;
 
   public:
@@ -0,0 +1,38 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+
+#ifndef __TIMEOUT_EXCEPTION_H__
+#define __TIMEOUT_EXCEPTION_H__
+
+/*
+ * Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/Exception.h>
+
+namespace zxing {
+
+// Thrown when a decode runs past its CancellationToken. Deliberately not a
+// ReaderException, so the readers' "not found here, try the next thing"
+// handlers let it through.
+class TimeoutException : public Exception {
+public:
+  TimeoutException() throw() {}
+  TimeoutException(const char *msg) throw() : Exception(msg) {}
+  ~TimeoutException() throw() {}
+};
+
+}
+
+#endif // __TIMEOUT_EXCEPTION_H__
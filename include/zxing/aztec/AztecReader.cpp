@@ -22,6 +22,7 @@
 #include <zxing/aztec/AztecReader.h>
 #include <zxing/aztec/detector/Detector.h>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/Trace.h>
 #include <iostream>
 
 using zxing::Ref;
@@ -54,8 +55,10 @@ Ref<Result> AztecReader::decode(Ref<zxing::BinaryBitmap> image) {
   return result;
 }
         
-Ref<Result> AztecReader::decode(Ref<BinaryBitmap> image, DecodeHints) {
+Ref<Result> AztecReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+  ZXING_TRACE_SPAN("AztecReader::decode");
   //cout << "decoding with hints not supported for aztec" << "\n" << flush;
+  hints.checkCancelled();
   return this->decode(image);
 }
         
@@ -20,9 +20,6 @@
  */
 
 #include <zxing/aztec/decoder/Decoder.h>
-#ifndef NO_ICONV
-#include <iconv.h>
-#endif
 #include <iostream>
 #include <zxing/FormatException.h>
 #include <zxing/common/reedsolomon/ReedSolomonDecoder.h>
@@ -30,6 +27,8 @@
 #include <zxing/common/reedsolomon/GenericGF.h>
 #include <zxing/common/IllegalArgumentException.h>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/StringUtils.h>
+#include <zxing/common/Metrics.h>
 
 using zxing::aztec::Decoder;
 using zxing::DecoderResult;
@@ -37,29 +36,12 @@ using zxing::String;
 using zxing::BitArray;
 using zxing::BitMatrix;
 using zxing::Ref;
+using zxing::common::StringUtils;
+using zxing::Metrics;
 
 using std::string;
 
 namespace {
-  void add(string& result, char character) {
-#ifndef NO_ICONV
-    char character2 = character & 0xff;
-    char s[] =  {character2};
-    char* ss = s;
-    size_t sl = sizeof(s);
-    char d[4];
-    char* ds = d;
-    size_t dl = sizeof(d);
-    iconv_t ic = iconv_open("UTF-8", "ISO-8859-1");
-    iconv(ic, &ss, &sl, &ds, &dl);
-    iconv_close(ic);
-    d[sizeof(d)-dl] = 0;
-    result.append(d);
-#else
-    result.push_back(character);
-#endif
-  }
-
   const int NB_BITS_COMPACT[] = {
     0, 104, 240, 408, 608
   };
@@ -162,7 +144,12 @@ Ref<DecoderResult> Decoder::decode(Ref<zxing::aztec::AztecDetectorResult> detect
   Ref<BitArray> aCorrectedBits = correctBits(rawbits);
             
   // std::printf("decoding bits\n");
-  Ref<String> result = getEncodedData(aCorrectedBits);
+  Ref<String> result;
+  {
+    static const Metrics::Histogram parsing = Metrics::stage("parse");
+    Metrics::Timer timer(parsing);
+    result = getEncodedData(aCorrectedBits);
+  }
             
   // std::printf("constructing array\n");
   ArrayRef<char> arrayOut(aCorrectedBits->getSize());
@@ -185,6 +172,7 @@ Ref<String> Decoder::getEncodedData(Ref<zxing::BitArray> correctedBits) {
   Table lastTable = UPPER;
   Table table = UPPER;
   int startIndex = 0;
+  // Collected as ISO-8859-1 and converted to UTF-8 once at the end.
   std::string result;
   bool end = false;
   bool shift = false;
@@ -223,7 +211,7 @@ Ref<String> Decoder::getEncodedData(Ref<zxing::BitArray> correctedBits) {
         }
                         
         code = readCode(correctedBits, startIndex, 8);
-        add(result, code);
+        result.push_back((char)code);
         startIndex += 8;
       }
       binaryShift = false;
@@ -235,7 +223,7 @@ Ref<String> Decoder::getEncodedData(Ref<zxing::BitArray> correctedBits) {
         code = readCode(correctedBits, startIndex, 8);
         startIndex += 8;
                         
-        add(result, code);
+        result.push_back((char)code);
       } else {
         int size = 5;
                         
@@ -277,7 +265,9 @@ Ref<String> Decoder::getEncodedData(Ref<zxing::BitArray> correctedBits) {
                 
   }
             
-  return Ref<String>(new String(result));
+  std::string text;
+  StringUtils::append(text, result.data(), result.size(), StringUtils::ISO88591);
+  return Ref<String>(new String(text));
             
 }
         
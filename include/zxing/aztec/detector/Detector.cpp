@@ -28,6 +28,7 @@
 #include <iostream>
 #include <zxing/common/detector/MathUtils.h>
 #include <zxing/NotFoundException.h>
+#include <zxing/common/Trace.h>
 
 using std::vector;
 using zxing::aztec::Detector;
@@ -49,6 +50,7 @@ Detector::Detector(Ref<BitMatrix> image):
 }
         
 Ref<AztecDetectorResult> Detector::detect() {
+  ZXING_TRACE_SPAN("aztec::Detector::detect");
   Ref<Point> pCenter = getMatrixCenter();
             
   std::vector<Ref<Point> > bullEyeCornerPoints = getBullEyeCornerPoints(pCenter);
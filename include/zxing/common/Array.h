@@ -24,6 +24,7 @@
 #include <vector>
 
 #include <zxing/common/Counted.h>
+#include <zxing/common/Metrics.h>
 
 namespace zxing {
 
@@ -34,24 +35,31 @@ public:
   Array() {}
   Array(int n) :
       Counted(), values_(n, T()) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   Array(T const* ts, int n) :
       Counted(), values_(ts, ts+n) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   Array(T const* ts, T const* te) :
       Counted(), values_(ts, te) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   Array(T v, int n) :
       Counted(), values_(n, v) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   Array(std::vector<T> &v) :
       Counted(), values_(v) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   Array(Array<T> &other) :
       Counted(), values_(other.values_) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   Array(Array<T> *other) :
       Counted(), values_(other->values_) {
+    Metrics::allocated(values_.size() * sizeof(T));
   }
   virtual ~Array() {
   }
@@ -18,6 +18,7 @@
 #include <zxing/common/BitMatrix.h>
 #include <zxing/common/IllegalArgumentException.h>
 
+#include <algorithm>
 #include <iostream>
 #include <sstream>
 #include <string>
@@ -55,6 +56,19 @@ void BitMatrix::flip(int x, int y) {
   bits[offset] ^= 1 << (x & bitsMask);
 }
 
+void BitMatrix::flip() {
+  // Whole words at a time; the padding bits past the width have to stay clear
+  int lastBits = width & bitsMask;
+  int lastMask = lastBits == 0 ? -1 : (1 << lastBits) - 1;
+  for (int y = 0; y < height; y++) {
+    int offset = y * rowSize;
+    for (int x = 0; x < rowSize - 1; x++) {
+      bits[offset + x] = ~bits[offset + x];
+    }
+    bits[offset + rowSize - 1] = ~bits[offset + rowSize - 1] & lastMask;
+  }
+}
+
 void BitMatrix::setRegion(int left, int top, int width, int height) {
   if (top < 0 || left < 0) {
     throw IllegalArgumentException("Left and top must be nonnegative");
@@ -86,6 +100,106 @@ Ref<BitArray> BitMatrix::getRow(int y, Ref<BitArray> row) {
   return row;
 }
 
+Ref<BitMatrix> BitMatrix::crop(int left, int top, int width, int height) const {
+  if (left < 0 || top < 0 || left + width > this->width || top + height > this->height) {
+    throw IllegalArgumentException("The region must fit inside the matrix");
+  }
+  Ref<BitMatrix> result(new BitMatrix(width, height));
+  int shift = left & bitsMask;
+  for (int y = 0; y < height; y++) {
+    int offset = (top + y) * rowSize + (left >> logBits);
+    int rowEnd = (top + y + 1) * rowSize;
+    for (int x = 0; x < result->rowSize; x++) {
+      unsigned int value = (unsigned int) bits[offset + x] >> shift;
+      if (shift != 0 && offset + x + 1 < rowEnd) {
+        value |= (unsigned int) bits[offset + x + 1] << (bitsPerWord - shift);
+      }
+      result->bits[y * result->rowSize + x] = (int) value;
+    }
+    // Clear the bits to the right of the region in the last word
+    int lastBits = width & bitsMask;
+    if (lastBits != 0) {
+      result->bits[(y + 1) * result->rowSize - 1] &= (1 << lastBits) - 1;
+    }
+  }
+  return result;
+}
+
+Ref<BitMatrix> BitMatrix::window(int left, int top, int width, int height, int margin) const {
+  Ref<BitMatrix> result(new BitMatrix(width + 2 * margin, height + 2 * margin));
+  // Part of the region that lies within this matrix
+  int fromX = std::max(left, 0);
+  int toX = std::min(left + width, this->width);
+  int fromY = std::max(top, 0);
+  int toY = std::min(top + height, this->height);
+  for (int y = fromY; y < toY; y++) {
+    int rowStart = y * rowSize;
+    int resultRowStart = (y - top + margin) * result->rowSize;
+    for (int x = fromX; x < toX; x += bitsPerWord) {
+      // Up to one word of this row starting at x, moved to its place in the result row
+      int word = x >> logBits;
+      int shift = x & bitsMask;
+      unsigned int value = (unsigned int) bits[rowStart + word] >> shift;
+      if (shift != 0 && word + 1 < rowSize) {
+        value |= (unsigned int) bits[rowStart + word + 1] << (bitsPerWord - shift);
+      }
+      int count = toX - x;
+      if (count < bitsPerWord) {
+        value &= (1u << count) - 1;
+      }
+      int resultX = x - left + margin;
+      int resultWord = resultRowStart + (resultX >> logBits);
+      int resultShift = resultX & bitsMask;
+      result->bits[resultWord] |= (int) (value << resultShift);
+      if (resultShift != 0 && (resultX >> logBits) + 1 < result->rowSize) {
+        result->bits[resultWord + 1] |= (int) (value >> (bitsPerWord - resultShift));
+      }
+    }
+  }
+  return result;
+}
+
+namespace {
+
+// Transposes a 32x32 block of bits in place, bit j of word i trading places with bit i of
+// word j. Swaps ever smaller off-diagonal sub-blocks, see Hacker's Delight 7-3.
+void transpose32(unsigned int a[32]) {
+  unsigned int m = 0x0000FFFF;
+  for (int j = 16; j != 0; j >>= 1, m ^= m << j) {
+    for (int k = 0; k < 32; k = (k + j + 1) & ~j) {
+      unsigned int t = ((a[k] >> j) ^ a[k + j]) & m;
+      a[k] ^= t << j;
+      a[k + j] ^= t;
+    }
+  }
+}
+
+}
+
+Ref<BitMatrix> BitMatrix::rotateCounterClockwise() const {
+  // Row y of the result is column width - 1 - y of this matrix, read top to bottom. Columns
+  // are gathered a 32x32 block at a time, so every word is read and written once.
+  Ref<BitMatrix> result(new BitMatrix(height, width));
+  unsigned int block[32];
+  for (int top = 0; top < height; top += 32) {
+    int rows = height - top < 32 ? height - top : 32;
+    for (int word = 0; word < rowSize; word++) {
+      for (int i = 0; i < 32; i++) {
+        block[i] = i < rows ? (unsigned int) bits[(top + i) * rowSize + word] : 0;
+      }
+      transpose32(block);
+      for (int j = 0; j < 32; j++) {
+        int x = (word << logBits) + j;
+        if (x >= width) {
+          break;
+        }
+        result->bits[(width - 1 - x) * result->rowSize + (top >> logBits)] = (int) block[j];
+      }
+    }
+  }
+  return result;
+}
+
 int BitMatrix::getWidth() const {
   return width;
 }
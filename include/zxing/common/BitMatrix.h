@@ -66,9 +66,15 @@ public:
   }
 
   void flip(int x, int y);
+  void flip();
   void clear();
   void setRegion(int left, int top, int width, int height);
   Ref<BitArray> getRow(int y, Ref<BitArray> row);
+  Ref<BitMatrix> crop(int left, int top, int width, int height) const;
+  // Like crop, but the region may reach past the edges of the matrix and is surrounded by a
+  // white border margin pixels wide. Whatever lies outside the matrix reads as white.
+  Ref<BitMatrix> window(int left, int top, int width, int height, int margin) const;
+  Ref<BitMatrix> rotateCounterClockwise() const;
 
   int getWidth() const;
   int getHeight() const;
@@ -0,0 +1,330 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  CameraLuminanceSource.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/CameraLuminanceSource.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/common/Metrics.h>
+#include <algorithm>
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZXING_CAMERA_SOURCE_SSE2
+#endif
+#if defined(ZXING_CAMERA_SOURCE_SSE2) && (defined(__SSSE3__) || defined(__AVX__))
+#include <tmmintrin.h>
+#define ZXING_CAMERA_SOURCE_SSSE3
+#endif
+
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::LuminanceSource;
+using zxing::CameraLuminanceSource;
+using zxing::Metrics;
+
+// VC++
+using zxing::IllegalArgumentException;
+
+namespace {
+
+// ITU-R BT.601 weights in 1/256ths
+const int RED_WEIGHT = 77;
+const int GREEN_WEIGHT = 150;
+const int BLUE_WEIGHT = 29;
+
+inline int average(int a, int b) {
+  return (a + b + 1) >> 1;
+}
+
+// Each output pixel is the mean of the 2x2 block at its top left, which
+// holds one pixel of each color whatever the Bayer phase. The last column
+// and row use the block to their left and above.
+void bayerLuma(unsigned char const* row, unsigned char const* next, int left, int width, int dataWidth,
+               char* out) {
+  int x = 0;
+#ifdef ZXING_CAMERA_SOURCE_SSE2
+  for (; x + 16 <= width && left + x + 16 < dataWidth; x += 16) {
+    int dx = left + x;
+    __m128i top = _mm_avg_epu8(_mm_loadu_si128((__m128i const*) (row + dx)),
+                               _mm_loadu_si128((__m128i const*) (row + dx + 1)));
+    __m128i bottom = _mm_avg_epu8(_mm_loadu_si128((__m128i const*) (next + dx)),
+                                  _mm_loadu_si128((__m128i const*) (next + dx + 1)));
+    _mm_storeu_si128((__m128i*) (out + x), _mm_avg_epu8(top, bottom));
+  }
+#endif
+  for (; x < width; x++) {
+    int dx = left + x;
+    if (dx + 1 >= dataWidth) {
+      dx = dataWidth > 1 ? dataWidth - 2 : 0;
+    }
+    int dx1 = dataWidth > 1 ? dx + 1 : dx;
+    out[x] = (char) average(average(row[dx], row[dx1]), average(next[dx], next[dx1]));
+  }
+}
+
+// Green pixels are kept; red and blue ones take the mean of the green
+// pixels on either side of them
+void bayerGreen(unsigned char const* row, int dy, int greenPhase, int left, int width, int dataWidth,
+                char* out) {
+  int x = 0;
+  // The first pixel of the row has no left neighbour
+  for (; x < width && left + x == 0; x++) {
+    out[x] = (char) (((dy & 1) == greenPhase || dataWidth == 1) ? row[0] : row[1]);
+  }
+#ifdef ZXING_CAMERA_SOURCE_SSE2
+  if (x < width) {
+    // Lanes alternate between green and not; x only moves in steps of 16
+    bool firstGreen = ((left + x + dy) & 1) == greenPhase;
+    __m128i green = firstGreen ? _mm_set1_epi16(0x00FF) : _mm_set1_epi16((short) 0xFF00);
+    for (; x + 16 <= width && left + x + 16 < dataWidth; x += 16) {
+      int dx = left + x;
+      __m128i pixels = _mm_loadu_si128((__m128i const*) (row + dx));
+      __m128i sides = _mm_avg_epu8(_mm_loadu_si128((__m128i const*) (row + dx - 1)),
+                                   _mm_loadu_si128((__m128i const*) (row + dx + 1)));
+      __m128i result = _mm_or_si128(_mm_and_si128(green, pixels), _mm_andnot_si128(green, sides));
+      _mm_storeu_si128((__m128i*) (out + x), result);
+    }
+  }
+#endif
+  for (; x < width; x++) {
+    int dx = left + x;
+    if (((dx + dy) & 1) == greenPhase) {
+      out[x] = (char) row[dx];
+    } else if (dx + 1 < dataWidth) {
+      out[x] = (char) average(row[dx - 1], row[dx + 1]);
+    } else {
+      out[x] = (char) row[dx - 1];
+    }
+  }
+}
+
+#ifdef ZXING_CAMERA_SOURCE_SSSE3
+// Gathers byte 3 * i + channel of 48 bytes into lane i
+class ChannelShuffle {
+private:
+  __m128i masks_[3];
+public:
+  ChannelShuffle(int channel) {
+    for (int part = 0; part < 3; part++) {
+      char mask[16];
+      for (int i = 0; i < 16; i++) {
+        int index = 3 * i + channel - 16 * part;
+        mask[i] = (char) (index >= 0 && index < 16 ? index : 0x80);
+      }
+      masks_[part] = _mm_loadu_si128((__m128i const*) mask);
+    }
+  }
+  __m128i gather(__m128i a, __m128i b, __m128i c) const {
+    return _mm_or_si128(_mm_or_si128(_mm_shuffle_epi8(a, masks_[0]), _mm_shuffle_epi8(b, masks_[1])),
+                        _mm_shuffle_epi8(c, masks_[2]));
+  }
+};
+
+__m128i weigh(__m128i bytes, __m128i zero, __m128i weight, bool high) {
+  __m128i words = high ? _mm_unpackhi_epi8(bytes, zero) : _mm_unpacklo_epi8(bytes, zero);
+  return _mm_mullo_epi16(words, weight);
+}
+#endif
+
+// redOffset is 0 for RGB and 2 for BGR
+void rgbLuma(unsigned char const* row, int redOffset, int left, int width, char* out) {
+  int blueOffset = 2 - redOffset;
+  int x = 0;
+  unsigned char const* pixels = row + 3 * left;
+#ifdef ZXING_CAMERA_SOURCE_SSSE3
+  static const ChannelShuffle channels[3] = {ChannelShuffle(0), ChannelShuffle(1), ChannelShuffle(2)};
+  __m128i zero = _mm_setzero_si128();
+  __m128i redWeight = _mm_set1_epi16(RED_WEIGHT);
+  __m128i greenWeight = _mm_set1_epi16(GREEN_WEIGHT);
+  __m128i blueWeight = _mm_set1_epi16(BLUE_WEIGHT);
+  for (; x + 16 <= width; x += 16) {
+    __m128i a = _mm_loadu_si128((__m128i const*) (pixels + 3 * x));
+    __m128i b = _mm_loadu_si128((__m128i const*) (pixels + 3 * x + 16));
+    __m128i c = _mm_loadu_si128((__m128i const*) (pixels + 3 * x + 32));
+    __m128i red = channels[redOffset].gather(a, b, c);
+    __m128i green = channels[1].gather(a, b, c);
+    __m128i blue = channels[blueOffset].gather(a, b, c);
+    // The weights sum to 256, so the sums fit in unsigned 16 bits
+    __m128i low = _mm_add_epi16(_mm_add_epi16(weigh(red, zero, redWeight, false),
+                                              weigh(green, zero, greenWeight, false)),
+                                weigh(blue, zero, blueWeight, false));
+    __m128i high = _mm_add_epi16(_mm_add_epi16(weigh(red, zero, redWeight, true),
+                                               weigh(green, zero, greenWeight, true)),
+                                 weigh(blue, zero, blueWeight, true));
+    __m128i luma = _mm_packus_epi16(_mm_srli_epi16(low, 8), _mm_srli_epi16(high, 8));
+    _mm_storeu_si128((__m128i*) (out + x), luma);
+  }
+#endif
+  for (; x < width; x++) {
+    unsigned char const* pixel = pixels + 3 * x;
+    out[x] = (char) ((RED_WEIGHT * pixel[redOffset] + GREEN_WEIGHT * pixel[1] +
+                      BLUE_WEIGHT * pixel[blueOffset]) >> 8);
+  }
+}
+
+void rgbGreen(unsigned char const* row, int left, int width, char* out) {
+  int x = 0;
+  unsigned char const* pixels = row + 3 * left;
+#ifdef ZXING_CAMERA_SOURCE_SSSE3
+  static const ChannelShuffle green(1);
+  for (; x + 16 <= width; x += 16) {
+    __m128i a = _mm_loadu_si128((__m128i const*) (pixels + 3 * x));
+    __m128i b = _mm_loadu_si128((__m128i const*) (pixels + 3 * x + 16));
+    __m128i c = _mm_loadu_si128((__m128i const*) (pixels + 3 * x + 32));
+    _mm_storeu_si128((__m128i*) (out + x), green.gather(a, b, c));
+  }
+#endif
+  for (; x < width; x++) {
+    out[x] = (char) pixels[3 * x + 1];
+  }
+}
+
+// lumaOffset is 0 for YUYV and 1 for UYVY
+void yuvLuma(unsigned char const* row, int lumaOffset, int left, int width, char* out) {
+  int x = 0;
+  unsigned char const* pixels = row + 2 * left;
+#ifdef ZXING_CAMERA_SOURCE_SSE2
+  __m128i lowBytes = _mm_set1_epi16(0x00FF);
+  for (; x + 16 <= width; x += 16) {
+    __m128i a = _mm_loadu_si128((__m128i const*) (pixels + 2 * x));
+    __m128i b = _mm_loadu_si128((__m128i const*) (pixels + 2 * x + 16));
+    if (lumaOffset == 0) {
+      a = _mm_and_si128(a, lowBytes);
+      b = _mm_and_si128(b, lowBytes);
+    } else {
+      a = _mm_srli_epi16(a, 8);
+      b = _mm_srli_epi16(b, 8);
+    }
+    _mm_storeu_si128((__m128i*) (out + x), _mm_packus_epi16(a, b));
+  }
+#endif
+  for (; x < width; x++) {
+    out[x] = (char) pixels[2 * x + lumaOffset];
+  }
+}
+
+}
+
+int CameraLuminanceSource::bytesPerPixel(PixelFormat format) {
+  switch (format) {
+    case RGB8:
+    case BGR8:
+      return 3;
+    case YUV422_YUYV:
+    case YUV422_UYVY:
+      return 2;
+    default:
+      return 1;
+  }
+}
+
+CameraLuminanceSource::CameraLuminanceSource(void const* data, int dataWidth, int dataHeight, int rowBytes,
+                                             PixelFormat format, Channel channel)
+    : Super(dataWidth, dataHeight),
+      data_((unsigned char const*) data),
+      dataWidth_(dataWidth), dataHeight_(dataHeight), rowBytes_(rowBytes),
+      left_(0), top_(0),
+      format_(format), channel_(channel) {
+  if (rowBytes < dataWidth * bytesPerPixel(format)) {
+    throw IllegalArgumentException("Rows are shorter than the image is wide.");
+  }
+}
+
+CameraLuminanceSource::CameraLuminanceSource(void const* data, int dataWidth, int dataHeight, int rowBytes,
+                                             PixelFormat format, Channel channel,
+                                             int left, int top, int width, int height)
+    : Super(width, height),
+      data_((unsigned char const*) data),
+      dataWidth_(dataWidth), dataHeight_(dataHeight), rowBytes_(rowBytes),
+      left_(left), top_(top),
+      format_(format), channel_(channel) {
+  if (rowBytes < dataWidth * bytesPerPixel(format)) {
+    throw IllegalArgumentException("Rows are shorter than the image is wide.");
+  }
+  if (left + width > dataWidth || top + height > dataHeight || top < 0 || left < 0) {
+    throw IllegalArgumentException("Crop rectangle does not fit within image data.");
+  }
+}
+
+void CameraLuminanceSource::convertRow(int y, char* row) const {
+  int dy = top_ + y;
+  unsigned char const* pixels = data_ + (size_t) dy * rowBytes_;
+  int width = getWidth();
+  switch (format_) {
+    case MONO8:
+      memcpy(row, pixels + left_, width);
+      break;
+    case BAYER_RG8:
+    case BAYER_BG8:
+    case BAYER_GR8:
+    case BAYER_GB8:
+      if (channel_ == GREEN) {
+        int greenPhase = (format_ == BAYER_RG8 || format_ == BAYER_BG8) ? 1 : 0;
+        bayerGreen(pixels, dy, greenPhase, left_, width, dataWidth_, row);
+      } else {
+        int next = dy + 1 < dataHeight_ ? dy + 1 : (dy > 0 ? dy - 1 : dy);
+        bayerLuma(pixels, data_ + (size_t) next * rowBytes_, left_, width, dataWidth_, row);
+      }
+      break;
+    case RGB8:
+    case BGR8:
+      if (channel_ == GREEN) {
+        rgbGreen(pixels, left_, width, row);
+      } else {
+        rgbLuma(pixels, format_ == RGB8 ? 0 : 2, left_, width, row);
+      }
+      break;
+    case YUV422_YUYV:
+    case YUV422_UYVY:
+      // Y is luminance already, and mostly green
+      yuvLuma(pixels, format_ == YUV422_YUYV ? 0 : 1, left_, width, row);
+      break;
+  }
+}
+
+ArrayRef<char> CameraLuminanceSource::getRow(int y, ArrayRef<char> row) const {
+  if (y < 0 || y >= getHeight()) {
+    throw IllegalArgumentException("Requested row is outside the image.");
+  }
+  int width = getWidth();
+  if (!row || row->size() < width) {
+    row = ArrayRef<char>(width);
+  }
+  convertRow(y, &row[0]);
+  return row;
+}
+
+ArrayRef<char> CameraLuminanceSource::getMatrix() const {
+  static const Metrics::Histogram latency = Metrics::stage("convert");
+  Metrics::Timer timer(latency);
+  int width = getWidth();
+  int height = getHeight();
+  ArrayRef<char> matrix(width * height);
+  for (int y = 0; y < height; y++) {
+    convertRow(y, &matrix[y * width]);
+  }
+  return matrix;
+}
+
+Ref<LuminanceSource> CameraLuminanceSource::crop(int left, int top, int width, int height) const {
+  return Ref<LuminanceSource>(new CameraLuminanceSource(data_, dataWidth_, dataHeight_, rowBytes_,
+                                                        format_, channel_,
+                                                        left_ + left, top_ + top, width, height));
+}
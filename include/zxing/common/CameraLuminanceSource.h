@@ -0,0 +1,100 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __CAMERA_LUMINANCE_SOURCE_H__
+#define __CAMERA_LUMINANCE_SOURCE_H__
+/*
+ *  CameraLuminanceSource.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/LuminanceSource.h>
+
+namespace zxing {
+
+/**
+ * Reads luminance straight out of a camera's frame buffer, so that color
+ * frames need not be converted to a separate 8 bit greyscale image first.
+ * getRow() converts just the row asked for, so a stage that samples a few
+ * rows converts only those; getMatrix() converts the whole frame into the
+ * array it returns. Nothing converted is kept by the source.
+ *
+ * The buffer is not copied and must outlive the source and anything cropped
+ * from it.
+ */
+class CameraLuminanceSource : public LuminanceSource {
+public:
+  enum PixelFormat {
+    MONO8,
+    // Bayer formats are named by the colors of the first two pixels of the first row
+    BAYER_RG8,
+    BAYER_BG8,
+    BAYER_GR8,
+    BAYER_GB8,
+    RGB8,
+    BGR8,
+    // Y0 U Y1 V
+    YUV422_YUYV,
+    // U Y0 V Y1
+    YUV422_UYVY
+  };
+
+  enum Channel {
+    // Weighted sum of the colors. For Bayer formats every 2x2 block holds one
+    // red, two green and one blue pixel, and their average is used.
+    LUMA,
+    // Green alone, at the cost of a little contrast on red and blue prints.
+    // For Bayer formats the other pixels take the mean of their green
+    // neighbours in the same row.
+    GREEN
+  };
+
+  static int bytesPerPixel(PixelFormat format);
+
+private:
+  typedef LuminanceSource Super;
+
+  unsigned char const* data_;
+  const int dataWidth_;
+  const int dataHeight_;
+  const int rowBytes_;
+  const int left_;
+  const int top_;
+  const PixelFormat format_;
+  const Channel channel_;
+
+  void convertRow(int y, char* row) const;
+
+public:
+  // rowBytes is the distance between rows, padding included
+  CameraLuminanceSource(void const* data, int dataWidth, int dataHeight, int rowBytes,
+                        PixelFormat format, Channel channel = LUMA);
+  CameraLuminanceSource(void const* data, int dataWidth, int dataHeight, int rowBytes,
+                        PixelFormat format, Channel channel,
+                        int left, int top, int width, int height);
+
+  ArrayRef<char> getRow(int y, ArrayRef<char> row) const;
+  ArrayRef<char> getMatrix() const;
+
+  bool isCropSupported() const {
+    return true;
+  }
+
+  Ref<LuminanceSource> crop(int left, int top, int width, int height) const;
+};
+
+}
+
+#endif // __CAMERA_LUMINANCE_SOURCE_H__
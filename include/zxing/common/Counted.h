@@ -19,27 +19,36 @@
  */
 
 #include <iostream>
+#include <atomic>
 
 namespace zxing {
 
 /* base class for reference-counted objects */
 class Counted {
 private:
-  unsigned int count_;
+  // Atomic so that objects shared between decoding threads (the Galois fields, cached
+  // matrices) can be retained and released concurrently
+  std::atomic<unsigned int> count_;
 public:
   Counted() :
       count_(0) {
   }
+  // A copy is a new object, nobody holds a reference to it yet
+  Counted(const Counted &) :
+      count_(0) {
+  }
+  Counted &operator=(const Counted &) {
+    return *this;
+  }
   virtual ~Counted() {
   }
   Counted *retain() {
-    count_++;
+    count_.fetch_add(1, std::memory_order_relaxed);
     return this;
   }
   void release() {
-    count_--;
-    if (count_ == 0) {
-      count_ = 0xDEADF001;
+    if (count_.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+      count_.store(0xDEADF001, std::memory_order_relaxed);
       delete this;
     }
   }
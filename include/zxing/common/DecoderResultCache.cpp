@@ -0,0 +1,112 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  DecoderResultCache.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/DecoderResultCache.h>
+
+using std::string;
+using zxing::DecoderResultCache;
+using zxing::DecoderResult;
+using zxing::Ref;
+
+// VC++
+using zxing::ArrayRef;
+
+DecoderResultCache::DecoderResultCache(size_t capacity)
+  : capacity_(capacity), hits_(0), misses_(0) {
+}
+
+string DecoderResultCache::makeKey(int version, int discriminator, ArrayRef<char> codewords) {
+  string key;
+  key.reserve(2 + codewords->size());
+  key.push_back((char)version);
+  key.push_back((char)discriminator);
+  if (codewords->size() > 0) {
+    key.append(&codewords[0], codewords->size());
+  }
+  return key;
+}
+
+Ref<DecoderResult> DecoderResultCache::get(string const& key) {
+  if (capacity_ == 0) {
+    return Ref<DecoderResult>();
+  }
+  std::unordered_map<string, std::list<Entry>::iterator>::iterator i = index_.find(key);
+  if (i == index_.end()) {
+    misses_++;
+    return Ref<DecoderResult>();
+  }
+  hits_++;
+  // Move to the front: most recently used.
+  entries_.splice(entries_.begin(), entries_, i->second);
+  return i->second->second;
+}
+
+void DecoderResultCache::put(string const& key, Ref<DecoderResult> result) {
+  if (capacity_ == 0) {
+    return;
+  }
+  std::unordered_map<string, std::list<Entry>::iterator>::iterator i = index_.find(key);
+  if (i != index_.end()) {
+    i->second->second = result;
+    entries_.splice(entries_.begin(), entries_, i->second);
+    return;
+  }
+  entries_.push_front(Entry(key, result));
+  index_[key] = entries_.begin();
+  evict();
+}
+
+void DecoderResultCache::evict() {
+  while (entries_.size() > capacity_) {
+    index_.erase(entries_.back().first);
+    entries_.pop_back();
+  }
+}
+
+void DecoderResultCache::clear() {
+  entries_.clear();
+  index_.clear();
+}
+
+void DecoderResultCache::setCapacity(size_t capacity) {
+  capacity_ = capacity;
+  evict();
+}
+
+size_t DecoderResultCache::getCapacity() const {
+  return capacity_;
+}
+
+size_t DecoderResultCache::size() const {
+  return entries_.size();
+}
+
+unsigned long DecoderResultCache::getHits() const {
+  return hits_;
+}
+
+unsigned long DecoderResultCache::getMisses() const {
+  return misses_;
+}
+
+void DecoderResultCache::resetCounters() {
+  hits_ = 0;
+  misses_ = 0;
+}
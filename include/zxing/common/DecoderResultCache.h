@@ -0,0 +1,79 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __DECODER_RESULT_CACHE_H__
+#define __DECODER_RESULT_CACHE_H__
+
+/*
+ *  DecoderResultCache.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+#include <zxing/common/Array.h>
+#include <zxing/common/DecoderResult.h>
+#include <string>
+#include <list>
+#include <utility>
+#include <unordered_map>
+
+namespace zxing {
+
+/**
+ * Small LRU map from raw (uncorrected) codewords to the DecoderResult they
+ * decoded to. A label that stays in view samples to the same codewords
+ * frame after frame, so a hit skips error correction and bitstream parsing.
+ * Only successful decodes are stored. Not thread safe; each decoder owns
+ * its own cache.
+ */
+class DecoderResultCache {
+private:
+  typedef std::pair<std::string, Ref<DecoderResult> > Entry;
+
+  std::list<Entry> entries_;
+  std::unordered_map<std::string, std::list<Entry>::iterator> index_;
+  size_t capacity_;
+  unsigned long hits_;
+  unsigned long misses_;
+
+  void evict();
+
+public:
+  static const size_t DEFAULT_CAPACITY = 16;
+
+  DecoderResultCache(size_t capacity = DEFAULT_CAPACITY);
+
+  // Builds a key from a symbol's version, a format-specific discriminator
+  // (e.g. the QR error correction level) and its raw codewords.
+  static std::string makeKey(int version, int discriminator, ArrayRef<char> codewords);
+
+  // Returns the cached result for key, or a null Ref on a miss.
+  Ref<DecoderResult> get(std::string const& key);
+  void put(std::string const& key, Ref<DecoderResult> result);
+  void clear();
+
+  // 0 disables the cache.
+  void setCapacity(size_t capacity);
+  size_t getCapacity() const;
+  size_t size() const;
+
+  unsigned long getHits() const;
+  unsigned long getMisses() const;
+  void resetCounters();
+};
+
+}
+
+#endif // __DECODER_RESULT_CACHE_H__
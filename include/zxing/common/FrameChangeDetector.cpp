@@ -0,0 +1,164 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  FrameChangeDetector.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/FrameChangeDetector.h>
+#include <zxing/common/BitMatrix.h>
+#include <zxing/common/detector/ConnectedComponents.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <algorithm>
+#include <stdlib.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZXING_FRAME_CHANGE_SSE2
+#endif
+
+using std::vector;
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::BitMatrix;
+using zxing::LuminanceSource;
+using zxing::DecodeHints;
+using zxing::ConnectedComponents;
+using zxing::FrameChangeDetector;
+
+// VC++
+using zxing::IllegalArgumentException;
+
+namespace {
+
+int sumOfAbsoluteDifferences(unsigned char const* a, unsigned char const* b, int count) {
+  int sum = 0;
+  int i = 0;
+#ifdef ZXING_FRAME_CHANGE_SSE2
+  __m128i sums = _mm_setzero_si128();
+  for (; i + 16 <= count; i += 16) {
+    sums = _mm_add_epi64(sums, _mm_sad_epu8(_mm_loadu_si128((__m128i const*) (a + i)),
+                                            _mm_loadu_si128((__m128i const*) (b + i))));
+  }
+  // One partial sum in each 64 bit half
+  sum = _mm_cvtsi128_si32(sums) + _mm_cvtsi128_si32(_mm_srli_si128(sums, 8));
+#endif
+  for (; i < count; i++) {
+    sum += abs((int) a[i] - (int) b[i]);
+  }
+  return sum;
+}
+
+}
+
+FrameChangeDetector::FrameChangeDetector(int tileSize, int subsample, int threshold, float maxChangedFraction)
+    : tileSize_(tileSize), subsample_(subsample), threshold_(threshold),
+      maxChangedFraction_(maxChangedFraction),
+      width_(0), height_(0), samplesX_(0), samplesY_(0), hasReference_(false), hasPending_(false) {
+  if (subsample < 1 || tileSize < subsample) {
+    throw IllegalArgumentException("Tiles must hold at least one sample.");
+  }
+}
+
+void FrameChangeDetector::sample(Ref<LuminanceSource> frame) {
+  width_ = frame->getWidth();
+  height_ = frame->getHeight();
+  samplesX_ = (width_ + subsample_ - 1) / subsample_;
+  samplesY_ = (height_ + subsample_ - 1) / subsample_;
+  pending_.resize(samplesX_ * samplesY_);
+  ArrayRef<char> row;
+  for (int sy = 0; sy < samplesY_; sy++) {
+    row = frame->getRow(sy * subsample_, row);
+    unsigned char* samples = &pending_[sy * samplesX_];
+    for (int sx = 0; sx < samplesX_; sx++) {
+      samples[sx] = (unsigned char) row[sx * subsample_];
+    }
+  }
+}
+
+FrameChangeDetector::Change FrameChangeDetector::compare(Ref<LuminanceSource> frame,
+                                                         vector<DecodeHints::Region>& changed) {
+  changed.clear();
+  int oldWidth = width_;
+  int oldHeight = height_;
+  sample(frame);
+  hasPending_ = true;
+  if (!hasReference_ || width_ != oldWidth || height_ != oldHeight) {
+    hasReference_ = false;
+    return FULL;
+  }
+
+  // Tiles are whole numbers of samples
+  int tileSamples = tileSize_ / subsample_;
+  int tilesX = (samplesX_ + tileSamples - 1) / tileSamples;
+  int tilesY = (samplesY_ + tileSamples - 1) / tileSamples;
+  vector<int> sums(tilesX * tilesY);
+  for (int sy = 0; sy < samplesY_; sy++) {
+    unsigned char const* current = &pending_[sy * samplesX_];
+    unsigned char const* reference = &reference_[sy * samplesX_];
+    int* tileRow = &sums[(sy / tileSamples) * tilesX];
+    for (int tx = 0; tx < tilesX; tx++) {
+      int start = tx * tileSamples;
+      int count = std::min(tileSamples, samplesX_ - start);
+      tileRow[tx] += sumOfAbsoluteDifferences(current + start, reference + start, count);
+    }
+  }
+
+  Ref<BitMatrix> tiles(new BitMatrix(tilesX, tilesY));
+  int changedTiles = 0;
+  for (int ty = 0; ty < tilesY; ty++) {
+    int rows = std::min(tileSamples, samplesY_ - ty * tileSamples);
+    for (int tx = 0; tx < tilesX; tx++) {
+      int columns = std::min(tileSamples, samplesX_ - tx * tileSamples);
+      if (sums[ty * tilesX + tx] > threshold_ * rows * columns) {
+        tiles->set(tx, ty);
+        changedTiles++;
+      }
+    }
+  }
+  if (changedTiles == 0) {
+    return UNCHANGED;
+  }
+  if (changedTiles > maxChangedFraction_ * tilesX * tilesY) {
+    return FULL;
+  }
+
+  int tilePixels = tileSamples * subsample_;
+  vector<ConnectedComponents::Component> components = ConnectedComponents::find(tiles, 1);
+  for (size_t i = 0; i < components.size(); i++) {
+    ConnectedComponents::Component const& component = components[i];
+    int left = std::max(0, (component.left - 1) * tilePixels);
+    int top = std::max(0, (component.top - 1) * tilePixels);
+    int right = std::min(width_, (component.right + 1) * tilePixels);
+    int bottom = std::min(height_, (component.bottom + 1) * tilePixels);
+    changed.push_back(DecodeHints::Region(left, top, right - left, bottom - top));
+  }
+  return PARTIAL;
+}
+
+void FrameChangeDetector::accept() {
+  if (!hasPending_) {
+    return;
+  }
+  reference_.swap(pending_);
+  hasReference_ = true;
+  hasPending_ = false;
+}
+
+void FrameChangeDetector::reset() {
+  hasReference_ = false;
+  hasPending_ = false;
+}
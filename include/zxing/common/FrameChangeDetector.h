@@ -0,0 +1,83 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __FRAME_CHANGE_DETECTOR_H__
+#define __FRAME_CHANGE_DETECTOR_H__
+/*
+ *  FrameChangeDetector.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/LuminanceSource.h>
+#include <zxing/DecodeHints.h>
+#include <vector>
+
+namespace zxing {
+
+/**
+ * Tells which parts of a video frame differ from the last frame that was
+ * decoded. Frames are compared on a subsampled copy: every subsample-th
+ * pixel of every subsample-th row. A tile has changed when the mean absolute
+ * difference of its samples exceeds the threshold, in grey levels.
+ *
+ * compare() leaves the frame pending; accept() makes it the reference for
+ * the frames after it, and should be called once the frame was decoded. A
+ * scene that drifts slowly is thus caught once it has drifted far enough.
+ * accept() does nothing unless a frame is pending, so calling it twice, or
+ * before any compare(), keeps the reference it has.
+ */
+class FrameChangeDetector : public Counted {
+public:
+  enum Change {
+    UNCHANGED,
+    // Some tiles changed; their regions are returned
+    PARTIAL,
+    // Too much of the frame changed to be worth searching piece by piece,
+    // or there is no reference yet
+    FULL
+  };
+
+  FrameChangeDetector(int tileSize = 64, int subsample = 4, int threshold = 6,
+                      float maxChangedFraction = 0.5f);
+
+  // Changed regions have a margin of one tile and are clipped to the frame
+  Change compare(Ref<LuminanceSource> frame, std::vector<DecodeHints::Region>& changed);
+  void accept();
+  // Forgets the reference, so the next frame compares as FULL
+  void reset();
+
+  int getTileSize() const { return tileSize_; }
+
+private:
+  const int tileSize_;
+  const int subsample_;
+  const int threshold_;
+  const float maxChangedFraction_;
+
+  int width_;
+  int height_;
+  int samplesX_;
+  int samplesY_;
+  std::vector<unsigned char> reference_;
+  std::vector<unsigned char> pending_;
+  bool hasReference_;
+  bool hasPending_;
+
+  void sample(Ref<LuminanceSource> frame);
+};
+
+}
+
+#endif // __FRAME_CHANGE_DETECTOR_H__
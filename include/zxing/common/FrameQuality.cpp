@@ -0,0 +1,132 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  FrameQuality.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/FrameQuality.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZXING_FRAME_QUALITY_SSE2
+#endif
+
+using std::vector;
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::LuminanceSource;
+using zxing::FrameQuality;
+
+// VC++
+using zxing::IllegalArgumentException;
+
+namespace {
+
+const int LEVELS = 256;
+
+// The larger of the horizontal and vertical differences at each pixel of
+// row; the last pixel has no right neighbour and gets only the vertical one
+void gradients(unsigned char const* row, unsigned char const* below, int width, unsigned char* out) {
+  int x = 0;
+#ifdef ZXING_FRAME_QUALITY_SSE2
+  for (; x + 17 <= width; x += 16) {
+    __m128i pixels = _mm_loadu_si128((__m128i const*) (row + x));
+    __m128i right = _mm_loadu_si128((__m128i const*) (row + x + 1));
+    __m128i under = _mm_loadu_si128((__m128i const*) (below + x));
+    __m128i across = _mm_or_si128(_mm_subs_epu8(pixels, right), _mm_subs_epu8(right, pixels));
+    __m128i down = _mm_or_si128(_mm_subs_epu8(pixels, under), _mm_subs_epu8(under, pixels));
+    _mm_storeu_si128((__m128i*) (out + x), _mm_max_epu8(across, down));
+  }
+#endif
+  for (; x < width; x++) {
+    int down = row[x] > below[x] ? row[x] - below[x] : below[x] - row[x];
+    int across = 0;
+    if (x + 1 < width) {
+      across = row[x] > row[x + 1] ? row[x] - row[x + 1] : row[x + 1] - row[x];
+    }
+    out[x] = (unsigned char) (across > down ? across : down);
+  }
+}
+
+// The level below which at most the given count of samples lie, from the bottom
+int fromBottom(vector<int> const& histogram, int count) {
+  int seen = 0;
+  for (int level = 0; level < LEVELS; level++) {
+    seen += histogram[level];
+    if (seen > count) {
+      return level;
+    }
+  }
+  return LEVELS - 1;
+}
+
+int fromTop(vector<int> const& histogram, int count) {
+  int seen = 0;
+  for (int level = LEVELS - 1; level >= 0; level--) {
+    seen += histogram[level];
+    if (seen > count) {
+      return level;
+    }
+  }
+  return 0;
+}
+
+}
+
+const float FrameQuality::RANGE_TAIL = 0.01f;
+const float FrameQuality::EDGE_TAIL = 0.005f;
+
+FrameQuality::Measure FrameQuality::measure(Ref<LuminanceSource> frame, int step) {
+  if (step < 1) {
+    throw IllegalArgumentException("Frame quality row step must be at least 1.");
+  }
+  int width = frame->getWidth();
+  int height = frame->getHeight();
+  Measure measure;
+  if (width < 2 || height < 2) {
+    return measure;
+  }
+
+  vector<int> levels(LEVELS);
+  vector<int> steepness(LEVELS);
+  vector<unsigned char> rowGradients(width);
+  ArrayRef<char> row;
+  ArrayRef<char> below;
+  int samples = 0;
+  for (int y = 0; y + 1 < height; y += step) {
+    row = frame->getRow(y, row);
+    below = frame->getRow(y + 1, below);
+    unsigned char const* pixels = (unsigned char const*) &row[0];
+    gradients(pixels, (unsigned char const*) &below[0], width, &rowGradients[0]);
+    for (int x = 0; x < width; x++) {
+      levels[pixels[x]]++;
+      steepness[rowGradients[x]]++;
+    }
+    samples += width;
+  }
+
+  measure.black = fromBottom(levels, (int) (RANGE_TAIL * samples));
+  measure.white = fromTop(levels, (int) (RANGE_TAIL * samples));
+  measure.contrast = measure.white > measure.black ? measure.white - measure.black : 0;
+  if (measure.contrast > 0) {
+    int edge = fromTop(steepness, (int) (EDGE_TAIL * samples));
+    measure.sharpness = (float) edge / measure.contrast;
+  }
+  return measure;
+}
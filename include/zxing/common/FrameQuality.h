@@ -0,0 +1,60 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __FRAME_QUALITY_H__
+#define __FRAME_QUALITY_H__
+/*
+ *  FrameQuality.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/LuminanceSource.h>
+
+namespace zxing {
+
+/**
+ * Cheap estimates of whether a frame is worth decoding, taken from every
+ * step-th row before any binarization. Contrast is the spread between the
+ * darkest and the brightest percent of the pixels. Sharpness is how steep
+ * the steepest edges are: a high percentile of the gradient magnitude, as a
+ * fraction of the contrast. A sharp edge crosses most of the contrast
+ * within a pixel; blurred over n pixels it climbs about 1/n of it per pixel.
+ */
+class FrameQuality {
+public:
+  struct Measure {
+    int black;
+    int white;
+    int contrast;
+    float sharpness;
+    Measure() : black(0), white(0), contrast(0), sharpness(0) {}
+  };
+
+  // Throws IllegalArgumentException if step is less than 1
+  static Measure measure(Ref<LuminanceSource> frame, int step = 4);
+
+private:
+  // Share of the pixels ignored at either end of the luminance histogram
+  static const float RANGE_TAIL;
+  // Share of the gradients steeper than the one taken as the edge strength;
+  // a label can fill as little as a few percent of a frame
+  static const float EDGE_TAIL;
+
+  FrameQuality();
+};
+
+}
+
+#endif // __FRAME_QUALITY_H__
@@ -21,6 +21,8 @@
 #include <zxing/common/GlobalHistogramBinarizer.h>
 #include <zxing/NotFoundException.h>
 #include <zxing/common/Array.h>
+#include <zxing/common/Metrics.h>
+#include <zxing/common/Trace.h>
 
 using zxing::GlobalHistogramBinarizer;
 using zxing::Binarizer;
@@ -28,6 +30,7 @@ using zxing::ArrayRef;
 using zxing::Ref;
 using zxing::BitArray;
 using zxing::BitMatrix;
+using zxing::Metrics;
 
 // VC++
 using zxing::LuminanceSource;
@@ -96,6 +99,9 @@ Ref<BitArray> GlobalHistogramBinarizer::getBlackRow(int y, Ref<BitArray> row) {
 }
  
 Ref<BitMatrix> GlobalHistogramBinarizer::getBlackMatrix() {
+  ZXING_TRACE_SPAN("GlobalHistogramBinarizer::getBlackMatrix");
+  static const Metrics::Histogram latency = Metrics::stage("binarize");
+  Metrics::Timer timer(latency);
   LuminanceSource& source = *getLuminanceSource();
   int width = source.getWidth();
   int height = source.getHeight();
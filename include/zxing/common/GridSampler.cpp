@@ -21,9 +21,15 @@
 #include <zxing/common/GridSampler.h>
 #include <zxing/common/PerspectiveTransform.h>
 #include <zxing/ReaderException.h>
+#include <zxing/common/Trace.h>
 #include <iostream>
 #include <sstream>
 
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define ZXING_GRID_SAMPLER_SSE2
+#endif
+
 namespace zxing {
 using namespace std;
 
@@ -33,47 +39,114 @@ GridSampler::GridSampler() {
 }
 
 Ref<BitMatrix> GridSampler::sampleGrid(Ref<BitMatrix> image, int dimension, Ref<PerspectiveTransform> transform) {
-  Ref<BitMatrix> bits(new BitMatrix(dimension));
-  vector<float> points(dimension << 1, (const float)0.0f);
-  for (int y = 0; y < dimension; y++) {
-    int max = points.size();
-    float yValue = (float)y + 0.5f;
-    for (int x = 0; x < max; x += 2) {
-      points[x] = (float)(x >> 1) + 0.5f;
-      points[x + 1] = yValue;
-    }
-    transform->transformPoints(points);
-    checkAndNudgePoints(image, points);
-    for (int x = 0; x < max; x += 2) {
-      if (image->get((int)points[x], (int)points[x + 1])) {
-        bits->set(x >> 1, y);
-      }
-    }
-  }
-  return bits;
+  return sampleGrid(image, dimension, dimension, transform);
 }
 
 Ref<BitMatrix> GridSampler::sampleGrid(Ref<BitMatrix> image, int dimensionX, int dimensionY, Ref<PerspectiveTransform> transform) {
+  ZXING_TRACE_SPAN("GridSampler::sampleGrid");
   Ref<BitMatrix> bits(new BitMatrix(dimensionX, dimensionY));
-  vector<float> points(dimensionX << 1, (const float)0.0f);
+  int width = image->getWidth();
+  int height = image->getHeight();
+
+  // The x terms of the homography are the same for every row, so they are computed once per grid
+  // and each row only adds its own y terms. The sums are grouped exactly as in transformPoints(),
+  // which keeps every sampled coordinate bit-identical to the point-by-point path.
+  vector<float> columns(dimensionX * 3);
+  for (int x = 0; x < dimensionX; x++) {
+    float xValue = (float)x + 0.5f;
+    columns[x] = transform->a11 * xValue;
+    columns[dimensionX + x] = transform->a12 * xValue;
+    columns[2 * dimensionX + x] = transform->a13 * xValue;
+  }
+
+  vector<int> xs(dimensionX);
+  vector<int> ys(dimensionX);
   for (int y = 0; y < dimensionY; y++) {
-    int max = points.size();
     float yValue = (float)y + 0.5f;
-    for (int x = 0; x < max; x += 2) {
-      points[x] = (float)(x >> 1) + 0.5f;
-      points[x + 1] = yValue;
+    if (!transformRow(*transform, columns, dimensionX, yValue, width, height, xs, ys)) {
+      throwOutOfBounds(xs, ys, dimensionX, width, height);
     }
-    transform->transformPoints(points);
-    checkAndNudgePoints(image, points);
-    for (int x = 0; x < max; x += 2) {
-      if (image->get((int)points[x], (int)points[x + 1])) {
-        bits->set(x >> 1, y);
+    for (int x = 0; x < dimensionX; x++) {
+      // Points one pixel outside the image are nudged back onto the border, as in checkAndNudgePoints()
+      int px = xs[x];
+      int py = ys[x];
+      if (px == -1) {
+        px = 0;
+      } else if (px == width) {
+        px = width - 1;
+      }
+      if (py == -1) {
+        py = 0;
+      } else if (py == height) {
+        py = height - 1;
+      }
+      if (image->get(px, py)) {
+        bits->set(x, y);
       }
     }
   }
   return bits;
 }
 
+bool GridSampler::transformRow(PerspectiveTransform const& transform, vector<float> const& columns, int dimension,
+                               float yValue, int width, int height, vector<int> &xs, vector<int> &ys) {
+  float rowX = transform.a21 * yValue;
+  float rowY = transform.a22 * yValue;
+  float rowD = transform.a23 * yValue;
+  float const* columnX = &columns[0];
+  float const* columnY = columnX + dimension;
+  float const* columnD = columnY + dimension;
+
+  int x = 0;
+  bool inBounds = true;
+#ifdef ZXING_GRID_SAMPLER_SSE2
+  __m128 rowX4 = _mm_set1_ps(rowX);
+  __m128 rowY4 = _mm_set1_ps(rowY);
+  __m128 rowD4 = _mm_set1_ps(rowD);
+  __m128 a31 = _mm_set1_ps(transform.a31);
+  __m128 a32 = _mm_set1_ps(transform.a32);
+  __m128 a33 = _mm_set1_ps(transform.a33);
+  __m128i low = _mm_set1_epi32(-1);
+  __m128i right = _mm_set1_epi32(width);
+  __m128i bottom = _mm_set1_epi32(height);
+  __m128i outside = _mm_setzero_si128();
+  for (; x + 4 <= dimension; x += 4) {
+    __m128 denominator = _mm_add_ps(_mm_add_ps(_mm_loadu_ps(columnD + x), rowD4), a33);
+    __m128 px = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(columnX + x), rowX4), a31), denominator);
+    __m128 py = _mm_div_ps(_mm_add_ps(_mm_add_ps(_mm_loadu_ps(columnY + x), rowY4), a32), denominator);
+    __m128i ix = _mm_cvttps_epi32(px);
+    __m128i iy = _mm_cvttps_epi32(py);
+    outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmplt_epi32(ix, low), _mm_cmpgt_epi32(ix, right)));
+    outside = _mm_or_si128(outside, _mm_or_si128(_mm_cmplt_epi32(iy, low), _mm_cmpgt_epi32(iy, bottom)));
+    _mm_storeu_si128((__m128i*)&xs[x], ix);
+    _mm_storeu_si128((__m128i*)&ys[x], iy);
+  }
+  inBounds = _mm_movemask_epi8(outside) == 0;
+#endif
+  for (; x < dimension; x++) {
+    float denominator = columnD[x] + rowD + transform.a33;
+    int px = (int)((columnX[x] + rowX + transform.a31) / denominator);
+    int py = (int)((columnY[x] + rowY + transform.a32) / denominator);
+    if (px < -1 || px > width || py < -1 || py > height) {
+      inBounds = false;
+    }
+    xs[x] = px;
+    ys[x] = py;
+  }
+  return inBounds;
+}
+
+void GridSampler::throwOutOfBounds(vector<int> const& xs, vector<int> const& ys, int dimension, int width,
+                                   int height) {
+  for (int x = 0; x < dimension; x++) {
+    if (xs[x] < -1 || xs[x] > width || ys[x] < -1 || ys[x] > height) {
+      ostringstream s;
+      s << "Transformed point out of bounds at " << xs[x] << "," << ys[x];
+      throw ReaderException(s.str().c_str());
+    }
+  }
+}
+
 Ref<BitMatrix> GridSampler::sampleGrid(Ref<BitMatrix> image, int dimension, float p1ToX, float p1ToY, float p2ToX,
                                        float p2ToY, float p3ToX, float p3ToY, float p4ToX, float p4ToY, float p1FromX, float p1FromY, float p2FromX,
                                        float p2FromY, float p3FromX, float p3FromY, float p4FromX, float p4FromY) {
@@ -23,6 +23,7 @@
 #include <zxing/common/Counted.h>
 #include <zxing/common/BitMatrix.h>
 #include <zxing/common/PerspectiveTransform.h>
+#include <vector>
 
 namespace zxing {
 class GridSampler {
@@ -30,6 +31,11 @@ private:
   static GridSampler gridSampler;
   GridSampler();
 
+  static bool transformRow(PerspectiveTransform const& transform, std::vector<float> const& columns, int dimension,
+                           float yValue, int width, int height, std::vector<int> &xs, std::vector<int> &ys);
+  static void throwOutOfBounds(std::vector<int> const& xs, std::vector<int> const& ys, int dimension, int width,
+                               int height);
+
 public:
   Ref<BitMatrix> sampleGrid(Ref<BitMatrix> image, int dimension, Ref<PerspectiveTransform> transform);
   Ref<BitMatrix> sampleGrid(Ref<BitMatrix> image, int dimensionX, int dimensionY, Ref<PerspectiveTransform> transform);
@@ -21,6 +21,8 @@
 #include <zxing/common/HybridBinarizer.h>
 
 #include <zxing/common/IllegalArgumentException.h>
+#include <zxing/common/Metrics.h>
+#include <zxing/common/Trace.h>
 
 using namespace std;
 using namespace zxing;
@@ -52,6 +54,7 @@ HybridBinarizer::createBinarizer(Ref<LuminanceSource> source) {
  * profiling easier, and not doing heavy lifting when callers don't expect it.
  */
 Ref<BitMatrix> HybridBinarizer::getBlackMatrix() {
+  ZXING_TRACE_SPAN("HybridBinarizer::getBlackMatrix");
   if (matrix_) {
     return matrix_;
   }
@@ -59,6 +62,9 @@ Ref<BitMatrix> HybridBinarizer::getBlackMatrix() {
   int width = source.getWidth();
   int height = source.getHeight();
   if (width >= MINIMUM_DIMENSION && height >= MINIMUM_DIMENSION) {
+    // The fallback below times itself
+    static const Metrics::Histogram latency = Metrics::stage("binarize");
+    Metrics::Timer timer(latency);
     ArrayRef<char> luminances = source.getMatrix();
     int subWidth = width >> BLOCK_SIZE_POWER;
     if ((width & BLOCK_SIZE_MASK) != 0) {
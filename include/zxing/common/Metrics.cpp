@@ -0,0 +1,395 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  Metrics.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Metrics.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/BarcodeFormat.h>
+#include <algorithm>
+#include <deque>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+using std::string;
+using std::vector;
+using std::ostringstream;
+using zxing::Metrics;
+
+// VC++
+using zxing::IllegalArgumentException;
+using zxing::BarcodeFormat;
+
+std::atomic<bool> Metrics::timing_enabled_(true);
+
+namespace {
+  enum Type { COUNTER, GAUGE, HISTOGRAM };
+  char const* const TYPE_NAMES[] = { "counter", "gauge", "histogram" };
+
+  // Per thread; a histogram takes HISTOGRAM_CELLS of them
+  const int MAX_CELLS = 1024;
+
+  const int BUCKETS = 16;
+  const long long BUCKET_BOUNDS_NS[BUCKETS] = {
+    10000, 25000, 50000, 100000, 250000, 500000,
+    1000000, 2500000, 5000000, 10000000, 25000000, 50000000,
+    100000000, 250000000, 500000000, 1000000000
+  };
+  // A count per bucket, one past the last bound, and the sum in nanoseconds
+  const int HISTOGRAM_CELLS = BUCKETS + 2;
+  const int SUM_CELL = BUCKETS + 1;
+
+  struct Family {
+    string name;
+    string help;
+    Type type;
+  };
+
+  struct Series {
+    int family;
+    string labels;
+    int cell;
+    std::atomic<long long>* gauge;
+  };
+
+  struct Shard {
+    std::atomic<unsigned long long> cells[MAX_CELLS];
+    Shard() {
+      for (int i = 0; i < MAX_CELLS; i++) {
+        cells[i].store(0, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  struct Registry {
+    std::mutex lock;
+    vector<Family> families;
+    vector<Series> series;
+    int cells;
+    vector<Shard*> shards;
+    // Totals of the threads that have exited
+    vector<unsigned long long> retired;
+    std::deque<std::atomic<long long> > gauges;
+    Registry() : cells(0), retired(MAX_CELLS, 0) {}
+  };
+
+  // Never destroyed: threads may still exit, and retire their cells, once
+  // static destructors have run
+  Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+  }
+
+  class ThreadCells {
+  private:
+    Shard* shard_;
+  public:
+    ThreadCells() : shard_(0) {}
+    ~ThreadCells() {
+      if (shard_ == 0) {
+        return;
+      }
+      Registry& r = registry();
+      std::lock_guard<std::mutex> lock(r.lock);
+      for (int i = 0; i < MAX_CELLS; i++) {
+        r.retired[i] += shard_->cells[i].load(std::memory_order_relaxed);
+      }
+      r.shards.erase(std::find(r.shards.begin(), r.shards.end(), shard_));
+      delete shard_;
+    }
+    Shard& get() {
+      if (shard_ == 0) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.lock);
+        shard_ = new Shard();
+        r.shards.push_back(shard_);
+      }
+      return *shard_;
+    }
+  };
+
+  thread_local ThreadCells threadCells;
+
+  // Only this thread writes its cells, so no read-modify-write is needed;
+  // the atomic store keeps a concurrent scrape from reading a torn value
+  inline void bump(int cell, unsigned long long n) {
+    std::atomic<unsigned long long>& value = threadCells.get().cells[cell];
+    value.store(value.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+  }
+
+  Series enroll(string const& name, string const& help, string const& labels, Type type) {
+    Registry& r = registry();
+    std::lock_guard<std::mutex> lock(r.lock);
+    int family = -1;
+    for (size_t i = 0; i < r.families.size() && family < 0; i++) {
+      if (r.families[i].name == name) {
+        if (r.families[i].type != type) {
+          throw IllegalArgumentException("Metrics: series registered with two types");
+        }
+        family = (int)i;
+      }
+    }
+    if (family < 0) {
+      Family f = { name, help, type };
+      r.families.push_back(f);
+      family = (int)r.families.size() - 1;
+    }
+    for (size_t i = 0; i < r.series.size(); i++) {
+      if (r.series[i].family == family && r.series[i].labels == labels) {
+        return r.series[i];
+      }
+    }
+
+    Series s = { family, labels, -1, 0 };
+    if (type == GAUGE) {
+      r.gauges.emplace_back();
+      r.gauges.back().store(0);
+      s.gauge = &r.gauges.back();
+    } else {
+      int width = type == HISTOGRAM ? HISTOGRAM_CELLS : 1;
+      if (r.cells + width > MAX_CELLS) {
+        throw IllegalArgumentException("Metrics: too many series");
+      }
+      s.cell = r.cells;
+      r.cells += width;
+    }
+    r.series.push_back(s);
+    return s;
+  }
+
+  // Every thread's cells added up; the caller holds the registry's lock
+  vector<unsigned long long> totals(Registry& r) {
+    vector<unsigned long long> sums(r.retired);
+    for (size_t i = 0; i < r.shards.size(); i++) {
+      for (int cell = 0; cell < r.cells; cell++) {
+        sums[cell] += r.shards[i]->cells[cell].load(std::memory_order_relaxed);
+      }
+    }
+    return sums;
+  }
+
+  void writeName(ostringstream& out, string const& name, char const* suffix, string const& labels,
+                 char const* extra = 0) {
+    out << name << suffix;
+    if (!labels.empty() || extra != 0) {
+      out << '{' << labels;
+      if (!labels.empty() && extra != 0) {
+        out << ',';
+      }
+      out << (extra != 0 ? extra : "") << '}';
+    }
+  }
+
+  double seconds(unsigned long long nanoseconds) {
+    return nanoseconds / 1e9;
+  }
+}
+
+void Metrics::Counter::add(unsigned long long n) const {
+  if (cell_ >= 0) {
+    bump(cell_, n);
+  }
+}
+
+void Metrics::Histogram::observe(std::chrono::steady_clock::duration elapsed) const {
+  if (cell_ < 0) {
+    return;
+  }
+  long long ns = std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count();
+  int bucket = 0;
+  while (bucket < BUCKETS && ns > BUCKET_BOUNDS_NS[bucket]) {
+    bucket++;
+  }
+  bump(cell_ + bucket, 1);
+  bump(cell_ + SUM_CELL, ns > 0 ? (unsigned long long)ns : 0);
+}
+
+void Metrics::Gauge::set(long long value) const {
+  if (value_ != 0) {
+    value_->store(value, std::memory_order_relaxed);
+  }
+}
+
+void Metrics::Gauge::add(long long delta) const {
+  if (value_ != 0) {
+    value_->fetch_add(delta, std::memory_order_relaxed);
+  }
+}
+
+Metrics::Counter Metrics::counter(string const& name, string const& help, string const& labels) {
+  return Counter(enroll(name, help, labels, COUNTER).cell);
+}
+
+Metrics::Histogram Metrics::histogram(string const& name, string const& help, string const& labels) {
+  return Histogram(enroll(name, help, labels, HISTOGRAM).cell);
+}
+
+Metrics::Gauge Metrics::gauge(string const& name, string const& help, string const& labels) {
+  return Gauge(enroll(name, help, labels, GAUGE).gauge);
+}
+
+Metrics::Histogram Metrics::stage(char const* name) {
+  return histogram("zxing_stage_seconds", "Time spent in each stage of decoding a frame",
+                   string("stage=\"") + name + "\"");
+}
+
+namespace {
+  // Found frames, indexed by BarcodeFormat
+  vector<Metrics::Counter> formatCounters() {
+    vector<Metrics::Counter> counters;
+    for (int format = BarcodeFormat::NONE; format <= BarcodeFormat::UPC_EAN_EXTENSION; format++) {
+      char const* name = BarcodeFormat::barcodeFormatNames[format];
+      counters.push_back(Metrics::counter("zxing_frames_total", "Frames decoded, by outcome",
+                                          string("result=\"found\",format=\"") +
+                                          (name != 0 ? name : "NONE") + "\""));
+    }
+    return counters;
+  }
+}
+
+void Metrics::frame(int format, bool timedOut) {
+  static const Counter notFound =
+    counter("zxing_frames_total", "Frames decoded, by outcome", "result=\"not_found\"");
+  static const Counter timedOutFrames =
+    counter("zxing_frames_total", "Frames decoded, by outcome", "result=\"timed_out\"");
+  static vector<Counter> const found = formatCounters();
+  if (format > BarcodeFormat::NONE && format < (int)found.size()) {
+    found[format].add();
+  } else if (timedOut) {
+    timedOutFrames.add();
+  } else {
+    notFound.add();
+  }
+}
+
+void Metrics::allocated(std::size_t bytes) {
+  // Local statics, since arrays are allocated during static initialization too
+  static const Counter allocations =
+    counter("zxing_array_allocations_total", "Arrays allocated for luminances, bits and codewords");
+  static const Counter allocatedBytes =
+    counter("zxing_array_allocated_bytes_total", "Bytes allocated for arrays");
+  allocations.add();
+  allocatedBytes.add(bytes);
+}
+
+void Metrics::setTiming(bool enabled) {
+  timing_enabled_.store(enabled, std::memory_order_relaxed);
+}
+
+string Metrics::scrape() {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.lock);
+  vector<unsigned long long> sums = totals(r);
+  ostringstream out;
+  out.precision(12);
+  for (size_t f = 0; f < r.families.size(); f++) {
+    Family const& family = r.families[f];
+    out << "# HELP " << family.name << ' ' << family.help << '\n';
+    out << "# TYPE " << family.name << ' ' << TYPE_NAMES[family.type] << '\n';
+    for (size_t i = 0; i < r.series.size(); i++) {
+      Series const& s = r.series[i];
+      if (s.family != (int)f) {
+        continue;
+      }
+      if (family.type == COUNTER) {
+        writeName(out, family.name, "", s.labels);
+        out << ' ' << sums[s.cell] << '\n';
+      } else if (family.type == GAUGE) {
+        writeName(out, family.name, "", s.labels);
+        out << ' ' << s.gauge->load(std::memory_order_relaxed) << '\n';
+      } else {
+        // Buckets are cumulative in the exposition format
+        unsigned long long count = 0;
+        for (int b = 0; b <= BUCKETS; b++) {
+          count += sums[s.cell + b];
+          ostringstream le;
+          if (b < BUCKETS) {
+            le << "le=\"" << seconds(BUCKET_BOUNDS_NS[b]) << '"';
+          } else {
+            le << "le=\"+Inf\"";
+          }
+          writeName(out, family.name, "_bucket", s.labels, le.str().c_str());
+          out << ' ' << count << '\n';
+        }
+        writeName(out, family.name, "_sum", s.labels);
+        out << ' ' << seconds(sums[s.cell + SUM_CELL]) << '\n';
+        writeName(out, family.name, "_count", s.labels);
+        out << ' ' << count << '\n';
+      }
+    }
+  }
+  return out.str();
+}
+
+string Metrics::snapshot() {
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.lock);
+  vector<unsigned long long> sums = totals(r);
+  ostringstream out;
+  out.precision(3);
+  out << std::fixed;
+  for (size_t i = 0; i < r.series.size(); i++) {
+    Series const& s = r.series[i];
+    Family const& family = r.families[s.family];
+    if (family.type == GAUGE) {
+      writeName(out, family.name, "", s.labels);
+      out << ' ' << s.gauge->load(std::memory_order_relaxed) << '\n';
+      continue;
+    }
+    if (family.type == COUNTER) {
+      // Series that never counted anything only make the log longer
+      if (sums[s.cell] != 0) {
+        writeName(out, family.name, "", s.labels);
+        out << ' ' << sums[s.cell] << '\n';
+      }
+      continue;
+    }
+
+    unsigned long long count = 0;
+    for (int b = 0; b <= BUCKETS; b++) {
+      count += sums[s.cell + b];
+    }
+    if (count == 0) {
+      continue;
+    }
+    // Quantiles as the upper bound of the bucket they fall in
+    double quantiles[] = { 0.5, 0.99 };
+    string bounds[2];
+    for (int q = 0; q < 2; q++) {
+      unsigned long long rank = (unsigned long long)(quantiles[q] * (count - 1)) + 1;
+      unsigned long long seen = 0;
+      int b = 0;
+      while (b < BUCKETS && (seen += sums[s.cell + b]) < rank) {
+        b++;
+      }
+      ostringstream bound;
+      bound.precision(3);
+      if (b < BUCKETS) {
+        bound << "<=" << BUCKET_BOUNDS_NS[b] / 1e6;
+      } else {
+        bound << ">" << BUCKET_BOUNDS_NS[BUCKETS - 1] / 1e6;
+      }
+      bounds[q] = bound.str();
+    }
+    writeName(out, family.name, "", s.labels);
+    out << " count " << count << " mean " << sums[s.cell + SUM_CELL] / 1e6 / count << " ms"
+        << " p50 " << bounds[0] << " ms p99 " << bounds[1] << " ms\n";
+  }
+  return out.str();
+}
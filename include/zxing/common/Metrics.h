@@ -0,0 +1,135 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __METRICS_H__
+#define __METRICS_H__
+
+/*
+ *  Metrics.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <string>
+
+namespace zxing {
+
+/**
+ * Process-wide counters, gauges and latency histograms, cheap enough to
+ * leave on in production and rendered in the Prometheus text format.
+ *
+ * Counters and histograms are recorded into cells owned by the recording
+ * thread and written by no other, so recording is a load and a store with
+ * no lock and no cache line shared between threads. A scrape adds up the
+ * cells of every live thread and of the threads that have exited. Gauges
+ * are current values rather than running totals, and are shared atomics.
+ *
+ * A series is registered once, typically into a static, and recorded
+ * through the handle returned. Registering the same name and labels again
+ * returns the same series; labels are given preformatted, as in
+ * "reader=\"qr_code\"". Default-constructed handles record nothing.
+ */
+class Metrics {
+public:
+  class Counter {
+  public:
+    Counter() : cell_(-1) {}
+    void add(unsigned long long n = 1) const;
+  private:
+    explicit Counter(int cell) : cell_(cell) {}
+    int cell_;
+    friend class Metrics;
+  };
+
+  // Latencies, in buckets from 10 us to 1 s
+  class Histogram {
+  public:
+    Histogram() : cell_(-1) {}
+    void observe(std::chrono::steady_clock::duration elapsed) const;
+  private:
+    explicit Histogram(int cell) : cell_(cell) {}
+    int cell_;
+    friend class Metrics;
+  };
+
+  class Gauge {
+  public:
+    Gauge() : value_(0) {}
+    void set(long long value) const;
+    void add(long long delta) const;
+  private:
+    explicit Gauge(std::atomic<long long>* value) : value_(value) {}
+    std::atomic<long long>* value_;
+    friend class Metrics;
+  };
+
+  // Observes the time until the end of its scope, unless timing is off
+  class Timer {
+  public:
+    explicit Timer(Histogram const& histogram)
+      : histogram_(histogram), timing_(timing_enabled_.load(std::memory_order_relaxed)) {
+      if (timing_) {
+        start_ = std::chrono::steady_clock::now();
+      }
+    }
+    ~Timer() {
+      if (timing_) {
+        histogram_.observe(std::chrono::steady_clock::now() - start_);
+      }
+    }
+  private:
+    Histogram const& histogram_;
+    const bool timing_;
+    std::chrono::steady_clock::time_point start_;
+    Timer(Timer const&);
+    Timer& operator=(Timer const&);
+  };
+
+  static Counter counter(std::string const& name, std::string const& help,
+                         std::string const& labels = std::string());
+  static Histogram histogram(std::string const& name, std::string const& help,
+                             std::string const& labels = std::string());
+  static Gauge gauge(std::string const& name, std::string const& help,
+                     std::string const& labels = std::string());
+
+  // zxing_stage_seconds for one stage of decoding a frame
+  static Histogram stage(char const* name);
+
+  // zxing_frames_total for one frame, given the BarcodeFormat found or NONE.
+  // Recorded where whole frames are decoded, not by the readers, which a
+  // frame may run many times.
+  static void frame(int format, bool timedOut);
+
+  // Counts a buffer allocated by Array
+  static void allocated(std::size_t bytes);
+
+  // Timers read the clock twice per scope; counters are always recorded
+  static void setTiming(bool enabled);
+
+  // Every series in the Prometheus text exposition format, version 0.0.4
+  static std::string scrape();
+  // The same, one line per series, with histograms as count, mean and
+  // approximate quantiles in milliseconds, for a log
+  static std::string snapshot();
+
+private:
+  static std::atomic<bool> timing_enabled_;
+};
+
+}
+
+#endif // __METRICS_H__
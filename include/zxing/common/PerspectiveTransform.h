@@ -24,6 +24,8 @@
 #include <vector>
 
 namespace zxing {
+class GridSampler;
+
 class PerspectiveTransform : public Counted {
 private:
   float a11, a12, a13, a21, a22, a23, a31, a32, a33;
@@ -43,6 +45,7 @@ public:
   void transformPoints(std::vector<float> &points);
 
   friend std::ostream& operator<<(std::ostream& out, const PerspectiveTransform &pt);
+  friend class GridSampler;
 };
 }
 
@@ -18,11 +18,138 @@
 
 #include <zxing/common/StringUtils.h>
 #include <zxing/DecodeHints.h>
+#include <zxing/ReaderException.h>
+#include <cctype>
+#include <cstring>
+#include <stdint.h>
+#ifndef NO_ICONV
+#include <iconv.h>
+#endif
+
+#ifdef ZXING_ICONV_CONST
+#undef ICONV_CONST
+#define ICONV_CONST const
+#endif
+
+#ifndef ICONV_CONST
+#define ICONV_CONST /**/
+#endif
 
 using namespace std;
 using namespace zxing;
 using namespace zxing::common;
 
+namespace {
+
+  bool isAscii(char const* bytes, size_t length) {
+    // OR eight bytes at a time; any high bit set means non-ASCII.
+    uint64_t high = 0;
+    size_t i = 0;
+    for (; i + 8 <= length; i += 8) {
+      uint64_t word;
+      memcpy(&word, bytes + i, sizeof(word));
+      high |= word;
+    }
+    for (; i < length; i++) {
+      high |= (unsigned char)bytes[i];
+    }
+    return (high & 0x8080808080808080ULL) == 0;
+  }
+
+  // Lower-cased with '-', '_' and ' ' removed, so "ISO-8859-1",
+  // "ISO8859-1" and "iso_8859_1" all compare equal.
+  string normalizeEncoding(char const* encoding) {
+    string name;
+    for (char const* c = encoding; *c; c++) {
+      if (*c != '-' && *c != '_' && *c != ' ') {
+        name.push_back((char)tolower((unsigned char)*c));
+      }
+    }
+    return name;
+  }
+
+  bool startsWith(string const& name, char const* prefix) {
+    return name.compare(0, strlen(prefix), prefix) == 0;
+  }
+
+  bool isLatin1(string const& name) {
+    return name == "iso88591" || name == "latin1" || name == "l1";
+  }
+
+  // Encodings in which every byte below 0x80 decodes to the same ASCII
+  // character. Shift_JIS is deliberately absent: some tables map 0x5C
+  // and 0x7E to yen and overline.
+  bool isAsciiCompatible(string const& name) {
+    return name == "ascii" || name == "usascii" || name == "utf8" ||
+      startsWith(name, "iso8859") || startsWith(name, "latin") ||
+      startsWith(name, "cp125") || startsWith(name, "windows125") ||
+      name == "cp437" || startsWith(name, "gb") || startsWith(name, "euc") ||
+      name == "big5";
+  }
+
+  void appendLatin1(string& result, char const* bytes, size_t length) {
+    size_t start = result.size();
+    result.resize(start + 2 * length);
+    char* out = &result[start];
+    for (size_t i = 0; i < length; i++) {
+      unsigned char c = (unsigned char)bytes[i];
+      if (c < 0x80) {
+        *out++ = (char)c;
+      } else {
+        *out++ = (char)(0xC0 | (c >> 6));
+        *out++ = (char)(0x80 | (c & 0x3F));
+      }
+    }
+    result.resize(out - result.data());
+  }
+
+#ifndef NO_ICONV
+  // iconv_open is expensive (it may load a gconv module) so descriptors
+  // are kept for the life of the thread, keyed by source encoding.
+  // Descriptors carry shift state and must not be shared across threads.
+  class IconvCache {
+  private:
+    map<string, iconv_t> descriptors_;
+
+  public:
+    ~IconvCache() {
+      for (map<string, iconv_t>::iterator i = descriptors_.begin(); i != descriptors_.end(); ++i) {
+        if (i->second != (iconv_t)-1) {
+          iconv_close(i->second);
+        }
+      }
+    }
+
+    // Returns (iconv_t)-1 if the encoding is unsupported; that answer
+    // is cached too.
+    iconv_t get(char const* encoding) {
+      map<string, iconv_t>::iterator i = descriptors_.find(encoding);
+      if (i != descriptors_.end()) {
+        return i->second;
+      }
+      iconv_t cd = iconv_open(StringUtils::UTF8, encoding);
+      descriptors_[encoding] = cd;
+      return cd;
+    }
+  };
+
+  IconvCache& iconvCache() {
+#if defined(_MSC_VER) && _MSC_VER < 1900
+    // VC++ 2013 has no thread_local; the cache is leaked at thread exit.
+    static __declspec(thread) IconvCache* cache = 0;
+    if (!cache) {
+      cache = new IconvCache();
+    }
+    return *cache;
+#else
+    static thread_local IconvCache cache;
+    return cache;
+#endif
+  }
+#endif
+
+}
+
 // N.B.: these are the iconv strings for at least some versions of iconv
 
 char const* const StringUtils::PLATFORM_DEFAULT_ENCODING = "UTF-8";
@@ -41,6 +168,11 @@ StringUtils::guessEncoding(char* bytes, int length,
   if (i != hints.end()) {
     return i->second;
   }
+  // Pure ASCII rules out UTF-8 and Shift_JIS multi-byte evidence, so the
+  // full scan below would also settle on ISO-8859-1.
+  if (!ASSUME_SHIFT_JIS && length > 0 && isAscii(bytes, length)) {
+    return ISO88591;
+  }
   typedef bool boolean;
   // For now, merely tries to distinguish ISO-8859-1, UTF-8 and Shift_JIS,
   // which should be by far the most common encodings.
@@ -196,3 +328,50 @@ StringUtils::guessEncoding(char* bytes, int length,
   // Otherwise, we take a wild guess with platform encoding
   return PLATFORM_DEFAULT_ENCODING;
 }
+
+void
+StringUtils::append(string& result, char const* bytes, size_t length,
+                    char const* encoding) {
+  if (length == 0) {
+    return;
+  }
+
+  string name = normalizeEncoding(encoding);
+  if (isLatin1(name)) {
+    appendLatin1(result, bytes, length);
+    return;
+  }
+  if (isAsciiCompatible(name) && isAscii(bytes, length)) {
+    result.append(bytes, length);
+    return;
+  }
+
+#ifndef NO_ICONV
+  iconv_t cd = iconvCache().get(encoding);
+  if (cd == (iconv_t)-1) {
+    result.append(bytes, length);
+    return;
+  }
+  // Reset any shift state left over from an earlier failed conversion.
+  iconv(cd, NULL, NULL, NULL, NULL);
+
+  size_t start = result.size();
+  result.resize(start + 4 * length);
+
+  ICONV_CONST char* fromPtr = (ICONV_CONST char*)bytes;
+  size_t nFrom = length;
+  char* toPtr = &result[start];
+  size_t nTo = 4 * length;
+
+  while (nFrom > 0) {
+    size_t oneway = iconv(cd, &fromPtr, &nFrom, &toPtr, &nTo);
+    if (oneway == (size_t)(-1)) {
+      result.resize(start);
+      throw ReaderException("error converting characters");
+    }
+  }
+  result.resize(start + 4 * length - nTo);
+#else
+  result.append(bytes, length);
+#endif
+}
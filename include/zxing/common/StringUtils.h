@@ -44,6 +44,12 @@ public:
   typedef std::map<DecodeHintType, std::string> Hashtable;
 
   static std::string guessEncoding(char* bytes, int length, Hashtable const& hints);
+
+  // Appends bytes in the given encoding to result as UTF-8. ASCII and
+  // ISO-8859-1 input is converted inline; anything else goes through an
+  // iconv descriptor cached per thread. Throws ReaderException if the
+  // bytes are not valid in the given encoding.
+  static void append(std::string& result, char const* bytes, size_t length, char const* encoding);
 };
 
 }
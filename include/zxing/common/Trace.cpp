@@ -0,0 +1,169 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  Trace.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Trace.h>
+#include <algorithm>
+#include <mutex>
+#include <sstream>
+#include <vector>
+
+using std::string;
+using std::vector;
+using zxing::Trace;
+
+std::atomic<bool> Trace::recording_(false);
+
+namespace {
+  // Fields are atomic only so an export may read them while they are
+  // written; torn spans are recognised by their position, not their fields
+  struct Event {
+    std::atomic<char const*> name;
+    std::atomic<long long> begin;
+    std::atomic<long long> end;
+  };
+
+  struct Ring {
+    int thread;
+    // Spans written so far; span i is in events[i % RING_SPANS]
+    std::atomic<unsigned long long> written;
+    Event events[Trace::RING_SPANS];
+    // Guarded by the registry's lock
+    bool owned;
+    Ring(int thread_) : thread(thread_), written(0), owned(true) {}
+  };
+
+  struct Copy {
+    char const* name;
+    long long begin;
+    long long end;
+  };
+
+  struct Registry {
+    std::mutex lock;
+    vector<Ring*> rings;
+  };
+
+  // Never destroyed, like the rings: a thread may record while another
+  // runs static destructors
+  Registry& registry() {
+    static Registry* instance = new Registry();
+    return *instance;
+  }
+
+  class ThreadRing {
+  private:
+    Ring* ring_;
+  public:
+    ThreadRing() : ring_(0) {}
+    ~ThreadRing() {
+      if (ring_ != 0) {
+        std::lock_guard<std::mutex> lock(registry().lock);
+        ring_->owned = false;
+      }
+    }
+    Ring& get() {
+      if (ring_ == 0) {
+        Registry& r = registry();
+        std::lock_guard<std::mutex> lock(r.lock);
+        for (size_t i = 0; i < r.rings.size() && ring_ == 0; i++) {
+          if (!r.rings[i]->owned) {
+            ring_ = r.rings[i];
+            ring_->owned = true;
+          }
+        }
+        if (ring_ == 0) {
+          ring_ = new Ring((int)r.rings.size() + 1);
+          r.rings.push_back(ring_);
+        }
+      }
+      return *ring_;
+    }
+  };
+
+  thread_local ThreadRing threadRing;
+
+  void writeMicroseconds(std::ostringstream& out, long long nanoseconds) {
+    out << nanoseconds / 1000 << '.';
+    int fraction = (int)(nanoseconds % 1000);
+    out << (char)('0' + fraction / 100) << (char)('0' + fraction / 10 % 10) << (char)('0' + fraction % 10);
+  }
+}
+
+void Trace::start() {
+  recording_.store(true, std::memory_order_relaxed);
+}
+
+void Trace::stop() {
+  recording_.store(false, std::memory_order_relaxed);
+}
+
+void Trace::record(char const* name, long long begin, long long end) {
+  Ring& ring = threadRing.get();
+  unsigned long long index = ring.written.load(std::memory_order_relaxed);
+  Event& event = ring.events[index % RING_SPANS];
+  event.name.store(name, std::memory_order_relaxed);
+  event.begin.store(begin, std::memory_order_relaxed);
+  event.end.store(end, std::memory_order_relaxed);
+  ring.written.store(index + 1, std::memory_order_release);
+}
+
+string Trace::exportChromeTrace(int windowMs) {
+  long long since = now() - (long long)windowMs * 1000000;
+  std::ostringstream out;
+  out << "{\"traceEvents\":[";
+  bool first = true;
+
+  Registry& r = registry();
+  std::lock_guard<std::mutex> lock(r.lock);
+  vector<Copy> copied(RING_SPANS);
+  for (size_t i = 0; i < r.rings.size(); i++) {
+    Ring& ring = *r.rings[i];
+    unsigned long long written = ring.written.load(std::memory_order_acquire);
+    unsigned long long oldest = written > (unsigned long long)RING_SPANS ? written - RING_SPANS : 0;
+    for (unsigned long long s = oldest; s < written; s++) {
+      Event const& event = ring.events[s % RING_SPANS];
+      Copy& copy = copied[s - oldest];
+      copy.name = event.name.load(std::memory_order_relaxed);
+      copy.begin = event.begin.load(std::memory_order_relaxed);
+      copy.end = event.end.load(std::memory_order_relaxed);
+    }
+    // Spans the thread has started overwriting while they were copied are
+    // dropped: everything up to the slot of the next one it writes
+    std::atomic_thread_fence(std::memory_order_acquire);
+    unsigned long long after = ring.written.load(std::memory_order_relaxed);
+    unsigned long long valid = after + 1 > (unsigned long long)RING_SPANS ? after + 1 - RING_SPANS : 0;
+
+    for (unsigned long long s = std::max(oldest, valid); s < written; s++) {
+      Copy const& copy = copied[s - oldest];
+      if (copy.end < since) {
+        continue;
+      }
+      out << (first ? "" : ",") << "\n{\"name\":\"" << copy.name
+          << "\",\"cat\":\"zxing\",\"ph\":\"X\",\"pid\":1,\"tid\":" << ring.thread << ",\"ts\":";
+      writeMicroseconds(out, copy.begin);
+      out << ",\"dur\":";
+      writeMicroseconds(out, copy.end - copy.begin);
+      out << '}';
+      first = false;
+    }
+  }
+  out << "\n],\"displayTimeUnit\":\"ms\"}\n";
+  return out.str();
+}
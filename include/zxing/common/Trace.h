@@ -0,0 +1,95 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __TRACE_H__
+#define __TRACE_H__
+
+/*
+ *  Trace.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <atomic>
+#include <chrono>
+#include <string>
+
+/*
+ * ZXING_TRACE_SPAN("name") times the rest of the enclosing scope as a span
+ * named by the string literal. Spans are compiled in only when ZXING_TRACE
+ * is defined; otherwise the macro expands to nothing.
+ */
+#ifdef ZXING_TRACE
+#define ZXING_TRACE_SPAN_VARIABLE2(line) zxingTraceSpan##line
+#define ZXING_TRACE_SPAN_VARIABLE(line) ZXING_TRACE_SPAN_VARIABLE2(line)
+#define ZXING_TRACE_SPAN(name) ::zxing::Trace::Span ZXING_TRACE_SPAN_VARIABLE(__LINE__)(name)
+#else
+#define ZXING_TRACE_SPAN(name) ((void)0)
+#endif
+
+namespace zxing {
+
+/**
+ * Spans of decoding work, exported as Chrome trace events for viewing in
+ * chrome://tracing or Perfetto.
+ *
+ * While no trace is being recorded a span costs one relaxed load. While
+ * one is, each thread writes its spans into a ring of its own, allocated
+ * on its first span, with no lock and no read-modify-write; the oldest
+ * spans are overwritten once the ring is full. Exporting reads every
+ * ring and drops the spans a writer may have been overwriting meanwhile.
+ */
+class Trace {
+public:
+  class Span {
+  public:
+    explicit Span(char const* name)
+      : name_(name), begin_(recording_.load(std::memory_order_relaxed) ? now() : -1) {}
+    ~Span() {
+      if (begin_ >= 0) {
+        record(name_, begin_, now());
+      }
+    }
+  private:
+    char const* const name_;
+    const long long begin_;
+    Span(Span const&);
+    Span& operator=(Span const&);
+  };
+
+  // Spans recorded per thread before the oldest are overwritten
+  static const int RING_SPANS = 8192;
+
+  static void start();
+  static void stop();
+  static bool recording() { return recording_.load(std::memory_order_relaxed); }
+
+  // The spans that ended in the last windowMs, as a Chrome trace-event
+  // JSON object. Spans carry the number of their thread's ring as tid; the
+  // ring of a thread that has exited is handed on to the next new thread.
+  static std::string exportChromeTrace(int windowMs);
+
+private:
+  static std::atomic<bool> recording_;
+
+  static long long now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+      std::chrono::steady_clock::now().time_since_epoch()).count();
+  }
+  static void record(char const* name, long long begin, long long end);
+};
+
+}
+
+#endif // __TRACE_H__
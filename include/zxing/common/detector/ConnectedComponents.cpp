@@ -0,0 +1,140 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  ConnectedComponents.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/detector/ConnectedComponents.h>
+#include <zxing/common/BitArray.h>
+
+using std::vector;
+using zxing::Ref;
+using zxing::BitArray;
+using zxing::BitMatrix;
+using zxing::ConnectedComponents;
+
+namespace {
+
+// A run of black pixels in one row, end exclusive. parent links the runs
+// of a component into a union-find tree whose root is its first run.
+struct Run {
+  int start;
+  int end;
+  int parent;
+};
+
+int findRoot(vector<Run>& runs, int i) {
+  while (runs[i].parent != i) {
+    runs[i].parent = runs[runs[i].parent].parent;
+    i = runs[i].parent;
+  }
+  return i;
+}
+
+void join(vector<Run>& runs, int a, int b) {
+  a = findRoot(runs, a);
+  b = findRoot(runs, b);
+  if (a < b) {
+    runs[b].parent = a;
+  } else if (b < a) {
+    runs[a].parent = b;
+  }
+}
+
+}
+
+vector<ConnectedComponents::Component> ConnectedComponents::find(Ref<BitMatrix> image, int minPixels) {
+  int width = image->getWidth();
+  int height = image->getHeight();
+
+  vector<Run> runs;
+  vector<int> rowStarts(height + 1);
+  Ref<BitArray> row;
+  for (int y = 0; y < height; y++) {
+    row = image->getRow(y, row);
+    rowStarts[y] = (int) runs.size();
+    for (int x = row->getNextSet(0); x < width; x = row->getNextSet(x)) {
+      Run run;
+      run.start = x;
+      run.end = row->getNextUnset(x);
+      run.parent = (int) runs.size();
+      runs.push_back(run);
+      x = run.end;
+    }
+    if (y == 0) {
+      continue;
+    }
+    // Join the runs that touch a run of the row above, diagonals included
+    int above = rowStarts[y - 1];
+    int aboveEnd = rowStarts[y];
+    int current = rowStarts[y];
+    int currentEnd = (int) runs.size();
+    while (above < aboveEnd && current < currentEnd) {
+      if (runs[above].end < runs[current].start) {
+        above++;
+      } else if (runs[current].end < runs[above].start) {
+        current++;
+      } else {
+        join(runs, above, current);
+        if (runs[above].end < runs[current].end) {
+          above++;
+        } else {
+          current++;
+        }
+      }
+    }
+  }
+  rowStarts[height] = (int) runs.size();
+
+  // Roots are met in raster order, each before any other run of its component
+  vector<Component> components;
+  vector<int> componentOf(runs.size(), -1);
+  for (int y = 0; y < height; y++) {
+    for (int i = rowStarts[y]; i < rowStarts[y + 1]; i++) {
+      int root = findRoot(runs, i);
+      if (componentOf[root] < 0) {
+        componentOf[root] = (int) components.size();
+        Component component;
+        component.left = runs[i].start;
+        component.top = y;
+        component.right = runs[i].end;
+        component.bottom = y + 1;
+        component.pixels = 0;
+        component.runs = 0;
+        components.push_back(component);
+      }
+      Component& component = components[componentOf[root]];
+      if (runs[i].start < component.left) {
+        component.left = runs[i].start;
+      }
+      if (runs[i].end > component.right) {
+        component.right = runs[i].end;
+      }
+      component.bottom = y + 1;
+      component.pixels += runs[i].end - runs[i].start;
+      component.runs++;
+    }
+  }
+
+  vector<Component> result;
+  for (size_t i = 0; i < components.size(); i++) {
+    if (components[i].pixels >= minPixels) {
+      result.push_back(components[i]);
+    }
+  }
+  return result;
+}
@@ -0,0 +1,62 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __CONNECTED_COMPONENTS_H__
+#define __CONNECTED_COMPONENTS_H__
+
+/*
+ *  ConnectedComponents.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/BitMatrix.h>
+#include <vector>
+
+namespace zxing {
+
+/**
+ * Labels the 8-connected black regions of a bit matrix. Works on runs of
+ * black pixels rather than pixels: the runs of each row are joined to the
+ * runs of the row above that they touch, so the cost grows with the number
+ * of runs and a symbol's solid edges cost no more than a few words of its rows.
+ */
+class ConnectedComponents {
+public:
+  struct Component {
+    // Bounding box, right and bottom exclusive
+    int left;
+    int top;
+    int right;
+    int bottom;
+    // Black pixels and runs of black pixels in the component
+    int pixels;
+    int runs;
+
+    int getWidth() const { return right - left; }
+    int getHeight() const { return bottom - top; }
+    // Fraction of the bounding box that is black
+    float getDensity() const { return (float) pixels / ((float) getWidth() * getHeight()); }
+  };
+
+  // Components of at least minPixels black pixels, in the order of their top left run
+  static std::vector<Component> find(Ref<BitMatrix> image, int minPixels);
+
+private:
+  ConnectedComponents();
+};
+
+}
+
+#endif // __CONNECTED_COMPONENTS_H__
@@ -0,0 +1,181 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  RegionProposer.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/detector/RegionProposer.h>
+#include <zxing/common/detector/ConnectedComponents.h>
+#include <zxing/common/BitArray.h>
+#include <algorithm>
+#include <cmath>
+
+using std::vector;
+using zxing::Ref;
+using zxing::BitArray;
+using zxing::BitMatrix;
+using zxing::DecodeHints;
+using zxing::ConnectedComponents;
+using zxing::RegionProposer;
+
+namespace {
+
+// Transitions counted in one cell
+struct CellStats {
+  int rows;
+  int columns;
+  int diagonals;
+  int antiDiagonals;
+  CellStats() : rows(0), columns(0), diagonals(0), antiDiagonals(0) {}
+};
+
+int bitCount(unsigned int value) {
+  value = value - ((value >> 1) & 0x55555555u);
+  value = (value & 0x33333333u) + ((value >> 2) & 0x33333333u);
+  return (int) ((((value + (value >> 4)) & 0x0F0F0F0Fu) * 0x01010101u) >> 24);
+}
+
+// Bits x + 1 to x + 32 of a row, for the word holding bit x
+unsigned int nextPixels(vector<int> const& words, size_t word) {
+  unsigned int value = (unsigned int) words[word] >> 1;
+  if (word + 1 < words.size()) {
+    value |= (unsigned int) words[word + 1] << 31;
+  }
+  return value;
+}
+
+// Mean of the transition counts and the magnitude of their second angular
+// harmonic. Diagonal steps are longer by the square root of two.
+float coherenceOf(CellStats const& stats) {
+  float rows = (float) stats.rows;
+  float columns = (float) stats.columns;
+  float diagonals = stats.diagonals / 1.4142135f;
+  float antiDiagonals = stats.antiDiagonals / 1.4142135f;
+  float mean = (rows + columns + diagonals + antiDiagonals) / 4;
+  if (mean <= 0) {
+    return 0;
+  }
+  float cosine = (rows - columns) / 2;
+  float sine = (diagonals - antiDiagonals) / 2;
+  // Parallel bars at any angle score between 0.59 and 0.83 before scaling
+  return std::min(1.0f, 1.5f * std::sqrt(cosine * cosine + sine * sine) / mean);
+}
+
+class ByTransitionsDescending {
+private:
+  vector<int> const& transitions_;
+public:
+  ByTransitionsDescending(vector<int> const& transitions) : transitions_(transitions) {}
+  bool operator()(int a, int b) const {
+    return transitions_[a] > transitions_[b];
+  }
+};
+
+}
+
+const float RegionProposer::LINEAR_COHERENCE = 0.8f;
+const float RegionProposer::STACKED_COHERENCE = 0.4f;
+
+vector<RegionProposer::Proposal> RegionProposer::propose(Ref<BitMatrix> image) {
+  int width = image->getWidth();
+  int height = image->getHeight();
+  int cellsX = (width + CELL_SIZE - 1) / CELL_SIZE;
+  int cellsY = (height + CELL_SIZE - 1) / CELL_SIZE;
+
+  // A cell is one word of CELL_SIZE rows; each row is compared with itself
+  // shifted by a pixel and with the row below
+  vector<CellStats> cells(cellsX * cellsY);
+  Ref<BitArray> row = image->getRow(0, Ref<BitArray>());
+  Ref<BitArray> below;
+  for (int y = 0; y + 1 < height; y++) {
+    below = image->getRow(y + 1, below);
+    vector<int> const& words = row->getBitArray();
+    vector<int> const& belowWords = below->getBitArray();
+    CellStats* cellRow = &cells[(y / CELL_SIZE) * cellsX];
+    for (int x = 0; x < cellsX; x++) {
+      unsigned int pixels = (unsigned int) words[x];
+      unsigned int right = nextPixels(words, x);
+      unsigned int under = (unsigned int) belowWords[x];
+      unsigned int underRight = nextPixels(belowWords, x);
+      CellStats& stats = cellRow[x];
+      stats.rows += bitCount(pixels ^ right);
+      stats.columns += bitCount(pixels ^ under);
+      stats.diagonals += bitCount(pixels ^ underRight);
+      stats.antiDiagonals += bitCount(right ^ under);
+    }
+    std::swap(row, below);
+  }
+
+  Ref<BitMatrix> busy(new BitMatrix(cellsX, cellsY));
+  for (int y = 0; y < cellsY; y++) {
+    for (int x = 0; x < cellsX; x++) {
+      CellStats const& stats = cells[y * cellsX + x];
+      int most = std::max(std::max(stats.rows, stats.columns),
+                          std::max(stats.diagonals, stats.antiDiagonals));
+      if (most >= MIN_TRANSITIONS) {
+        busy->set(x, y);
+      }
+    }
+  }
+
+  vector<ConnectedComponents::Component> components = ConnectedComponents::find(busy, 1);
+  vector<CellStats> totals(components.size());
+  vector<int> transitions(components.size());
+  vector<int> order(components.size());
+  for (size_t i = 0; i < components.size(); i++) {
+    ConnectedComponents::Component const& component = components[i];
+    CellStats& total = totals[i];
+    for (int y = component.top; y < component.bottom; y++) {
+      for (int x = component.left; x < component.right; x++) {
+        if (busy->get(x, y)) {
+          CellStats const& stats = cells[y * cellsX + x];
+          total.rows += stats.rows;
+          total.columns += stats.columns;
+          total.diagonals += stats.diagonals;
+          total.antiDiagonals += stats.antiDiagonals;
+        }
+      }
+    }
+    transitions[i] = total.rows + total.columns;
+    order[i] = (int) i;
+  }
+  std::stable_sort(order.begin(), order.end(), ByTransitionsDescending(transitions));
+  if ((int) order.size() > MAX_PROPOSALS) {
+    order.resize(MAX_PROPOSALS);
+  }
+
+  vector<Proposal> proposals;
+  for (size_t i = 0; i < order.size(); i++) {
+    ConnectedComponents::Component const& component = components[order[i]];
+    // One cell of margin for the quiet zone and the symbol's sparse edges
+    int left = std::max(0, (component.left - 1) * CELL_SIZE);
+    int top = std::max(0, (component.top - 1) * CELL_SIZE);
+    int right = std::min(width, (component.right + 1) * CELL_SIZE);
+    int bottom = std::min(height, (component.bottom + 1) * CELL_SIZE);
+
+    float coherence = coherenceOf(totals[order[i]]);
+    Kind kind = MATRIX;
+    if (coherence >= LINEAR_COHERENCE) {
+      kind = LINEAR;
+    } else if (coherence >= STACKED_COHERENCE) {
+      kind = STACKED;
+    }
+    proposals.push_back(Proposal(DecodeHints::Region(left, top, right - left, bottom - top),
+                                 kind, coherence));
+  }
+  return proposals;
+}
@@ -0,0 +1,77 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __REGION_PROPOSER_H__
+#define __REGION_PROPOSER_H__
+
+/*
+ *  RegionProposer.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/BitMatrix.h>
+#include <zxing/DecodeHints.h>
+#include <vector>
+
+namespace zxing {
+
+/**
+ * Finds the parts of a black matrix that look like barcodes, so that readers
+ * need not search the background. The matrix is divided into cells one word
+ * wide and as many rows tall, and for each cell the black/white transitions
+ * between neighbouring pixels are counted along the rows, the columns and
+ * both diagonals. Cells busy enough in some direction are joined into
+ * connected regions.
+ *
+ * The four counts also give the orientation coherence of a region: bars
+ * cross far more transitions across them than along them, whatever their
+ * angle, while the modules of a matrix symbol have edges both ways. Coherent
+ * regions are proposed as 1D symbols, incoherent ones as matrix symbols and
+ * those in between, bars broken into rows, as stacked symbols.
+ */
+class RegionProposer {
+public:
+  enum Kind {
+    LINEAR,
+    MATRIX,
+    STACKED
+  };
+
+  struct Proposal {
+    DecodeHints::Region region;
+    Kind kind;
+    // 0 for edges in all directions alike, 1 for parallel bars
+    float coherence;
+    Proposal(DecodeHints::Region const& region_, Kind kind_, float coherence_)
+      : region(region_), kind(kind_), coherence(coherence_) {}
+  };
+
+  // The busiest regions first
+  static std::vector<Proposal> propose(Ref<BitMatrix> image);
+
+private:
+  static const int CELL_SIZE = 32;
+  // Transitions a cell needs in its busiest direction, one every 20 pixels
+  static const int MIN_TRANSITIONS = CELL_SIZE * CELL_SIZE / 20;
+  static const int MAX_PROPOSALS = 16;
+  static const float LINEAR_COHERENCE;
+  static const float STACKED_COHERENCE;
+
+  RegionProposer();
+};
+
+}
+
+#endif // __REGION_PROPOSER_H__
@@ -42,9 +42,9 @@ namespace {
 }
   
 GenericGF::GenericGF(int primitive_, int size_, int b)
-  : size(size_), primitive(primitive_), generatorBase(b), initialized(false) {
+  : size(size_), primitive(primitive_), generatorBase(b) {
   if (size <= INITIALIZATION_THRESHOLD) {
-    initialize();
+    checkInit();
   }
 }
   
@@ -72,13 +72,10 @@ void GenericGF::initialize() {
   one =
     Ref<GenericGFPoly>(new GenericGFPoly(Ref<GenericGF>(this), ArrayRef<int>(new Array<int>(1))));
   one->getCoefficients()[0] = 1;
-  initialized = true;
 }
   
 void GenericGF::checkInit() {
-  if (!initialized) {
-    initialize();
-  }
+  std::call_once(initOnce, &GenericGF::initialize, this);
 }
   
 Ref<GenericGFPoly> GenericGF::getZero() {
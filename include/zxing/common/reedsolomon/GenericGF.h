@@ -23,6 +23,7 @@
 #define GENERICGF_H
 
 #include <vector>
+#include <mutex>
 #include <zxing/common/Counted.h>
 
 namespace zxing {
@@ -38,7 +39,9 @@ namespace zxing {
     int size;
     int primitive;
     int generatorBase;
-    bool initialized;
+    // The fields are shared statics, decoders running on different threads may be the
+    // first to use one at the same time
+    std::once_flag initOnce;
     
     void initialize();
     void checkInit();
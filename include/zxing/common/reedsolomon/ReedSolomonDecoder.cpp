@@ -23,6 +23,8 @@
 #include <zxing/common/reedsolomon/ReedSolomonException.h>
 #include <zxing/common/IllegalArgumentException.h>
 #include <zxing/IllegalStateException.h>
+#include <zxing/common/Metrics.h>
+#include <zxing/common/Trace.h>
 
 using std::vector;
 using zxing::Ref;
@@ -30,6 +32,7 @@ using zxing::ArrayRef;
 using zxing::ReedSolomonDecoder;
 using zxing::GenericGFPoly;
 using zxing::IllegalStateException;
+using zxing::Metrics;
 
 // VC++
 using zxing::GenericGF;
@@ -40,6 +43,9 @@ ReedSolomonDecoder::~ReedSolomonDecoder() {
 }
 
 void ReedSolomonDecoder::decode(ArrayRef<int> received, int twoS) {
+  ZXING_TRACE_SPAN("ReedSolomonDecoder::decode");
+  static const Metrics::Histogram latency = Metrics::stage("rs_correct");
+  Metrics::Timer timer(latency);
   Ref<GenericGFPoly> poly(new GenericGFPoly(field, received));
   ArrayRef<int> syndromeCoefficients(twoS);
   bool noError = true;
@@ -21,6 +21,7 @@
 
 #include <zxing/datamatrix/DataMatrixReader.h>
 #include <zxing/datamatrix/detector/Detector.h>
+#include <zxing/common/Trace.h>
 #include <iostream>
 
 namespace zxing {
@@ -33,11 +34,12 @@ DataMatrixReader::DataMatrixReader() :
 }
 
 Ref<Result> DataMatrixReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
-  (void)hints;
+  ZXING_TRACE_SPAN("DataMatrixReader::decode");
+  hints.checkCancelled();
   Detector detector(image->getBlackMatrix());
   Ref<DetectorResult> detectorResult(detector.detect());
   ArrayRef< Ref<ResultPoint> > points(detectorResult->getPoints());
-
+  hints.checkCancelled();
 
   Ref<DecoderResult> decoderResult(decoder_.decode(detectorResult->getBits()));
 
@@ -23,6 +23,7 @@
 #include <zxing/datamatrix/decoder/DecodedBitStreamParser.h>
 #include <iostream>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/StringUtils.h>
 
 namespace zxing {
 namespace datamatrix {
@@ -88,7 +89,12 @@ Ref<DecoderResult> DecodedBitStreamParser::decode(ArrayRef<char> bytes) {
     result << resultTrailer.str();
   }
   ArrayRef<char> rawBytes(bytes);
-  Ref<String> text(new String(result.str()));
+  // Upper shift and Base 256 produce ISO-8859-1 bytes; hand back UTF-8
+  // like the other 2D decoders.
+  string latin1 = result.str();
+  string utf8;
+  common::StringUtils::append(utf8, latin1.data(), latin1.size(), common::StringUtils::ISO88591);
+  Ref<String> text(new String(utf8));
   return Ref<DecoderResult>(new DecoderResult(rawBytes, text));
 }
 
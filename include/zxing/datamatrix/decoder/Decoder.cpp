@@ -26,6 +26,7 @@
 #include <zxing/ReaderException.h>
 #include <zxing/ChecksumException.h>
 #include <zxing/common/reedsolomon/ReedSolomonException.h>
+#include <zxing/common/Metrics.h>
 
 using zxing::Ref;
 using zxing::DecoderResult;
@@ -34,6 +35,7 @@ using zxing::datamatrix::Decoder;
 // VC++
 using zxing::ArrayRef;
 using zxing::BitMatrix;
+using zxing::Metrics;
 
 Decoder::Decoder() : rsDecoder_(GenericGF::DATA_MATRIX_FIELD_256) {}
 
@@ -64,6 +66,14 @@ Ref<DecoderResult> Decoder::decode(Ref<BitMatrix> bits) {
 
   // Read codewords
   ArrayRef<char> codewords(parser.readCodewords());
+
+  // The same label seen again samples to the same codewords
+  std::string key = DecoderResultCache::makeKey(version->getVersionNumber(), 0, codewords);
+  Ref<DecoderResult> cached = resultCache_.get(key);
+  if (!cached.empty()) {
+    return cached;
+  }
+
   // Separate into data blocks
   std::vector<Ref<DataBlock> > dataBlocks = DataBlock::getDataBlocks(codewords, version);
 
@@ -88,6 +98,17 @@ Ref<DecoderResult> Decoder::decode(Ref<BitMatrix> bits) {
     }
   }
   // Decode the contents of that stream of bytes
-  DecodedBitStreamParser decodedBSParser;
-  return Ref<DecoderResult> (decodedBSParser.decode(resultBytes));
+  Ref<DecoderResult> result;
+  {
+    static const Metrics::Histogram parsing = Metrics::stage("parse");
+    Metrics::Timer timer(parsing);
+    DecodedBitStreamParser decodedBSParser;
+    result = decodedBSParser.decode(resultBytes);
+  }
+  resultCache_.put(key, result);
+  return result;
+}
+
+zxing::DecoderResultCache& Decoder::getResultCache() {
+  return resultCache_;
 }
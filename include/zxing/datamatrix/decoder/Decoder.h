@@ -25,6 +25,7 @@
 #include <zxing/common/Counted.h>
 #include <zxing/common/Array.h>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/DecoderResultCache.h>
 #include <zxing/common/BitMatrix.h>
 
 
@@ -34,6 +35,7 @@ namespace datamatrix {
 class Decoder {
 private:
   ReedSolomonDecoder rsDecoder_;
+  DecoderResultCache resultCache_;
 
   void correctErrors(ArrayRef<char> bytes, int numDataCodewords);
 
@@ -41,6 +43,7 @@ public:
   Decoder();
 
   Ref<DecoderResult> decode(Ref<BitMatrix> bits);
+  DecoderResultCache& getResultCache();
 };
 
 }
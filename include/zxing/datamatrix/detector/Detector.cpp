@@ -25,6 +25,7 @@
 #include <zxing/datamatrix/detector/Detector.h>
 #include <zxing/common/detector/MathUtils.h>
 #include <zxing/NotFoundException.h>
+#include <zxing/common/Trace.h>
 #include <sstream>
 #include <cstdlib>
 
@@ -80,6 +81,7 @@ Ref<BitMatrix> Detector::getImage() {
 }
 
 Ref<DetectorResult> Detector::detect() {
+  ZXING_TRACE_SPAN("datamatrix::Detector::detect");
   Ref<WhiteRectangleDetector> rectangleDetector_(new WhiteRectangleDetector(image_));
   std::vector<Ref<ResultPoint> > ResultPoints = rectangleDetector_->detect();
   Ref<ResultPoint> pointA = ResultPoints[0];
@@ -218,6 +220,11 @@ Ref<DetectorResult> Detector::detect() {
       dimensionRight++;
     }
 
+    // A corrected corner on the wrong side of a blank edge crosses no modules at all
+    if (dimensionTop == 0 || dimensionRight == 0) {
+      throw NotFoundException();
+    }
+
     transform = createTransform(topLeft, correctedTopRight, bottomLeft, bottomRight, dimensionTop,
                                 dimensionRight);
     bits = sampleGrid(image_, dimensionTop, dimensionRight, transform);
@@ -24,6 +24,25 @@ ByQuadrantReader::ByQuadrantReader(Reader& delegate) : delegate_(delegate) {}
 
 ByQuadrantReader::~ByQuadrantReader(){}
 
+// Crops carry their offset within the frame; move the result points from the quadrant back into
+// the coordinates of the image that was passed in
+Ref<Result> ByQuadrantReader::translateResultPoints(Ref<Result> result,
+                                                    Ref<BinaryBitmap> image,
+                                                    Ref<BinaryBitmap> quadrant) {
+  int xOffset = quadrant->getLeft() - image->getLeft();
+  int yOffset = quadrant->getTop() - image->getTop();
+  ArrayRef< Ref<ResultPoint> > oldResultPoints = result->getResultPoints();
+  if (oldResultPoints->empty() || (xOffset == 0 && yOffset == 0)) {
+    return result;
+  }
+  ArrayRef< Ref<ResultPoint> > newResultPoints(oldResultPoints->size());
+  for (int i = 0; i < oldResultPoints->size(); i++) {
+    Ref<ResultPoint> oldPoint = oldResultPoints[i];
+    newResultPoints[i] = Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset));
+  }
+  return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints, result->getBarcodeFormat()));
+}
+
 Ref<Result> ByQuadrantReader::decode(Ref<BinaryBitmap> image){
   return decode(image, DecodeHints::DEFAULT_HINT);
 }
@@ -35,7 +54,7 @@ Ref<Result> ByQuadrantReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
   int halfHeight = height / 2;
   Ref<BinaryBitmap> topLeft = image->crop(0, 0, halfWidth, halfHeight);
   try {
-    return delegate_.decode(topLeft, hints);
+    return translateResultPoints(delegate_.decode(topLeft, hints), image, topLeft);
   } catch (ReaderException const& re) {
     (void)re;
     // continue
@@ -43,7 +62,7 @@ Ref<Result> ByQuadrantReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
 
   Ref<BinaryBitmap> topRight = image->crop(halfWidth, 0, halfWidth, halfHeight);
   try {
-    return delegate_.decode(topRight, hints);
+    return translateResultPoints(delegate_.decode(topRight, hints), image, topRight);
   } catch (ReaderException const& re) {
     (void)re;
     // continue
@@ -51,7 +70,7 @@ Ref<Result> ByQuadrantReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
 
   Ref<BinaryBitmap> bottomLeft = image->crop(0, halfHeight, halfWidth, halfHeight);
   try {
-    return delegate_.decode(bottomLeft, hints);
+    return translateResultPoints(delegate_.decode(bottomLeft, hints), image, bottomLeft);
   } catch (ReaderException const& re) {
     (void)re;
     // continue
@@ -59,7 +78,7 @@ Ref<Result> ByQuadrantReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
 
   Ref<BinaryBitmap> bottomRight = image->crop(halfWidth, halfHeight, halfWidth, halfHeight);
   try {
-    return delegate_.decode(bottomRight, hints);
+    return translateResultPoints(delegate_.decode(bottomRight, hints), image, bottomRight);
   } catch (ReaderException const& re) {
     (void)re;
     // continue
@@ -68,7 +87,7 @@ Ref<Result> ByQuadrantReader::decode(Ref<BinaryBitmap> image, DecodeHints hints)
   int quarterWidth = halfWidth / 2;
   int quarterHeight = halfHeight / 2;
   Ref<BinaryBitmap> center = image->crop(quarterWidth, quarterHeight, halfWidth, halfHeight);
-  return delegate_.decode(center, hints);
+  return translateResultPoints(delegate_.decode(center, hints), image, center);
 }
 
 } // End zxing::multi namespace
@@ -29,6 +29,10 @@ class ByQuadrantReader : public Reader {
   private:
     Reader& delegate_;
 
+    static Ref<Result> translateResultPoints(Ref<Result> result,
+                                             Ref<BinaryBitmap> image,
+                                             Ref<BinaryBitmap> quadrant);
+
   public:
     ByQuadrantReader(Reader& delegate);
     virtual ~ByQuadrantReader();
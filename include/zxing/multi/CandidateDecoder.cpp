@@ -0,0 +1,188 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  CandidateDecoder.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/CandidateDecoder.h>
+#include <zxing/ReaderException.h>
+#include <zxing/TimeoutException.h>
+#include <zxing/ResultPoint.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+
+using std::vector;
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::Result;
+using zxing::ResultPoint;
+using zxing::BitMatrix;
+using zxing::DecodeHints;
+using zxing::multi::CandidateDecoder;
+
+// VC++
+using zxing::Exception;
+using zxing::ReaderException;
+using zxing::TimeoutException;
+
+namespace {
+
+// The white rectangle detectors start from a 30 pixel square around the
+// center of their image, smaller windows are grown to fit one
+const int MIN_WINDOW = 40;
+
+// What the threads decoding one set of windows share
+struct Work {
+  vector<Ref<BitMatrix> > const& windows;
+  vector<DecodeHints::Region> const& regions;
+  CandidateDecoder::DecodeWindow decodeWindow;
+  DecodeHints const& hints;
+
+  std::atomic<int> next;
+  std::atomic<bool> done;
+
+  std::mutex lock;
+  bool timedOut;
+  // By window; empty for those that did not decode and for duplicates
+  vector<Ref<Result> > results;
+  // Indices of the windows with a result
+  vector<int> kept;
+  vector<Ref<Result> > found;
+
+  Work(vector<Ref<BitMatrix> > const& windows_, vector<DecodeHints::Region> const& regions_,
+       CandidateDecoder::DecodeWindow decodeWindow_, DecodeHints const& hints_)
+    : windows(windows_), regions(regions_), decodeWindow(decodeWindow_), hints(hints_), next(0),
+      done(false), timedOut(false), results(windows_.size()) {}
+};
+
+bool overlaps(DecodeHints::Region const& a, DecodeHints::Region const& b) {
+  return a.left < b.left + b.width && b.left < a.left + a.width &&
+         a.top < b.top + b.height && b.top < a.top + a.height;
+}
+
+// Adds the result of window i unless an overlapping window already read
+// the same symbol, in which case the first of the two windows keeps it.
+// Called under the lock, so duplicates never count towards isSatisfiedBy.
+void keep(Work* work, int i, Ref<Result> result) {
+  for (size_t k = 0; k < work->kept.size(); k++) {
+    int other = work->kept[k];
+    Ref<Result> otherResult = work->results[other];
+    if (overlaps(work->regions[i], work->regions[other]) &&
+        otherResult->getBarcodeFormat() == result->getBarcodeFormat() &&
+        otherResult->getText()->getText() == result->getText()->getText()) {
+      if (i < other) {
+        work->results[i] = result;
+        work->results[other] = Ref<Result>();
+        work->kept[k] = i;
+      }
+      return;
+    }
+  }
+  work->results[i] = result;
+  work->kept.push_back(i);
+  work->found.push_back(result);
+  if (work->hints.isSatisfiedBy(work->found)) {
+    work->done = true;
+  }
+}
+
+void decodeWindows(Work* work) {
+  for (;;) {
+    int i = work->next.fetch_add(1);
+    if (work->done || i >= (int) work->windows.size()) {
+      return;
+    }
+    Ref<Result> result;
+    try {
+      result = work->decodeWindow(work->windows[i], work->hints);
+    } catch (TimeoutException const&) {
+      std::lock_guard<std::mutex> guard(work->lock);
+      work->timedOut = true;
+      work->done = true;
+      return;
+    } catch (Exception const&) {
+      // Not a symbol after all, or one that does not decode
+      continue;
+    }
+    std::lock_guard<std::mutex> guard(work->lock);
+    keep(work, i, result);
+  }
+}
+
+Ref<Result> translateResultPoints(Ref<Result> result, int xOffset, int yOffset) {
+  ArrayRef< Ref<ResultPoint> > oldResultPoints = result->getResultPoints();
+  if (!oldResultPoints || oldResultPoints->empty()) {
+    return result;
+  }
+  ArrayRef< Ref<ResultPoint> > newResultPoints(oldResultPoints->size());
+  for (int i = 0; i < oldResultPoints->size(); i++) {
+    Ref<ResultPoint> oldPoint = oldResultPoints[i];
+    newResultPoints[i] = Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset));
+  }
+  return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints,
+                                result->getBarcodeFormat()));
+}
+
+}
+
+vector<Ref<Result> > CandidateDecoder::decode(Ref<BitMatrix> image,
+                                              vector<DecodeHints::Region> const& regions,
+                                              int quietZone,
+                                              DecodeWindow decodeWindow,
+                                              DecodeHints const& hints) {
+  // Cut the windows out up front, the threads never touch the shared matrix
+  vector<Ref<BitMatrix> > windows;
+  vector<int> margins;
+  for (size_t i = 0; i < regions.size(); i++) {
+    DecodeHints::Region const& region = regions[i];
+    int margin = std::max(quietZone, (MIN_WINDOW - std::min(region.width, region.height) + 1) / 2);
+    windows.push_back(image->window(region.left, region.top, region.width, region.height, margin));
+    margins.push_back(margin);
+  }
+
+  // The windows are what is spread over the threads; each is decoded on one
+  DecodeHints windowHints(hints);
+  windowHints.setThreads(1);
+  Work work(windows, regions, decodeWindow, windowHints);
+  int threads = std::min(hints.getThreads(), (int) windows.size());
+  vector<std::thread> pool;
+  for (int i = 1; i < threads; i++) {
+    pool.push_back(std::thread(decodeWindows, &work));
+  }
+  decodeWindows(&work);
+  for (size_t i = 0; i < pool.size(); i++) {
+    pool[i].join();
+  }
+
+  vector<Ref<Result> > results;
+  for (size_t i = 0; i < windows.size(); i++) {
+    if (work.results[i]) {
+      results.push_back(translateResultPoints(work.results[i],
+                                              regions[i].left - margins[i],
+                                              regions[i].top - margins[i]));
+    }
+  }
+  if (results.empty()) {
+    if (work.timedOut) {
+      throw TimeoutException("Decode timed out");
+    }
+    throw ReaderException("No code detected");
+  }
+  return results;
+}
@@ -0,0 +1,62 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __CANDIDATE_DECODER_H__
+#define __CANDIDATE_DECODER_H__
+
+/*
+ *  CandidateDecoder.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/BitMatrix.h>
+#include <zxing/Result.h>
+#include <zxing/DecodeHints.h>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Decodes the candidate regions a multi detector found in a black matrix.
+ * Each region is copied into a window of its own with a white quiet zone
+ * around it, so that the single symbol detectors see one symbol centered in
+ * their image, and the windows are decoded on as many threads as the hints
+ * allow. A window is handed to a decode function that builds its own
+ * detector and decoder; the windows are the only data the threads see, and
+ * no two share one. A symbol read in two overlapping windows is reported
+ * once, and counts once towards the hints' expected count.
+ */
+class CandidateDecoder {
+public:
+  // Detects and decodes the one symbol expected in window, throws if there is none
+  typedef Ref<Result> (*DecodeWindow)(Ref<BitMatrix> window, DecodeHints const& hints);
+
+  // Results in the order of their regions, with points in image coordinates. Throws
+  // ReaderException if no region decodes, TimeoutException if time ran out first.
+  static std::vector<Ref<Result> > decode(Ref<BitMatrix> image,
+                                          std::vector<DecodeHints::Region> const& regions,
+                                          int quietZone,
+                                          DecodeWindow decodeWindow,
+                                          DecodeHints const& hints);
+
+private:
+  CandidateDecoder();
+};
+
+}
+}
+
+#endif // __CANDIDATE_DECODER_H__
@@ -0,0 +1,263 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  DecodePool.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/DecodePool.h>
+#include <zxing/common/GlobalHistogramBinarizer.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/MultiFormatReader.h>
+#include <zxing/BinaryBitmap.h>
+#include <zxing/CancellationToken.h>
+#include <zxing/TimeoutException.h>
+#include <zxing/Exception.h>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#elif defined(_WIN32)
+#include <windows.h>
+#endif
+
+using std::vector;
+using zxing::Ref;
+using zxing::LuminanceSource;
+using zxing::DecodeHints;
+using zxing::multi::DecodePool;
+
+// VC++
+using zxing::Binarizer;
+using zxing::BinaryBitmap;
+using zxing::GlobalHistogramBinarizer;
+using zxing::MultiFormatReader;
+using zxing::CancellationToken;
+using zxing::Exception;
+using zxing::TimeoutException;
+using zxing::IllegalArgumentException;
+using zxing::Metrics;
+using zxing::BarcodeFormat;
+
+DecodePool::DecodePool(DecodeHints const& hints, Listener& listener, int threads, vector<int> const& cpus,
+                       int budgetMs, int maxPending)
+    : hints_(hints), listener_(listener), cpus_(cpus), budgetMs_(budgetMs), maxPending_(maxPending),
+      queued_(0), running_(0), stopping_(false),
+      queuedFrames_(Metrics::gauge("zxing_pool_queued_frames", "Frames waiting for a decode worker")),
+      busyWorkers_(Metrics::gauge("zxing_pool_busy_workers", "Decode workers with a frame")) {
+  if (maxPending < 1) {
+    throw IllegalArgumentException("A source must be allowed a frame in flight.");
+  }
+  if (threads <= 0) {
+    threads = (int) std::thread::hardware_concurrency();
+  }
+  if (threads <= 0) {
+    threads = 1;
+  }
+  for (int i = 0; i < threads; i++) {
+    queues_.push_back(new Queue());
+  }
+  for (int i = 0; i < threads; i++) {
+    workers_.push_back(std::thread(&DecodePool::run, this, i));
+  }
+}
+
+DecodePool::~DecodePool() {
+  {
+    std::lock_guard<std::mutex> guard(idleLock_);
+    stopping_ = true;
+  }
+  work_.notify_all();
+  for (size_t i = 0; i < workers_.size(); i++) {
+    workers_[i].join();
+  }
+  for (size_t i = 0; i < queues_.size(); i++) {
+    delete queues_[i];
+  }
+  for (size_t i = 0; i < sources_.size(); i++) {
+    delete sources_[i];
+  }
+}
+
+int DecodePool::addSource() {
+  std::lock_guard<std::mutex> guard(sourcesLock_);
+  sources_.push_back(new Source());
+  return (int) sources_.size() - 1;
+}
+
+DecodePool::Source* DecodePool::sourceAt(int source) {
+  std::lock_guard<std::mutex> guard(sourcesLock_);
+  if (source < 0 || source >= (int) sources_.size()) {
+    throw IllegalArgumentException("No such source.");
+  }
+  return sources_[source];
+}
+
+void DecodePool::submit(int source, Ref<LuminanceSource> frame) {
+  Source* state = sourceAt(source);
+  Job job;
+  job.source = source;
+  job.image = frame;
+  {
+    std::unique_lock<std::mutex> guard(state->lock);
+    while (state->submitted - state->delivered >= maxPending_) {
+      state->room.wait(guard);
+    }
+    job.frame = state->submitted++;
+  }
+
+  Queue* queue = queues_[source % queues_.size()];
+  {
+    std::lock_guard<std::mutex> guard(queue->lock);
+    queue->jobs.push_back(job);
+  }
+  {
+    std::lock_guard<std::mutex> guard(idleLock_);
+    queued_++;
+    queuedFrames_.add(1);
+  }
+  work_.notify_one();
+}
+
+void DecodePool::drain() {
+  std::unique_lock<std::mutex> guard(idleLock_);
+  while (queued_ > 0 || running_ > 0) {
+    drained_.wait(guard);
+  }
+}
+
+// The worker's own queue first, then the others' in turn
+bool DecodePool::take(int worker, Job& job) {
+  int count = (int) queues_.size();
+  for (int i = 0; i < count; i++) {
+    Queue* queue = queues_[(worker + i) % count];
+    std::lock_guard<std::mutex> guard(queue->lock);
+    if (!queue->jobs.empty()) {
+      job = queue->jobs.front();
+      queue->jobs.pop_front();
+      return true;
+    }
+  }
+  return false;
+}
+
+void DecodePool::run(int worker) {
+  if (!cpus_.empty()) {
+    vector<int> cpu(1, cpus_[worker % cpus_.size()]);
+    pinCurrentThread(cpu);
+  }
+
+  // Readers keep state between decodes, so every worker has its own
+  MultiFormatReader reader;
+  reader.setHints(hints_);
+  for (;;) {
+    {
+      std::unique_lock<std::mutex> guard(idleLock_);
+      while (queued_ == 0 && !stopping_) {
+        work_.wait(guard);
+      }
+      if (queued_ == 0) {
+        return;
+      }
+      queued_--;
+      running_++;
+      queuedFrames_.add(-1);
+      busyWorkers_.add(1);
+    }
+
+    Job job;
+    // Other workers take jobs while this one scans, so a pass can miss the one reserved
+    while (!take(worker, job)) {
+      std::this_thread::yield();
+    }
+
+    Outcome outcome;
+    outcome.source = job.source;
+    outcome.frame = job.frame;
+    outcome.timedOut = false;
+    DecodeHints hints(hints_);
+    if (budgetMs_ > 0) {
+      hints.setCancellationToken(Ref<CancellationToken>(new CancellationToken(budgetMs_)));
+    }
+    reader.setHints(hints);
+    try {
+      Ref<BinaryBitmap> bitmap(new BinaryBitmap(Ref<Binarizer>(new GlobalHistogramBinarizer(job.image))));
+      outcome.result = reader.decodeWithState(bitmap);
+      Metrics::frame(outcome.result->getBarcodeFormat(), false);
+    } catch (TimeoutException const& e) {
+      Metrics::frame(BarcodeFormat::NONE, true);
+      outcome.timedOut = true;
+      outcome.error = e.what();
+    } catch (Exception const& e) {
+      Metrics::frame(BarcodeFormat::NONE, false);
+      outcome.error = e.what();
+    }
+    // The frame's buffer goes back to its camera before the listener runs
+    job.image = Ref<LuminanceSource>();
+    finish(outcome);
+
+    {
+      std::lock_guard<std::mutex> guard(idleLock_);
+      running_--;
+      busyWorkers_.add(-1);
+      if (queued_ == 0 && running_ == 0) {
+        drained_.notify_all();
+      }
+    }
+  }
+}
+
+// Holds a finished frame back until every earlier frame of its source has
+// been delivered, then delivers all that are ready
+void DecodePool::finish(Outcome const& outcome) {
+  Source* state = sourceAt(outcome.source);
+  std::lock_guard<std::mutex> guard(state->lock);
+  state->finished[outcome.frame] = outcome;
+  while (!state->finished.empty() && state->finished.begin()->first == state->delivered) {
+    listener_.decoded(state->finished.begin()->second);
+    state->finished.erase(state->finished.begin());
+    state->delivered++;
+  }
+  state->room.notify_all();
+}
+
+bool DecodePool::pinCurrentThread(vector<int> const& cpus) {
+  if (cpus.empty()) {
+    return false;
+  }
+#if defined(__linux__)
+  cpu_set_t set;
+  CPU_ZERO(&set);
+  for (size_t i = 0; i < cpus.size(); i++) {
+    if (cpus[i] < 0 || cpus[i] >= CPU_SETSIZE) {
+      return false;
+    }
+    CPU_SET(cpus[i], &set);
+  }
+  return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#elif defined(_WIN32)
+  DWORD_PTR mask = 0;
+  for (size_t i = 0; i < cpus.size(); i++) {
+    if (cpus[i] < 0 || cpus[i] >= (int) (8 * sizeof(mask))) {
+      return false;
+    }
+    mask |= (DWORD_PTR) 1 << cpus[i];
+  }
+  return SetThreadAffinityMask(GetCurrentThread(), mask) != 0;
+#else
+  return false;
+#endif
+}
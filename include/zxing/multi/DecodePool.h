@@ -0,0 +1,152 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __DECODE_POOL_H__
+#define __DECODE_POOL_H__
+
+/*
+ *  DecodePool.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/LuminanceSource.h>
+#include <zxing/Result.h>
+#include <zxing/DecodeHints.h>
+#include <zxing/common/Metrics.h>
+#include <condition_variable>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Decodes the frames of several sources, such as the cameras of one
+ * station, on one set of worker threads.
+ *
+ * Every worker has its own queue. A source's frames go to the queue of one
+ * worker, chosen by source id, and a worker whose queue is empty takes the
+ * oldest frame from another's. A busy camera thus spreads over all workers
+ * while the others are idle, and each worker keeps its own readers, so
+ * their learned format order is per worker rather than per source.
+ *
+ * Frames finish in any order but are handed to the listener in the order
+ * they were submitted, per source. The listener is called from the worker
+ * threads, never twice at once for the same source.
+ *
+ * submit() blocks while a source has maxPending frames in flight, so a
+ * camera outrunning the decoders holds on to at most that many buffers.
+ */
+class DecodePool : public Counted {
+public:
+  struct Outcome {
+    int source;
+    // Counts the source's frames from 0, in submission order
+    long long frame;
+    // Empty when nothing was found
+    Ref<Result> result;
+    std::string error;
+    bool timedOut;
+  };
+
+  class Listener {
+  public:
+    virtual ~Listener() {}
+    virtual void decoded(Outcome const& outcome) = 0;
+  };
+
+  static const int DEFAULT_MAX_PENDING = 4;
+
+  // threads 0 means one per core. Workers are pinned to cpus round-robin
+  // when it is not empty; budgetMs bounds each frame's decode when above 0.
+  DecodePool(DecodeHints const& hints, Listener& listener, int threads = 0,
+             std::vector<int> const& cpus = std::vector<int>(), int budgetMs = 0,
+             int maxPending = DEFAULT_MAX_PENDING);
+  // Finishes every frame already submitted
+  ~DecodePool();
+
+  // Returns the id that submit() takes and outcomes carry
+  int addSource();
+  void submit(int source, Ref<LuminanceSource> frame);
+  // Waits until every frame submitted so far has reached the listener
+  void drain();
+
+  int getThreads() const { return (int) workers_.size(); }
+
+  // Restricts the calling thread to the given CPUs. Returns false where
+  // that is not supported or the CPUs do not exist.
+  static bool pinCurrentThread(std::vector<int> const& cpus);
+
+private:
+  struct Job {
+    int source;
+    long long frame;
+    Ref<LuminanceSource> image;
+  };
+
+  struct Queue {
+    std::mutex lock;
+    std::deque<Job> jobs;
+  };
+
+  struct Source {
+    std::mutex lock;
+    std::condition_variable room;
+    long long submitted;
+    long long delivered;
+    std::map<long long, Outcome> finished;
+    Source() : submitted(0), delivered(0) {}
+  };
+
+  const DecodeHints hints_;
+  Listener& listener_;
+  const std::vector<int> cpus_;
+  const int budgetMs_;
+  const int maxPending_;
+
+  std::vector<Queue*> queues_;
+  std::vector<std::thread> workers_;
+
+  std::mutex sourcesLock_;
+  std::vector<Source*> sources_;
+
+  // Queued jobs across all queues; workers sleep while it is 0
+  std::mutex idleLock_;
+  std::condition_variable work_;
+  std::condition_variable drained_;
+  int queued_;
+  int running_;
+  bool stopping_;
+  // queued_ and running_, added up over every pool in the process
+  const Metrics::Gauge queuedFrames_;
+  const Metrics::Gauge busyWorkers_;
+
+  Source* sourceAt(int source);
+  bool take(int worker, Job& job);
+  void run(int worker);
+  void finish(Outcome const& outcome);
+
+  DecodePool(DecodePool const&);
+  DecodePool& operator=(DecodePool const&);
+};
+
+}
+}
+
+#endif // __DECODE_POOL_H__
@@ -17,6 +17,7 @@
 
 #include <zxing/multi/GenericMultipleBarcodeReader.h>
 #include <zxing/ReaderException.h>
+#include <zxing/TimeoutException.h>
 #include <zxing/ResultPoint.h>
 
 using std::vector;
@@ -37,7 +38,14 @@ GenericMultipleBarcodeReader::~GenericMultipleBarcodeReader(){}
 vector<Ref<Result> > GenericMultipleBarcodeReader::decodeMultiple(Ref<BinaryBitmap> image,
                                                                   DecodeHints hints) {
   vector<Ref<Result> > results;
-  doDecodeMultiple(image, hints, results, 0, 0, 0);
+  try {
+    doDecodeMultiple(image, hints, results, 0, 0, 0);
+  } catch (TimeoutException const&) {
+    // Out of time: hand back what has been decoded so far
+    if (results.empty()) {
+      throw;
+    }
+  }
   if (results.empty()){
     throw ReaderException("No code detected");
   }
@@ -53,9 +61,14 @@ void GenericMultipleBarcodeReader::doDecodeMultiple(Ref<BinaryBitmap> image,
   if (currentDepth > MAX_DEPTH) {
     return;
   }
+  // Once every expected symbol is in, unwind without touching the remaining crops
+  if (hints.isSatisfiedBy(results)) {
+    return;
+  }
+  hints.checkCancelled();
   Ref<Result> result;
   try {
-    result = delegate_.decode(image, hints);
+    result = delegate_.decode(image, hints.forRemainingSymbols(results));
   } catch (ReaderException const& ignored) {
     (void)ignored;
     return;
@@ -128,10 +141,10 @@ Ref<Result> GenericMultipleBarcodeReader::translateResultPoints(Ref<Result> resu
   if (oldResultPoints->empty()) {
     return result;
   }
-  ArrayRef< Ref<ResultPoint> > newResultPoints;
+  ArrayRef< Ref<ResultPoint> > newResultPoints(oldResultPoints->size());
   for (int i = 0; i < oldResultPoints->size(); i++) {
     Ref<ResultPoint> oldPoint = oldResultPoints[i];
-    newResultPoints->values().push_back(Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset)));
+    newResultPoints[i] = Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset));
   }
   return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints, result->getBarcodeFormat()));
 }
@@ -0,0 +1,259 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  LineScanDecoder.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/LineScanDecoder.h>
+#include <zxing/multi/GenericMultipleBarcodeReader.h>
+#include <zxing/common/GreyscaleLuminanceSource.h>
+#include <zxing/common/GlobalHistogramBinarizer.h>
+#include <zxing/common/HybridBinarizer.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/BinaryBitmap.h>
+#include <zxing/ReaderException.h>
+#include <zxing/ResultPoint.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string.h>
+
+using std::vector;
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::Result;
+using zxing::ResultPoint;
+using zxing::DecodeHints;
+using zxing::BarcodeFormat;
+using zxing::multi::LineScanDecoder;
+
+const int LineScanDecoder::MAX_MISSED_READS;
+
+// VC++
+using zxing::BitArray;
+using zxing::BinaryBitmap;
+using zxing::LuminanceSource;
+using zxing::GreyscaleLuminanceSource;
+using zxing::GlobalHistogramBinarizer;
+using zxing::HybridBinarizer;
+using zxing::ReaderException;
+using zxing::IllegalArgumentException;
+using zxing::multi::GenericMultipleBarcodeReader;
+
+namespace {
+
+const BarcodeFormat::Value LINEAR_FORMATS[] = {
+  BarcodeFormat::CODABAR, BarcodeFormat::CODE_39, BarcodeFormat::CODE_93, BarcodeFormat::CODE_128,
+  BarcodeFormat::EAN_8, BarcodeFormat::EAN_13, BarcodeFormat::ITF, BarcodeFormat::UPC_A, BarcodeFormat::UPC_E
+};
+
+const BarcodeFormat::Value MATRIX_FORMATS[] = {
+  BarcodeFormat::AZTEC, BarcodeFormat::DATA_MATRIX, BarcodeFormat::PDF_417, BarcodeFormat::QR_CODE
+};
+
+template <size_t N>
+bool containsAny(DecodeHints const& hints, BarcodeFormat::Value const (&formats)[N]) {
+  for (size_t i = 0; i < N; i++) {
+    if (hints.containsFormat(formats[i])) {
+      return true;
+    }
+  }
+  return false;
+}
+
+// Hints that name no format mean every format, as they do for MultiFormatReader
+DecodeHints withFormats(DecodeHints const& hints) {
+  if (containsAny(hints, LINEAR_FORMATS) || containsAny(hints, MATRIX_FORMATS)) {
+    return hints;
+  }
+  return hints | DecodeHints::DEFAULT_HINT;
+}
+
+Ref<Result> translateResultPoints(Ref<Result> result, float xOffset, float yOffset, int mirrorWidth) {
+  ArrayRef< Ref<ResultPoint> > oldResultPoints = result->getResultPoints();
+  if (!oldResultPoints || oldResultPoints->empty()) {
+    return result;
+  }
+  ArrayRef< Ref<ResultPoint> > newResultPoints(oldResultPoints->size());
+  for (int i = 0; i < oldResultPoints->size(); i++) {
+    Ref<ResultPoint> oldPoint = oldResultPoints[i];
+    float x = oldPoint->getX();
+    if (mirrorWidth > 0) {
+      x = mirrorWidth - x - 1;
+    }
+    newResultPoints[i] = Ref<ResultPoint>(new ResultPoint(x + xOffset, oldPoint->getY() + yOffset));
+  }
+  return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints,
+                                result->getBarcodeFormat()));
+}
+
+}
+
+LineScanDecoder::LineScanDecoder(int width, DecodeHints const& hints, int windowRows, int rowStep)
+    : width_(width), windowRows_(windowRows), rowStep_(rowStep),
+      hints_(withFormats(hints)), matrixHints_(hints_.withoutFormats(DecodeHints::ONED_HINT)),
+      linear_(containsAny(hints_, LINEAR_FORMATS)), matrix_(containsAny(hints_, MATRIX_FORMATS)),
+      ring_(width * windowRows), rowsSeen_(0), lastWindowRow_(0) {
+  if (width < 3 || windowRows < 2 || rowStep < 1) {
+    throw IllegalArgumentException("Line scan window is too small.");
+  }
+  if (linear_) {
+    oneDReader_ = new oned::MultiFormatOneDReader(hints_);
+  }
+  if (matrix_) {
+    matrixReader_.setHints(matrixHints_);
+  }
+}
+
+vector<Ref<Result> > LineScanDecoder::addRows(void const* data, int rows, int rowBytes) {
+  vector<Ref<Result> > results;
+  unsigned char const* pixels = (unsigned char const*) data;
+  for (int y = 0; y < rows; y++) {
+    int slot = (int) (rowsSeen_ % windowRows_);
+    memcpy(&ring_[slot * width_], pixels + (size_t) y * rowBytes, width_);
+    long long streamRow = rowsSeen_++;
+    if (linear_ && streamRow % rowStep_ == 0) {
+      decodeRow(slot, streamRow, results);
+    }
+    if (matrix_ && rowsSeen_ - lastWindowRow_ >= windowRows_ / 2) {
+      decodeWindow(results);
+    }
+  }
+  return results;
+}
+
+vector<Ref<Result> > LineScanDecoder::flush() {
+  vector<Ref<Result> > results;
+  if (matrix_ && rowsSeen_ > lastWindowRow_) {
+    decodeWindow(results);
+  }
+  return results;
+}
+
+void LineScanDecoder::decodeRow(int slot, long long streamRow, vector<Ref<Result> >& results) {
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(ring_, width_, windowRows_, 0, slot, width_, 1));
+  GlobalHistogramBinarizer binarizer(source);
+  Ref<BitArray> row;
+  try {
+    row = binarizer.getBlackRow(0, row);
+  } catch (ReaderException const& re) {
+    // Too little contrast in this row to hold a symbol
+    (void)re;
+    return;
+  }
+  // Upside down symbols read forwards in the reversed row
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (attempt == 1) {
+      row->reverse();
+    }
+    hints_.checkCancelled();
+    try {
+      Ref<Result> result = oneDReader_->decodeRow(0, row);
+      report(translateResultPoints(result, 0, 0, attempt == 1 ? width_ : 0), streamRow, streamRow, results);
+      return;
+    } catch (ReaderException const& re) {
+      (void)re;
+    }
+  }
+}
+
+void LineScanDecoder::decodeWindow(vector<Ref<Result> >& results) {
+  int rows = (int) std::min<long long>(rowsSeen_, windowRows_);
+  long long top = rowsSeen_ - rows;
+  lastWindowRow_ = rowsSeen_;
+
+  // The ring starts wherever the oldest row is; unroll it
+  ArrayRef<char> window(width_ * rows);
+  for (int y = 0; y < rows; y++) {
+    int slot = (int) ((top + y) % windowRows_);
+    memcpy(&window[y * width_], &ring_[slot * width_], width_);
+  }
+  Ref<LuminanceSource> source(new GreyscaleLuminanceSource(window, width_, rows, 0, 0, width_, rows));
+  Ref<BinaryBitmap> bitmap(new BinaryBitmap(Ref<Binarizer>(new HybridBinarizer(source))));
+  GenericMultipleBarcodeReader reader(matrixReader_);
+  vector<Ref<Result> > found;
+  try {
+    found = reader.decodeMultiple(bitmap, matrixHints_);
+  } catch (ReaderException const& re) {
+    (void)re;
+    return;
+  }
+  for (size_t i = 0; i < found.size(); i++) {
+    report(found[i], top, rowsSeen_ - 1, results);
+  }
+}
+
+// result has its points relative to the stream row top; they are only
+// moved into the stream, and into float, once the symbol is reported
+void LineScanDecoder::report(Ref<Result> result, long long top, long long streamRow,
+                             vector<Ref<Result> >& results) {
+  Seen read;
+  read.text = result->getText()->getText();
+  read.format = result->getBarcodeFormat();
+  read.left = std::numeric_limits<float>::max();
+  read.right = -std::numeric_limits<float>::max();
+  float minY = std::numeric_limits<float>::max();
+  float maxY = -std::numeric_limits<float>::max();
+  ArrayRef< Ref<ResultPoint> > points = result->getResultPoints();
+  for (int i = 0; points && i < points->size(); i++) {
+    read.left = std::min(read.left, points[i]->getX());
+    read.right = std::max(read.right, points[i]->getX());
+    minY = std::min(minY, points[i]->getY());
+    maxY = std::max(maxY, points[i]->getY());
+  }
+  if (points && !points->empty()) {
+    read.top = top + (long long) std::floor(minY);
+    read.bottom = top + (long long) std::ceil(maxY);
+  } else {
+    read.left = 0;
+    read.right = (float) (width_ - 1);
+    read.top = read.bottom = streamRow;
+  }
+
+  // Forget what has been out of sight for a whole window
+  size_t kept = 0;
+  bool known = false;
+  for (size_t i = 0; i < seen_.size(); i++) {
+    Seen& entry = seen_[i];
+    if (streamRow - entry.bottom > windowRows_) {
+      continue;
+    }
+    if (!known && sameSymbol(entry, read)) {
+      entry.left = std::min(entry.left, read.left);
+      entry.right = std::max(entry.right, read.right);
+      entry.top = std::min(entry.top, read.top);
+      entry.bottom = std::max(entry.bottom, read.bottom);
+      known = true;
+    }
+    seen_[kept++] = entry;
+  }
+  seen_.resize(kept);
+  if (known) {
+    return;
+  }
+  seen_.push_back(read);
+  results.push_back(translateResultPoints(result, 0, (float) top, 0));
+}
+
+bool LineScanDecoder::sameSymbol(Seen const& a, Seen const& b) const {
+  if (a.format != b.format || a.text != b.text) {
+    return false;
+  }
+  long long gap = (long long) rowStep_ * MAX_MISSED_READS;
+  return a.left <= b.right && b.left <= a.right &&
+         a.top <= b.bottom + gap && b.top <= a.bottom + gap;
+}
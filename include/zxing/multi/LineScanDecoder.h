@@ -0,0 +1,109 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __LINE_SCAN_DECODER_H__
+#define __LINE_SCAN_DECODER_H__
+
+/*
+ *  LineScanDecoder.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/Result.h>
+#include <zxing/DecodeHints.h>
+#include <zxing/MultiFormatReader.h>
+#include <zxing/oned/MultiFormatOneDReader.h>
+#include <string>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Decodes the endless image of a line-scan camera as its rows arrive. Only
+ * the last windowRows rows are kept, in a ring.
+ *
+ * Every rowStep-th row is binarized on its own, like
+ * GlobalHistogramBinarizer's rows, and read by the 1D readers straight
+ * away. Whenever half a window of new rows has arrived, the window is
+ * binarized with HybridBinarizer and searched for 2D symbols. Consecutive
+ * windows overlap by half, so any symbol up to half a window tall lies
+ * wholly inside one of them.
+ *
+ * A symbol is reported once, by the call that adds the row completing it.
+ * Reads with the same format and text are taken to be the same symbol when
+ * their columns overlap and their rows overlap or lie within
+ * MAX_MISSED_READS row reads of each other. Identical labels one after the
+ * other on a conveyor are therefore reported one by one. A symbol is
+ * forgotten once windowRows rows have gone by without it being read.
+ * Result points are in stream coordinates: y counts rows since the decoder
+ * was created. A float holds that exactly only up to 2^24, so symbols are
+ * matched on whole row numbers kept as long long, and only the reported
+ * points lose precision on longer streams.
+ *
+ * Any cancellation token in the hints bounds the whole stream, not one call.
+ */
+class LineScanDecoder : public Counted {
+public:
+  static const int DEFAULT_WINDOW_ROWS = 256;
+  // Row reads a 1D symbol may fail in a row, at damage or glare, and still
+  // be taken for the same symbol when read again
+  static const int MAX_MISSED_READS = 8;
+
+  LineScanDecoder(int width, DecodeHints const& hints, int windowRows = DEFAULT_WINDOW_ROWS, int rowStep = 1);
+
+  // rows rows of width 8 bit luminances each, rowBytes apart
+  std::vector<Ref<Result> > addRows(void const* data, int rows, int rowBytes);
+  // Searches the rows since the last window, at the end of the stream
+  std::vector<Ref<Result> > flush();
+
+  long long getRowsSeen() const { return rowsSeen_; }
+
+private:
+  // Where a symbol has been read so far: columns, and rows of the stream
+  struct Seen {
+    std::string text;
+    int format;
+    float left;
+    float right;
+    long long top;
+    long long bottom;
+  };
+
+  const int width_;
+  const int windowRows_;
+  const int rowStep_;
+  const DecodeHints hints_;
+  const DecodeHints matrixHints_;
+  bool linear_;
+  bool matrix_;
+  Ref<oned::MultiFormatOneDReader> oneDReader_;
+  MultiFormatReader matrixReader_;
+
+  ArrayRef<char> ring_;
+  long long rowsSeen_;
+  long long lastWindowRow_;
+  std::vector<Seen> seen_;
+
+  void decodeRow(int slot, long long streamRow, std::vector<Ref<Result> >& results);
+  void decodeWindow(std::vector<Ref<Result> >& results);
+  void report(Ref<Result> result, long long top, long long streamRow, std::vector<Ref<Result> >& results);
+  bool sameSymbol(Seen const& a, Seen const& b) const;
+};
+
+}
+}
+
+#endif // __LINE_SCAN_DECODER_H__
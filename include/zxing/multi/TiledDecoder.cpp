@@ -0,0 +1,269 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  TiledDecoder.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/TiledDecoder.h>
+#include <zxing/multi/GenericMultipleBarcodeReader.h>
+#include <zxing/common/GreyscaleLuminanceSource.h>
+#include <zxing/common/HybridBinarizer.h>
+#include <zxing/common/IllegalArgumentException.h>
+#include <zxing/MultiFormatReader.h>
+#include <zxing/BinaryBitmap.h>
+#include <zxing/ReaderException.h>
+#include <zxing/TimeoutException.h>
+#include <zxing/ResultPoint.h>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <thread>
+#include <string.h>
+
+using std::vector;
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::Result;
+using zxing::ResultPoint;
+using zxing::LuminanceSource;
+using zxing::DecodeHints;
+using zxing::multi::TiledDecoder;
+
+// VC++
+using zxing::BinaryBitmap;
+using zxing::Binarizer;
+using zxing::HybridBinarizer;
+using zxing::GreyscaleLuminanceSource;
+using zxing::MultiFormatReader;
+using zxing::ReaderException;
+using zxing::TimeoutException;
+using zxing::IllegalArgumentException;
+using zxing::multi::GenericMultipleBarcodeReader;
+
+namespace {
+
+// GenericMultipleBarcodeReader searches a tile and then crops of it, down
+// to four levels below the tile, and every level is alive until the one
+// below it returns
+const int CROP_LEVELS = 5;
+// Black matrices a level may hold at once: its own, a copy cropped from
+// its parent's, the inverted and the rotated copies the readers ask for,
+// and a proposed region cropped out of it
+const int MATRICES_PER_LEVEL = 5;
+
+// What the threads decoding one image share
+struct Work {
+  Ref<LuminanceSource> image;
+  vector<DecodeHints::Region> const& tiles;
+  DecodeHints const& hints;
+  float sameSymbolDistance;
+
+  std::atomic<int> next;
+  std::atomic<bool> done;
+
+  std::mutex lock;
+  bool timedOut;
+  vector<Ref<Result> > results;
+
+  Work(Ref<LuminanceSource> image_, vector<DecodeHints::Region> const& tiles_, DecodeHints const& hints_,
+       float sameSymbolDistance_)
+    : image(image_), tiles(tiles_), hints(hints_), sameSymbolDistance(sameSymbolDistance_),
+      next(0), done(false), timedOut(false) {}
+};
+
+void centerOf(Ref<Result> result, float& x, float& y) {
+  ArrayRef< Ref<ResultPoint> > points = result->getResultPoints();
+  x = 0;
+  y = 0;
+  if (!points || points->empty()) {
+    return;
+  }
+  for (int i = 0; i < points->size(); i++) {
+    x += points[i]->getX();
+    y += points[i]->getY();
+  }
+  x /= points->size();
+  y /= points->size();
+}
+
+bool sameSymbol(Ref<Result> a, Ref<Result> b, float distance) {
+  if (a->getBarcodeFormat() != b->getBarcodeFormat() ||
+      a->getText()->getText() != b->getText()->getText()) {
+    return false;
+  }
+  float ax, ay, bx, by;
+  centerOf(a, ax, ay);
+  centerOf(b, bx, by);
+  return (ax - bx) * (ax - bx) + (ay - by) * (ay - by) <= distance * distance;
+}
+
+// Top to bottom, then left to right, however the threads finished
+class ByPosition {
+public:
+  bool operator()(Ref<Result> a, Ref<Result> b) const {
+    float ax, ay, bx, by;
+    centerOf(a, ax, ay);
+    centerOf(b, bx, by);
+    return ay < by || (ay == by && ax < bx);
+  }
+};
+
+Ref<Result> translateResultPoints(Ref<Result> result, int xOffset, int yOffset) {
+  ArrayRef< Ref<ResultPoint> > oldResultPoints = result->getResultPoints();
+  if (!oldResultPoints || oldResultPoints->empty()) {
+    return result;
+  }
+  ArrayRef< Ref<ResultPoint> > newResultPoints(oldResultPoints->size());
+  for (int i = 0; i < oldResultPoints->size(); i++) {
+    Ref<ResultPoint> oldPoint = oldResultPoints[i];
+    newResultPoints[i] = Ref<ResultPoint>(new ResultPoint(oldPoint->getX() + xOffset, oldPoint->getY() + yOffset));
+  }
+  return Ref<Result>(new Result(result->getText(), result->getRawBytes(), newResultPoints,
+                                result->getBarcodeFormat()));
+}
+
+ArrayRef<char> readTile(Ref<LuminanceSource> image, DecodeHints::Region const& tile) {
+  if (image->isCropSupported()) {
+    return image->crop(tile.left, tile.top, tile.width, tile.height)->getMatrix();
+  }
+  ArrayRef<char> luminances(tile.width * tile.height);
+  ArrayRef<char> row;
+  for (int y = 0; y < tile.height; y++) {
+    row = image->getRow(tile.top + y, row);
+    memcpy(&luminances[y * tile.width], &row[tile.left], tile.width);
+  }
+  return luminances;
+}
+
+void decodeTiles(Work* work) {
+  // Readers keep state between decodes, so every thread has its own
+  MultiFormatReader delegate;
+  GenericMultipleBarcodeReader reader(delegate);
+  for (;;) {
+    int i = work->next.fetch_add(1);
+    if (work->done || i >= (int) work->tiles.size()) {
+      return;
+    }
+    DecodeHints::Region const& tile = work->tiles[i];
+    vector<Ref<Result> > found;
+    try {
+      work->hints.checkCancelled();
+      Ref<LuminanceSource> source(new GreyscaleLuminanceSource(readTile(work->image, tile),
+                                                               tile.width, tile.height,
+                                                               0, 0, tile.width, tile.height));
+      Ref<BinaryBitmap> bitmap(new BinaryBitmap(Ref<Binarizer>(new HybridBinarizer(source))));
+      found = reader.decodeMultiple(bitmap, work->hints);
+    } catch (TimeoutException const&) {
+      std::lock_guard<std::mutex> guard(work->lock);
+      work->timedOut = true;
+      work->done = true;
+      return;
+    } catch (ReaderException const&) {
+      continue;
+    }
+
+    std::lock_guard<std::mutex> guard(work->lock);
+    for (size_t j = 0; j < found.size(); j++) {
+      Ref<Result> result = translateResultPoints(found[j], tile.left, tile.top);
+      bool duplicate = false;
+      for (size_t k = 0; k < work->results.size() && !duplicate; k++) {
+        duplicate = sameSymbol(work->results[k], result, work->sameSymbolDistance);
+      }
+      if (!duplicate) {
+        work->results.push_back(result);
+      }
+    }
+    if (work->hints.isSatisfiedBy(work->results)) {
+      work->done = true;
+    }
+  }
+}
+
+// Tile origins along one axis; the last tile is moved back to end at the edge
+vector<int> tileStarts(int length, int tileSize, int overlap) {
+  vector<int> starts;
+  if (length <= tileSize) {
+    starts.push_back(0);
+    return starts;
+  }
+  for (int start = 0; ; start += tileSize - overlap) {
+    if (start + tileSize >= length) {
+      starts.push_back(length - tileSize);
+      break;
+    }
+    starts.push_back(start);
+  }
+  return starts;
+}
+
+}
+
+TiledDecoder::TiledDecoder(int tileSize, int overlap, size_t maxWorkingBytes)
+    : tileSize_(tileSize), overlap_(overlap), maxWorkingBytes_(maxWorkingBytes) {
+  if (overlap < 0 || overlap >= tileSize) {
+    throw IllegalArgumentException("Tiles must overlap by less than their size.");
+  }
+}
+
+size_t TiledDecoder::bytesPerTile(int tileSize, int imageWidth) {
+  size_t pixels = (size_t) tileSize * tileSize;
+  return 2 * pixels + pixels / 16 + CROP_LEVELS * MATRICES_PER_LEVEL * (pixels / 8) + imageWidth;
+}
+
+vector<Ref<Result> > TiledDecoder::decode(Ref<LuminanceSource> image, DecodeHints const& hints) {
+  int width = image->getWidth();
+  int height = image->getHeight();
+  size_t tileBytes = bytesPerTile(tileSize_, width);
+  if (tileBytes > maxWorkingBytes_) {
+    throw IllegalArgumentException("A single tile does not fit in the working set.");
+  }
+
+  vector<int> lefts = tileStarts(width, tileSize_, overlap_);
+  vector<int> tops = tileStarts(height, tileSize_, overlap_);
+  vector<DecodeHints::Region> tiles;
+  for (size_t y = 0; y < tops.size(); y++) {
+    for (size_t x = 0; x < lefts.size(); x++) {
+      tiles.push_back(DecodeHints::Region(lefts[x], tops[y],
+                                          std::min(tileSize_, width), std::min(tileSize_, height)));
+    }
+  }
+
+  // The tiles are what is spread over the threads; each is decoded on one
+  DecodeHints tileHints(hints);
+  tileHints.setThreads(1);
+  Work work(image, tiles, tileHints, overlap_ / 2.0f);
+  int threads = hints.getThreads();
+  threads = std::min(threads, (int) (maxWorkingBytes_ / tileBytes));
+  threads = std::min(threads, (int) tiles.size());
+  vector<std::thread> pool;
+  for (int i = 1; i < threads; i++) {
+    pool.push_back(std::thread(decodeTiles, &work));
+  }
+  decodeTiles(&work);
+  for (size_t i = 0; i < pool.size(); i++) {
+    pool[i].join();
+  }
+
+  if (work.results.empty()) {
+    if (work.timedOut) {
+      throw TimeoutException("Decode timed out");
+    }
+    throw ReaderException("No code detected");
+  }
+  std::sort(work.results.begin(), work.results.end(), ByPosition());
+  return work.results;
+}
@@ -0,0 +1,78 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __TILED_DECODER_H__
+#define __TILED_DECODER_H__
+
+/*
+ *  TiledDecoder.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/LuminanceSource.h>
+#include <zxing/Result.h>
+#include <zxing/DecodeHints.h>
+#include <stddef.h>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Decodes images too large to binarize whole, such as flatbed scans of
+ * tens of megapixels, as a grid of overlapping square tiles. Each tile is
+ * read out of the source row by row, or cropped when the source supports
+ * it, then binarized and searched for every symbol on its own. As many
+ * tiles are decoded at once as the hints allow threads, one per thread.
+ *
+ * Only the tiles being decoded are in memory, so the working set is at most
+ * the number of threads times bytesPerTile(), whatever the image size. The
+ * thread count is cut down to fit maxWorkingBytes. The source's getRow()
+ * and crop() are called from several threads at once.
+ *
+ * Symbols up to overlap pixels across lie wholly inside at least one tile.
+ * A symbol read in several tiles is reported once: results with the same
+ * format and text whose centers lie within half the overlap of each other
+ * are taken to be the same symbol.
+ */
+class TiledDecoder : public Counted {
+public:
+  static const int DEFAULT_TILE_SIZE = 2048;
+  static const int DEFAULT_OVERLAP = 512;
+  static const size_t DEFAULT_MAX_WORKING_BYTES = 256u << 20;
+
+  TiledDecoder(int tileSize = DEFAULT_TILE_SIZE, int overlap = DEFAULT_OVERLAP,
+               size_t maxWorkingBytes = DEFAULT_MAX_WORKING_BYTES);
+
+  // Results with points in image coordinates. Throws ReaderException if no
+  // tile holds a symbol, TimeoutException if time ran out first.
+  std::vector<Ref<Result> > decode(Ref<LuminanceSource> image, DecodeHints const& hints);
+
+  // An upper bound on what decoding one tile holds at once: its luminances,
+  // the binarizer's copy of them and its black points, one full row of the
+  // image, and every black matrix copied while the tile and the crops that
+  // GenericMultipleBarcodeReader recurses into are searched
+  static size_t bytesPerTile(int tileSize, int imageWidth);
+
+private:
+  const int tileSize_;
+  const int overlap_;
+  const size_t maxWorkingBytes_;
+};
+
+}
+}
+
+#endif // __TILED_DECODER_H__
@@ -0,0 +1,60 @@
+/*
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/aztec/AztecMultiReader.h>
+#include <zxing/multi/aztec/detector/AztecMultiDetector.h>
+#include <zxing/multi/CandidateDecoder.h>
+#include <zxing/aztec/detector/Detector.h>
+#include <zxing/aztec/decoder/Decoder.h>
+#include <zxing/common/DecoderResult.h>
+#include <zxing/BarcodeFormat.h>
+
+namespace zxing {
+namespace multi {
+
+namespace {
+
+// The candidate regions already hold the whole symbol and its quiet zone
+const int QUIET_ZONE = 0;
+
+Ref<Result> decodeWindow(Ref<BitMatrix> window, DecodeHints const& hints) {
+  hints.checkCancelled();
+  zxing::aztec::Detector detector(window);
+  Ref<zxing::aztec::AztecDetectorResult> detectorResult(detector.detect());
+  hints.checkCancelled();
+  zxing::aztec::Decoder decoder;
+  Ref<DecoderResult> decoderResult(decoder.decode(detectorResult));
+  return Ref<Result>(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                detectorResult->getPoints(), BarcodeFormat::AZTEC));
+}
+
+}
+
+AztecMultiReader::AztecMultiReader(){}
+
+AztecMultiReader::~AztecMultiReader(){}
+
+std::vector<Ref<Result> > AztecMultiReader::decodeMultiple(Ref<BinaryBitmap> image,
+  DecodeHints hints)
+{
+  Ref<BitMatrix> matrix = image->getBlackMatrix();
+  AztecMultiDetector detector(matrix);
+  std::vector<DecodeHints::Region> candidates = detector.detectCandidates(hints);
+  return CandidateDecoder::decode(matrix, candidates, QUIET_ZONE, decodeWindow, hints);
+}
+
+} // End zxing::multi namespace
+} // End zxing namespace
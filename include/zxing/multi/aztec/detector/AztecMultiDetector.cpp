@@ -0,0 +1,197 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  AztecMultiDetector.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/aztec/detector/AztecMultiDetector.h>
+#include <zxing/common/BitArray.h>
+#include <zxing/ZXing.h>
+#include <algorithm>
+#include <cmath>
+
+using std::vector;
+using std::abs;
+using zxing::Ref;
+using zxing::BitArray;
+using zxing::BitMatrix;
+using zxing::DecodeHints;
+using zxing::multi::AztecMultiDetector;
+
+namespace {
+
+// The rings crossed on each side of the center module before the mode
+// message: white, black, white
+const int RINGS = 3;
+const int PATTERN_RUNS = 2 * RINGS + 1;
+// Single pixel runs are noise more often than they are rings
+const float MIN_MODULE_SIZE = 1.5f;
+
+bool isInSearchRegion(float x, float y, DecodeHints const& hints) {
+  vector<DecodeHints::Region> const& regions = hints.getSearchRegions();
+  if (regions.empty()) {
+    return true;
+  }
+  for (size_t i = 0; i < regions.size(); i++) {
+    if (x >= regions[i].left && x < regions[i].left + regions[i].width &&
+        y >= regions[i].top && y < regions[i].top + regions[i].height) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+AztecMultiDetector::AztecMultiDetector(Ref<BitMatrix> image) : image_(image) {}
+
+// Each of the runs, center module included, must be within half a module
+// of the module size
+bool AztecMultiDetector::matchesBullsEye(int const* runs, float moduleSize) {
+  float maxVariance = moduleSize / 2.0f;
+  for (int i = 0; i < PATTERN_RUNS; i++) {
+    if (abs(moduleSize - runs[i]) >= maxVariance) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Checks the column through x for the same pattern as the row, returns
+// the vertical center of the center module or NaN
+float AztecMultiDetector::crossCheckVertical(int x, int y, float moduleSize) const {
+  int height = image_->getHeight();
+  int maxRun = (int) (2 * moduleSize) + 1;
+  int runs[PATTERN_RUNS] = {0};
+
+  // Center module and the rings above it
+  int i = y;
+  for (int run = RINGS; run >= 0; run--) {
+    bool black = (run % 2) == (RINGS % 2);
+    while (i >= 0 && image_->get(x, i) == black && runs[run] <= maxRun) {
+      runs[run]++;
+      i--;
+    }
+    if (runs[run] == 0 || runs[run] > maxRun) {
+      return zxing::nan();
+    }
+  }
+  int centerTop = y - runs[RINGS] + 1;
+
+  // The rest of the center module and the rings below it
+  i = y + 1;
+  for (int run = RINGS; run < PATTERN_RUNS; run++) {
+    bool black = (run % 2) == (RINGS % 2);
+    while (i < height && image_->get(x, i) == black && runs[run] <= maxRun) {
+      runs[run]++;
+      i++;
+    }
+    if (runs[run] == 0 || runs[run] > maxRun) {
+      return zxing::nan();
+    }
+  }
+  int centerBottom = centerTop + runs[RINGS];
+
+  int total = 0;
+  for (int run = 0; run < PATTERN_RUNS; run++) {
+    total += runs[run];
+  }
+  float verticalModuleSize = (float) total / PATTERN_RUNS;
+  if (abs(verticalModuleSize - moduleSize) >= moduleSize / 2.0f ||
+      !matchesBullsEye(runs, verticalModuleSize)) {
+    return zxing::nan();
+  }
+  return (centerTop + centerBottom) / 2.0f;
+}
+
+vector<DecodeHints::Region> AztecMultiDetector::detectCandidates(DecodeHints const& hints) {
+  int width = image_->getWidth();
+  int height = image_->getHeight();
+  // The center module is at least a module tall, half of that is enough
+  int rowStep = std::max(1, (int) (hints.getMinModuleSize() / 2));
+
+  vector<Center> centers;
+  vector<int> edges;
+  Ref<BitArray> row;
+  for (int y = 0; y < height && (int) centers.size() < MAX_CANDIDATES; y += rowStep) {
+    row = image_->getRow(y, row);
+
+    // Run k covers edges[k] to edges[k + 1], runs alternate in color
+    edges.clear();
+    edges.push_back(0);
+    bool firstBlack = row->get(0);
+    bool black = firstBlack;
+    for (int x = 0; x < width; black = !black) {
+      x = black ? row->getNextUnset(x) : row->getNextSet(x);
+      edges.push_back(x);
+    }
+    int runCount = (int) edges.size() - 1;
+
+    // Black center runs with the rings on both sides and the outer black
+    // ring beyond them
+    int first = RINGS + 1;
+    if ((first % 2 == 0) != firstBlack) {
+      first++;
+    }
+    int runs[PATTERN_RUNS];
+    for (int k = first; k + RINGS + 1 < runCount; k += 2) {
+      for (int i = 0; i < PATTERN_RUNS; i++) {
+        runs[i] = edges[k - RINGS + i + 1] - edges[k - RINGS + i];
+      }
+      float moduleSize = (float) (edges[k + RINGS + 1] - edges[k - RINGS]) / PATTERN_RUNS;
+      if (moduleSize < MIN_MODULE_SIZE || !matchesBullsEye(runs, moduleSize) || !hints.acceptsModuleSize(moduleSize)) {
+        continue;
+      }
+      int centerX = (edges[k] + edges[k + 1]) / 2;
+      float centerY = crossCheckVertical(centerX, y, moduleSize);
+      if (zxing::isnan(centerY) || !isInSearchRegion((float) centerX, centerY, hints)) {
+        continue;
+      }
+
+      // The center module is crossed by several rows, merge their hits
+      bool merged = false;
+      for (size_t i = 0; i < centers.size() && !merged; i++) {
+        Center& center = centers[i];
+        float tolerance = 2 * center.moduleSize;
+        if (abs(center.x - centerX) <= tolerance && abs(center.y - centerY) <= tolerance) {
+          center.x = (center.x * center.count + centerX) / (center.count + 1);
+          center.y = (center.y * center.count + centerY) / (center.count + 1);
+          center.moduleSize = (center.moduleSize * center.count + moduleSize) / (center.count + 1);
+          center.count++;
+          merged = true;
+        }
+      }
+      if (!merged && (int) centers.size() < MAX_CANDIDATES) {
+        Center center;
+        center.x = (float) centerX;
+        center.y = centerY;
+        center.moduleSize = moduleSize;
+        center.count = 1;
+        centers.push_back(center);
+      }
+    }
+  }
+
+  vector<DecodeHints::Region> regions;
+  for (size_t i = 0; i < centers.size(); i++) {
+    int radius = (int) (MAX_RADIUS_MODULES * centers[i].moduleSize);
+    int x = (int) (centers[i].x + 0.5f);
+    int y = (int) (centers[i].y + 0.5f);
+    regions.push_back(DecodeHints::Region(x - radius, y - radius, 2 * radius + 1, 2 * radius + 1));
+  }
+  return regions;
+}
@@ -0,0 +1,66 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __AZTEC_MULTI_DETECTOR_H__
+#define __AZTEC_MULTI_DETECTOR_H__
+
+/*
+ *  AztecMultiDetector.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+#include <zxing/common/BitMatrix.h>
+#include <zxing/DecodeHints.h>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Finds the bull's-eyes of Aztec symbols. Through the center of a bull's-eye
+ * both rows and columns cross a black center module and then alternating
+ * white and black rings one module wide, so a candidate is a black run that
+ * is flanked on each side by three runs of the same width, in both
+ * directions. The region returned for a bull's-eye is centered on it and
+ * large enough for the biggest symbol its module size allows.
+ */
+class AztecMultiDetector : public Counted {
+private:
+  static const int MAX_CANDIDATES = 32;
+  // Half the side of a 32 layer symbol
+  static const int MAX_RADIUS_MODULES = 76;
+
+  struct Center {
+    float x;
+    float y;
+    float moduleSize;
+    int count;
+  };
+
+  Ref<BitMatrix> image_;
+
+  float crossCheckVertical(int x, int y, float moduleSize) const;
+  static bool matchesBullsEye(int const* runs, float moduleSize);
+
+public:
+  AztecMultiDetector(Ref<BitMatrix> image);
+  std::vector<DecodeHints::Region> detectCandidates(DecodeHints const& hints);
+};
+
+}
+}
+
+#endif // __AZTEC_MULTI_DETECTOR_H__
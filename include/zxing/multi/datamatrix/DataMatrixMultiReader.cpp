@@ -0,0 +1,59 @@
+/*
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/datamatrix/DataMatrixMultiReader.h>
+#include <zxing/multi/datamatrix/detector/DataMatrixMultiDetector.h>
+#include <zxing/multi/CandidateDecoder.h>
+#include <zxing/datamatrix/detector/Detector.h>
+#include <zxing/datamatrix/decoder/Decoder.h>
+#include <zxing/BarcodeFormat.h>
+
+namespace zxing {
+namespace multi {
+
+namespace {
+
+// White border around each candidate, the finder expects at least one module of it
+const int QUIET_ZONE = 8;
+
+Ref<Result> decodeWindow(Ref<BitMatrix> window, DecodeHints const& hints) {
+  hints.checkCancelled();
+  zxing::datamatrix::Detector detector(window);
+  Ref<DetectorResult> detectorResult(detector.detect());
+  hints.checkCancelled();
+  zxing::datamatrix::Decoder decoder;
+  Ref<DecoderResult> decoderResult(decoder.decode(detectorResult->getBits()));
+  return Ref<Result>(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                detectorResult->getPoints(), BarcodeFormat::DATA_MATRIX));
+}
+
+}
+
+DataMatrixMultiReader::DataMatrixMultiReader(){}
+
+DataMatrixMultiReader::~DataMatrixMultiReader(){}
+
+std::vector<Ref<Result> > DataMatrixMultiReader::decodeMultiple(Ref<BinaryBitmap> image,
+  DecodeHints hints)
+{
+  Ref<BitMatrix> matrix = image->getBlackMatrix();
+  DataMatrixMultiDetector detector(matrix);
+  std::vector<DecodeHints::Region> candidates = detector.detectCandidates(hints);
+  return CandidateDecoder::decode(matrix, candidates, QUIET_ZONE, decodeWindow, hints);
+}
+
+} // End zxing::multi namespace
+} // End zxing namespace
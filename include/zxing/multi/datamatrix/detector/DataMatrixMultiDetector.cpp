@@ -0,0 +1,120 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  DataMatrixMultiDetector.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/datamatrix/detector/DataMatrixMultiDetector.h>
+#include <zxing/common/detector/ConnectedComponents.h>
+#include <algorithm>
+
+using std::vector;
+using zxing::Ref;
+using zxing::BitMatrix;
+using zxing::DecodeHints;
+using zxing::ConnectedComponents;
+using zxing::multi::DataMatrixMultiDetector;
+
+namespace {
+
+// Data Matrix symbols are 8 to 144 modules on a side
+const int MIN_MODULES = 8;
+const int MAX_MODULES = 144;
+// A symbol turned 45 degrees has a bounding box this much wider
+const float ROTATION_GROWTH = 1.42f;
+
+class ByPixelsDescending {
+private:
+  vector<ConnectedComponents::Component> const& components_;
+public:
+  ByPixelsDescending(vector<ConnectedComponents::Component> const& components) : components_(components) {}
+  bool operator()(int a, int b) const {
+    return components_[a].pixels > components_[b].pixels;
+  }
+};
+
+bool isInSearchRegion(ConnectedComponents::Component const& component, DecodeHints const& hints) {
+  vector<DecodeHints::Region> const& regions = hints.getSearchRegions();
+  if (regions.empty()) {
+    return true;
+  }
+  int x = (component.left + component.right) / 2;
+  int y = (component.top + component.bottom) / 2;
+  for (size_t i = 0; i < regions.size(); i++) {
+    if (x >= regions[i].left && x < regions[i].left + regions[i].width &&
+        y >= regions[i].top && y < regions[i].top + regions[i].height) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+// A symbol turned 45 degrees fills only half of its bounding box, and even
+// the densest symbols are far from solid black
+const float DataMatrixMultiDetector::MAX_ASPECT = 4.0f;
+const float DataMatrixMultiDetector::MIN_DENSITY = 0.2f;
+const float DataMatrixMultiDetector::MAX_DENSITY = 0.85f;
+
+DataMatrixMultiDetector::DataMatrixMultiDetector(Ref<BitMatrix> image) : image_(image) {}
+
+vector<DecodeHints::Region> DataMatrixMultiDetector::detectCandidates(DecodeHints const& hints) {
+  int minSide = MIN_SIDE;
+  int maxSide = std::max(image_->getWidth(), image_->getHeight());
+  if (hints.getMinModuleSize() > 0) {
+    minSide = (int) (MIN_MODULES * hints.getMinModuleSize() / 1.5f);
+  }
+  if (hints.getMaxModuleSize() > 0) {
+    maxSide = std::min(maxSide, (int) (MAX_MODULES * hints.getMaxModuleSize() * 1.5f * ROTATION_GROWTH));
+  }
+
+  // The L alone has two sides' worth of black pixels
+  vector<ConnectedComponents::Component> components = ConnectedComponents::find(image_, 2 * minSide);
+  vector<int> candidates;
+  for (size_t i = 0; i < components.size(); i++) {
+    ConnectedComponents::Component const& component = components[i];
+    int shortSide = std::min(component.getWidth(), component.getHeight());
+    int longSide = std::max(component.getWidth(), component.getHeight());
+    if (shortSide < minSide || longSide > maxSide || longSide > MAX_ASPECT * shortSide) {
+      continue;
+    }
+    float density = component.getDensity();
+    if (density < MIN_DENSITY || density > MAX_DENSITY) {
+      continue;
+    }
+    if (!isInSearchRegion(component, hints)) {
+      continue;
+    }
+    candidates.push_back((int) i);
+  }
+
+  // On a cluttered image keep the largest, but report them top to bottom
+  if ((int) candidates.size() > MAX_CANDIDATES) {
+    std::stable_sort(candidates.begin(), candidates.end(), ByPixelsDescending(components));
+    candidates.resize(MAX_CANDIDATES);
+    std::sort(candidates.begin(), candidates.end());
+  }
+
+  vector<DecodeHints::Region> regions;
+  for (size_t i = 0; i < candidates.size(); i++) {
+    ConnectedComponents::Component const& component = components[candidates[i]];
+    regions.push_back(DecodeHints::Region(component.left, component.top,
+                                          component.getWidth(), component.getHeight()));
+  }
+  return regions;
+}
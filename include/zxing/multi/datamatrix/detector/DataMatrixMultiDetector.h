@@ -0,0 +1,56 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __DATA_MATRIX_MULTI_DETECTOR_H__
+#define __DATA_MATRIX_MULTI_DETECTOR_H__
+
+/*
+ *  DataMatrixMultiDetector.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/common/Counted.h>
+#include <zxing/common/BitMatrix.h>
+#include <zxing/DecodeHints.h>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Finds the regions of an image that may each hold one Data Matrix symbol.
+ * The solid L finder pattern joins a symbol's black modules into one
+ * connected component spanning the whole symbol, so every component of the
+ * right size, shape and fill is a candidate.
+ */
+class DataMatrixMultiDetector : public Counted {
+private:
+  static const int MIN_SIDE = 16;
+  static const int MAX_CANDIDATES = 32;
+  static const float MAX_ASPECT;
+  static const float MIN_DENSITY;
+  static const float MAX_DENSITY;
+
+  Ref<BitMatrix> image_;
+
+public:
+  DataMatrixMultiDetector(Ref<BitMatrix> image);
+  std::vector<DecodeHints::Region> detectCandidates(DecodeHints const& hints);
+};
+
+}
+}
+
+#endif // __DATA_MATRIX_MULTI_DETECTOR_H__
@@ -0,0 +1,57 @@
+/*
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/pdf417/PDF417MultiReader.h>
+#include <zxing/multi/pdf417/detector/PDF417MultiDetector.h>
+#include <zxing/multi/CandidateDecoder.h>
+#include <zxing/pdf417/decoder/Decoder.h>
+#include <zxing/BarcodeFormat.h>
+
+namespace zxing {
+namespace multi {
+
+namespace {
+
+// Quiet zone around each candidate, two modules of the widest symbols
+const int QUIET_ZONE = 8;
+
+Ref<Result> decodeWindow(Ref<BitMatrix> window, DecodeHints const& hints) {
+  hints.checkCancelled();
+  zxing::pdf417::detector::Detector detector(Ref<BinaryBitmap>(new BinaryBitmap(window)));
+  Ref<DetectorResult> detectorResult(detector.detect(hints));
+  hints.checkCancelled();
+  zxing::pdf417::decoder::Decoder decoder;
+  Ref<DecoderResult> decoderResult(decoder.decode(detectorResult->getBits(), hints));
+  return Ref<Result>(new Result(decoderResult->getText(), decoderResult->getRawBytes(),
+                                detectorResult->getPoints(), BarcodeFormat::PDF_417));
+}
+
+}
+
+PDF417MultiReader::PDF417MultiReader(){}
+
+PDF417MultiReader::~PDF417MultiReader(){}
+
+std::vector<Ref<Result> > PDF417MultiReader::decodeMultiple(Ref<BinaryBitmap> image,
+  DecodeHints hints)
+{
+  PDF417MultiDetector detector(image);
+  std::vector<DecodeHints::Region> candidates = detector.detectCandidates(hints);
+  return CandidateDecoder::decode(image->getBlackMatrix(), candidates, QUIET_ZONE, decodeWindow, hints);
+}
+
+} // End zxing::multi namespace
+} // End zxing namespace
@@ -0,0 +1,36 @@
+#ifndef __PDF417_MULTI_READER_H__
+#define __PDF417_MULTI_READER_H__
+
+/*
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/MultipleBarcodeReader.h>
+#include <zxing/pdf417/PDF417Reader.h>
+
+namespace zxing {
+namespace multi {
+
+class PDF417MultiReader: public zxing::pdf417::PDF417Reader, public MultipleBarcodeReader {
+  public:
+    PDF417MultiReader();
+    virtual ~PDF417MultiReader();
+    virtual std::vector<Ref<Result> > decodeMultiple(Ref<BinaryBitmap> image, DecodeHints hints);
+};
+
+}
+}
+
+#endif // __PDF417_MULTI_READER_H__
@@ -0,0 +1,147 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+/*
+ *  PDF417MultiDetector.cpp
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/multi/pdf417/detector/PDF417MultiDetector.h>
+#include <algorithm>
+
+using std::vector;
+using std::min;
+using std::max;
+using zxing::Ref;
+using zxing::ArrayRef;
+using zxing::BitMatrix;
+using zxing::BinaryBitmap;
+using zxing::DecodeHints;
+using zxing::multi::PDF417MultiDetector;
+
+namespace {
+
+bool isInSearchRegion(int x, int y, DecodeHints const& hints) {
+  vector<DecodeHints::Region> const& regions = hints.getSearchRegions();
+  if (regions.empty()) {
+    return true;
+  }
+  for (size_t i = 0; i < regions.size(); i++) {
+    if (x >= regions[i].left && x < regions[i].left + regions[i].width &&
+        y >= regions[i].top && y < regions[i].top + regions[i].height) {
+      return true;
+    }
+  }
+  return false;
+}
+
+}
+
+PDF417MultiDetector::PDF417MultiDetector(Ref<BinaryBitmap> image) : Detector(image) {}
+
+// Adds the hits of pattern in row to the columns, a hit continues a column
+// it overlaps that was last seen at most two probes above
+void PDF417MultiDetector::findColumns(Ref<BitMatrix> matrix, int row, int rowStep,
+                                      const int pattern[], int patternLength,
+                                      vector<Column>& columns) {
+  int width = matrix->getWidth();
+  ArrayRef<int> counters(new Array<int>(patternLength));
+  for (int x = 0; x < width;) {
+    ArrayRef<int> loc = findGuardPattern(matrix, x, row, width - x, false, pattern,
+                                         patternLength, counters);
+    if (!loc) {
+      break;
+    }
+    bool continued = false;
+    for (size_t i = 0; i < columns.size() && !continued; i++) {
+      Column& column = columns[i];
+      if (column.bottom >= row - 2 * rowStep && loc[0] < column.right && loc[1] > column.left) {
+        column.left = min(column.left, loc[0]);
+        column.right = max(column.right, loc[1]);
+        column.bottom = row;
+        continued = true;
+      }
+    }
+    if (!continued) {
+      Column column;
+      column.left = loc[0];
+      column.right = loc[1];
+      column.top = row;
+      column.bottom = row;
+      columns.push_back(column);
+    }
+    x = max(x + 1, loc[1]);
+  }
+}
+
+bool PDF417MultiDetector::overlapVertically(Column const& a, Column const& b, int rowStep) {
+  return max(a.top, b.top) <= min(a.bottom, b.bottom) + rowStep;
+}
+
+vector<DecodeHints::Region> PDF417MultiDetector::detectCandidates(DecodeHints const& hints) {
+  Ref<BitMatrix> matrix = image_->getBlackMatrix();
+  int height = matrix->getHeight();
+
+  // Same probing as the single symbol detector
+  int rowStep = ROW_STEP;
+  if (hints.getMinModuleSize() > 0) {
+    rowStep = max(rowStep, (int) (3 * hints.getMinModuleSize()));
+  }
+
+  // Upright symbols start left and stop right, upside down ones the reverse
+  vector<Column> lefts;
+  vector<Column> rights;
+  for (int row = 0; row < height; row += rowStep) {
+    findColumns(matrix, row, rowStep, START_PATTERN, START_PATTERN_LENGTH, lefts);
+    findColumns(matrix, row, rowStep, STOP_PATTERN_REVERSE, STOP_PATTERN_REVERSE_LENGTH, lefts);
+    findColumns(matrix, row, rowStep, STOP_PATTERN, STOP_PATTERN_LENGTH, rights);
+    findColumns(matrix, row, rowStep, START_PATTERN_REVERSE, START_PATTERN_REVERSE_LENGTH, rights);
+  }
+
+  vector<DecodeHints::Region> regions;
+  for (size_t i = 0; i < lefts.size() && (int) regions.size() < MAX_CANDIDATES; i++) {
+    Column const& left = lefts[i];
+    int best = -1;
+    for (size_t j = 0; j < rights.size(); j++) {
+      if (rights[j].left >= left.right && overlapVertically(left, rights[j], rowStep) &&
+          (best < 0 || rights[j].left < rights[best].left)) {
+        best = (int) j;
+      }
+    }
+    if (best < 0) {
+      continue;
+    }
+    Column const& right = rights[best];
+
+    // A left column in between is the one the right column belongs to
+    bool blocked = false;
+    for (size_t j = 0; j < lefts.size() && !blocked; j++) {
+      blocked = j != i && lefts[j].left >= left.right && lefts[j].right <= right.left &&
+                overlapVertically(lefts[j], right, rowStep);
+    }
+    if (blocked) {
+      continue;
+    }
+
+    // The first and last symbol rows may lie up to a probe outside the hits
+    int top = min(left.top, right.top) - rowStep;
+    int bottom = max(left.bottom, right.bottom) + rowStep;
+    if (!isInSearchRegion((left.left + right.right) / 2, (top + bottom) / 2, hints)) {
+      continue;
+    }
+    regions.push_back(DecodeHints::Region(left.left, top, right.right - left.left, bottom - top + 1));
+  }
+  return regions;
+}
@@ -0,0 +1,63 @@
+// -*- mode:c++; tab-width:2; indent-tabs-mode:nil; c-basic-offset:2 -*-
+#ifndef __PDF417_MULTI_DETECTOR_H__
+#define __PDF417_MULTI_DETECTOR_H__
+
+/*
+ *  PDF417MultiDetector.h
+ *  zxing
+ *
+ *  Copyright 2019 Matthew Breit <matt.breit@gmail.com>
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <zxing/pdf417/detector/Detector.h>
+#include <zxing/DecodeHints.h>
+#include <vector>
+
+namespace zxing {
+namespace multi {
+
+/**
+ * Finds every PDF417 symbol in an image by its guard patterns. Each probed
+ * row is searched for all start and stop patterns rather than the first,
+ * hits in successive rows are chained into the symbols' left and right
+ * columns, and each left column is paired with the nearest right column
+ * beside it. Upside down symbols are found by their reversed patterns.
+ */
+class PDF417MultiDetector : public zxing::pdf417::detector::Detector {
+private:
+  static const int MAX_CANDIDATES = 32;
+
+  // Guard pattern hits chained over successive probed rows
+  struct Column {
+    int left;
+    int right;
+    int top;
+    int bottom;
+  };
+
+  static void findColumns(Ref<BitMatrix> matrix, int row, int rowStep,
+                          const int pattern[], int patternLength,
+                          std::vector<Column>& columns);
+  static bool overlapVertically(Column const& a, Column const& b, int rowStep);
+
+public:
+  PDF417MultiDetector(Ref<BinaryBitmap> image);
+  std::vector<DecodeHints::Region> detectCandidates(DecodeHints const& hints);
+};
+
+}
+}
+
+#endif // __PDF417_MULTI_DETECTOR_H__
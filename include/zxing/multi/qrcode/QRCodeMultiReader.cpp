@@ -17,6 +17,7 @@
 
 #include <zxing/multi/qrcode/QRCodeMultiReader.h>
 #include <zxing/ReaderException.h>
+#include <zxing/TimeoutException.h>
 #include <zxing/multi/qrcode/detector/MultiDetector.h>
 #include <zxing/BarcodeFormat.h>
 
@@ -34,7 +35,11 @@ std::vector<Ref<Result> > QRCodeMultiReader::decodeMultiple(Ref<BinaryBitmap> im
 
   std::vector<Ref<DetectorResult> > detectorResult =  detector.detectMulti(hints);
   for (unsigned int i = 0; i < detectorResult.size(); i++) {
+    if (hints.isSatisfiedBy(results)) {
+      break;
+    }
     try {
+      hints.checkCancelled();
       Ref<DecoderResult> decoderResult = getDecoder().decode(detectorResult[i]->getBits());
       ArrayRef< Ref<ResultPoint> > points = detectorResult[i]->getPoints();
       Ref<Result> result = Ref<Result>(new Result(decoderResult->getText(),
@@ -46,6 +51,12 @@ std::vector<Ref<Result> > QRCodeMultiReader::decodeMultiple(Ref<BinaryBitmap> im
     } catch (ReaderException const& re) {
       (void)re;
       // ignore and continue 
+    } catch (TimeoutException const&) {
+      // Out of time: hand back what has been decoded so far
+      if (results.empty()) {
+        throw;
+      }
+      break;
     }
   }
   if (results.empty()){
@@ -32,6 +32,7 @@ std::vector<Ref<DetectorResult> > MultiDetector::detectMulti(DecodeHints hints){
   std::vector<Ref<FinderPatternInfo> > info = finder.findMulti(hints);
   std::vector<Ref<DetectorResult> > result;
   for(unsigned int i = 0; i < info.size(); i++){
+    hints.checkCancelled();
     try{
       result.push_back(processFinderPatternInfo(info[i]));
     } catch (ReaderException const& e){
@@ -17,13 +17,21 @@
 
 #include <cmath>
 #include <algorithm>
+#include <unordered_map>
 #include <zxing/multi/qrcode/detector/MultiFinderPatternFinder.h>
 #include <zxing/DecodeHints.h>
 #include <zxing/ReaderException.h>
 
 using std::abs;
+using std::floor;
+using std::log;
+using std::lower_bound;
+using std::max;
 using std::min;
+using std::pow;
 using std::sort;
+using std::unique;
+using std::unordered_map;
 using std::vector;
 using zxing::Ref;
 using zxing::BitMatrix;
@@ -42,6 +50,13 @@ const float MultiFinderPatternFinder::MAX_MODULE_COUNT_PER_EDGE = 180;
 const float MultiFinderPatternFinder::MIN_MODULE_COUNT_PER_EDGE = 9;
 const float MultiFinderPatternFinder::DIFF_MODSIZE_CUTOFF_PERCENT = 0.05f;
 const float MultiFinderPatternFinder::DIFF_MODSIZE_CUTOFF = 0.5f;
+// The longest edge that can pass the module count and edge length checks is
+// 2 * MAX_MODULE_COUNT_PER_EDGE / 2.1 * 1.1 (~189) modules of the smallest pattern; round up.
+const float MultiFinderPatternFinder::MAX_EDGE_MODULES = 198;
+const float MultiFinderPatternFinder::CANDIDATE_TOLERANCE = 0.12f;
+// The edge length and diagonal checks only let angles of about 78 to 102 degrees pass at the
+// top left corner
+const float MultiFinderPatternFinder::MAX_ANGLE_DEVIATION = 0.3f;
 
 namespace {
 
@@ -50,6 +65,27 @@ bool compareModuleSize(Ref<FinderPattern> a, Ref<FinderPattern> b){
   return value < 0.0;
 }
 
+const float PI = 3.14159265f;
+
+// Module sizes within one bucket differ by at most this ratio
+const float SIZE_BUCKET_RATIO = 1.25f;
+// Grid cells span this many modules of the largest size in their bucket
+const float CELL_MODULES = 100.0f;
+
+int sizeBucket(float moduleSize) {
+  return (int) floor(log(moduleSize) / log(SIZE_BUCKET_RATIO));
+}
+
+float bucketCellSize(int bucket) {
+  return pow(SIZE_BUCKET_RATIO, (float) (bucket + 1)) * CELL_MODULES;
+}
+
+long long cellKey(int bucket, int x, int y) {
+  return ((long long) (bucket & 0xFFFF) << 48) |
+      ((long long) (y & 0xFFFFFF) << 24) |
+      (long long) (x & 0xFFFFFF);
+}
+
 }
 
 MultiFinderPatternFinder::MultiFinderPatternFinder(Ref<BitMatrix> image, 
@@ -62,11 +98,8 @@ MultiFinderPatternFinder::~MultiFinderPatternFinder(){}
 
 vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeHints const& hints){
   bool tryHarder = hints.getTryHarder();
-  Ref<BitMatrix> image = image_; // Protected member
-  int maxI = image->getHeight();
-  int maxJ = image->getWidth();
-  // We are looking for black/white/black/white/black modules in
-  // 1:1:3:1:1 ratio; this tracks the number of such modules seen so far
+  threads_ = hints.getThreads();
+  int maxI = image_->getHeight();
 
   // Let's assume that the maximum version QR Code we support takes up 1/4 the height of the
   // image, and then account for the center being 3 modules in size. This gives the smallest
@@ -76,55 +109,20 @@ vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeHints
   if (iSkip < MIN_SKIP || tryHarder) {
     iSkip = MIN_SKIP;
   }
+  // A known module size replaces the guess: the center is 3 modules tall
+  if (hints.getMinModuleSize() > 0) {
+    iSkip = max(MIN_SKIP, (int) (3 * hints.getMinModuleSize()));
+  }
 
-  int stateCount[5];
   for (int i = iSkip - 1; i < maxI; i += iSkip) {
-    // Get a row of black/white values
-    stateCount[0] = 0;
-    stateCount[1] = 0;
-    stateCount[2] = 0;
-    stateCount[3] = 0;
-    stateCount[4] = 0;
-    int currentState = 0;
-    for (int j = 0; j < maxJ; j++) {
-      if (image->get(j, i)) {
-        // Black pixel
-        if ((currentState & 1) == 1) { // Counting white pixels
-          currentState++;
-        }
-        stateCount[currentState]++;
-      } else { // White pixel
-        if ((currentState & 1) == 0) { // Counting black pixels
-          if (currentState == 4) { // A winner?
-            if (foundPatternCross(stateCount) && handlePossibleCenter(stateCount, i, j)) { // Yes
-              // Clear state to start looking again
-              currentState = 0;
-              stateCount[0] = 0;
-              stateCount[1] = 0;
-              stateCount[2] = 0;
-              stateCount[3] = 0;
-              stateCount[4] = 0;
-            } else { // No, shift counts back by two
-              stateCount[0] = stateCount[2];
-              stateCount[1] = stateCount[3];
-              stateCount[2] = stateCount[4];
-              stateCount[3] = 1;
-              stateCount[4] = 0;
-              currentState = 3;
-            }
-          } else {
-            stateCount[++currentState]++;
-          }
-        } else { // Counting white pixels
-          stateCount[currentState]++;
-        }
+    hints.checkCancelled();
+    vector<RowHit> const& hits = getRowHits(i, iSkip);
+    for (size_t h = 0; h < hits.size(); h++) {
+      if (hints.acceptsModuleSize(hits[h].estimatedModuleSize)) {
+        addPossibleCenter(hits[h]);
       }
-    } // for j=...
-
-    if (foundPatternCross(stateCount)) {
-      handlePossibleCenter(stateCount, i, maxJ);
-    } // end if foundPatternCross
-  } // for i=iSkip-1 ...
+    }
+  }
   vector<vector<Ref<FinderPattern> > > patternInfo = selectBestPatterns();
   vector<Ref<FinderPatternInfo> > result;
   for (unsigned int i = 0; i < patternInfo.size(); i++) {
@@ -135,6 +133,14 @@ vector<Ref<FinderPatternInfo> > MultiFinderPatternFinder::findMulti(DecodeHints
   return result;
 }
 
+bool MultiFinderPatternFinder::moduleSizesDiffer(Ref<FinderPattern> a, Ref<FinderPattern> b) {
+  // The relative difference has to be taken as an absolute value: the candidates are sorted by
+  // ascending module size, so a signed difference would never exceed the cutoff.
+  float vModSizeA = abs(a->getEstimatedModuleSize() - b->getEstimatedModuleSize());
+  float vModSize = vModSizeA / min(a->getEstimatedModuleSize(), b->getEstimatedModuleSize());
+  return vModSizeA > DIFF_MODSIZE_CUTOFF && vModSize >= DIFF_MODSIZE_CUTOFF_PERCENT;
+}
+
 vector<vector<Ref<FinderPattern> > > MultiFinderPatternFinder::selectBestPatterns(){
   vector<Ref<FinderPattern> > possibleCenters = possibleCenters_;
   
@@ -156,7 +162,6 @@ vector<vector<Ref<FinderPattern> > > MultiFinderPatternFinder::selectBestPattern
   }
 
   // Sort by estimated module size to speed up the upcoming checks
-  //TODO do a sort based on module size
   sort(possibleCenters.begin(), possibleCenters.end(), compareModuleSize);
 
   /*
@@ -174,60 +179,149 @@ vector<vector<Ref<FinderPattern> > > MultiFinderPatternFinder::selectBestPattern
    * So, if the layout seems right, lets have the decoder try to decode.
    */
 
-  for (int i1 = 0; i1 < (size - 2); i1++) {
-    Ref<FinderPattern> p1 = possibleCenters[i1];
-    for (int i2 = i1 + 1; i2 < (size - 1); i2++) {
-      Ref<FinderPattern> p2 = possibleCenters[i2];
-      // Compare the expected module sizes; if they are really off, skip
-      float vModSize12 = (p1->getEstimatedModuleSize() - p2->getEstimatedModuleSize()) / min(p1->getEstimatedModuleSize(), p2->getEstimatedModuleSize());
-      float vModSize12A = abs(p1->getEstimatedModuleSize() - p2->getEstimatedModuleSize());
-      if (vModSize12A > DIFF_MODSIZE_CUTOFF && vModSize12 >= DIFF_MODSIZE_CUTOFF_PERCENT) {
-        // break, since elements are ordered by the module size deviation there cannot be
-        // any more interesting elements for the given p1.
-        break;
-      }
-      for (int i3 = i2 + 1; i3 < size; i3++) {
-        Ref<FinderPattern> p3 = possibleCenters[i3];
-        // Compare the expected module sizes; if they are really off, skip
-        float vModSize23 = (p2->getEstimatedModuleSize() - p3->getEstimatedModuleSize()) / min(p2->getEstimatedModuleSize(), p3->getEstimatedModuleSize());
-        float vModSize23A = abs(p2->getEstimatedModuleSize() - p3->getEstimatedModuleSize());
-        if (vModSize23A > DIFF_MODSIZE_CUTOFF && vModSize23 >= DIFF_MODSIZE_CUTOFF_PERCENT) {
-          // break, since elements are ordered by the module size deviation there cannot be
-          // any more interesting elements for the given p1.
-          break;
-        }
-        vector<Ref<FinderPattern> > test;
-        test.push_back(p1);
-        test.push_back(p2);
-        test.push_back(p3);
-        test = FinderPatternFinder::orderBestPatterns(test);
-        // Calculate the distances: a = topleft-bottomleft, b=topleft-topright, c = diagonal
-        Ref<FinderPatternInfo> info = Ref<FinderPatternInfo>(new FinderPatternInfo(test));
-        float dA = FinderPatternFinder::distance(info->getTopLeft(), info->getBottomLeft());
-        float dC = FinderPatternFinder::distance(info->getTopRight(), info->getBottomLeft());
-        float dB = FinderPatternFinder::distance(info->getTopLeft(), info->getTopRight());
-        // Check the sizes
-        float estimatedModuleCount = (dA + dB) / (p1->getEstimatedModuleSize() * 2.0f);
-        if (estimatedModuleCount > MAX_MODULE_COUNT_PER_EDGE || estimatedModuleCount < MIN_MODULE_COUNT_PER_EDGE) {
-          continue;
+  // Module size limits: sizeLimit[i] is the first later candidate whose module size is too far
+  // off from candidate i. Since the candidates are ordered by module size, no candidate past it
+  // can be combined with i either.
+  vector<int> sizeLimit(size);
+  for (int i = 0, j = 1; i < size; i++) {
+    if (j <= i) {
+      j = i + 1;
+    }
+    while (j < size && !moduleSizesDiffer(possibleCenters[i], possibleCenters[j])) {
+      j++;
+    }
+    sizeLimit[i] = j;
+  }
+
+  // File the candidates into a grid bucketed by module size, so that each candidate only meets
+  // the neighbours it could actually form a code with instead of every other candidate.
+  unordered_map<long long, vector<int> > cells;
+  for (int i = 0; i < size; i++) {
+    Ref<FinderPattern> p = possibleCenters[i];
+    int bucket = sizeBucket(p->getEstimatedModuleSize());
+    float cellSize = bucketCellSize(bucket);
+    cells[cellKey(bucket, (int) floor(p->getX() / cellSize), (int) floor(p->getY() / cellSize))].push_back(i);
+  }
+
+  // Use every candidate as the top left corner and pair up neighbours at roughly equal distance
+  // and right angle. The tolerances are a bit looser than the exact checks below, which decide.
+  vector<Triple> triples;
+  vector<Neighbour> neighbours;
+  float smallestSize = possibleCenters[0]->getEstimatedModuleSize();
+  int smallestBucket = sizeBucket(smallestSize);
+  int largestBucket = sizeBucket(possibleCenters[size - 1]->getEstimatedModuleSize());
+  for (int t = 0; t < size; t++) {
+    Ref<FinderPattern> pt = possibleCenters[t];
+    float moduleSize = pt->getEstimatedModuleSize();
+    float radius = MAX_EDGE_MODULES * moduleSize;
+    float minSize = min(moduleSize - 2 * DIFF_MODSIZE_CUTOFF, moduleSize * (1 - 2 * DIFF_MODSIZE_CUTOFF_PERCENT));
+    float maxSize = max(moduleSize + 2 * DIFF_MODSIZE_CUTOFF, moduleSize / (1 - 2 * DIFF_MODSIZE_CUTOFF_PERCENT));
+    int firstBucket = max(smallestBucket, sizeBucket(max(minSize, smallestSize)));
+    int lastBucket = min(largestBucket, sizeBucket(maxSize));
+
+    neighbours.clear();
+    for (int bucket = firstBucket; bucket <= lastBucket; bucket++) {
+      float cellSize = bucketCellSize(bucket);
+      int minX = (int) floor((pt->getX() - radius) / cellSize);
+      int maxX = (int) floor((pt->getX() + radius) / cellSize);
+      int minY = (int) floor((pt->getY() - radius) / cellSize);
+      int maxY = (int) floor((pt->getY() + radius) / cellSize);
+      for (int y = minY; y <= maxY; y++) {
+        for (int x = minX; x <= maxX; x++) {
+          unordered_map<long long, vector<int> >::const_iterator cell = cells.find(cellKey(bucket, x, y));
+          if (cell == cells.end()) {
+            continue;
+          }
+          for (size_t n = 0; n < cell->second.size(); n++) {
+            int q = cell->second[n];
+            Ref<FinderPattern> pq = possibleCenters[q];
+            float qSize = pq->getEstimatedModuleSize();
+            if (q == t ||
+                abs(qSize - moduleSize) > 2 * max(DIFF_MODSIZE_CUTOFF, DIFF_MODSIZE_CUTOFF_PERCENT * max(qSize, moduleSize))) {
+              continue;
+            }
+            float d = FinderPatternFinder::distance(pt, pq);
+            if (d > 0 && d <= radius) {
+              neighbours.push_back(Neighbour((float) atan2(pq->getY() - pt->getY(), pq->getX() - pt->getX()), d, q));
+            }
+          }
         }
-        // Calculate the difference of the edge lengths in percent
-        float vABBC = abs((dA - dB) / min(dA, dB));
-        if (vABBC >= 0.1f) {
+      }
+    }
+
+    // Sort the neighbours by direction and append them once more, a full turn later, so the
+    // window a quarter turn ahead of each neighbour can be searched without wrapping around.
+    sort(neighbours.begin(), neighbours.end());
+    size_t count = neighbours.size();
+    for (size_t n = 0; n < count; n++) {
+      Neighbour next = neighbours[n];
+      next.angle += 2 * PI;
+      neighbours.push_back(next);
+    }
+    for (size_t n1 = 0; n1 < count; n1++) {
+      Neighbour const& q1 = neighbours[n1];
+      Neighbour window(q1.angle + PI / 2 - MAX_ANGLE_DEVIATION, 0, 0);
+      for (vector<Neighbour>::const_iterator q2 = lower_bound(neighbours.begin(), neighbours.end(), window);
+           q2 != neighbours.end() && q2->angle <= q1.angle + PI / 2 + MAX_ANGLE_DEVIATION;
+           ++q2) {
+        if (max(q1.distance, q2->distance) > min(q1.distance, q2->distance) * (1 + CANDIDATE_TOLERANCE)) {
           continue;
         }
-        // Calculate the diagonal length by assuming a 90° angle at topleft
-        float dCpy = (float) sqrt(dA * dA + dB * dB);
-        // Compare to the real distance in %
-        float vPyC = abs((dC - dCpy) / min(dC, dCpy));
-        if (vPyC >= 0.1f) {
+        float diagonal = FinderPatternFinder::distance(possibleCenters[q1.index], possibleCenters[q2->index]);
+        float expected = (float) sqrt(q1.distance * q1.distance + q2->distance * q2->distance);
+        if (abs(diagonal - expected) > expected * CANDIDATE_TOLERANCE) {
           continue;
         }
-        // All tests passed!
-        results.push_back(test);
-      } // end iterate p3
-    } // end iterate p2
-  } // end iterate p1
+        int i[3] = { t, q1.index, q2->index };
+        sort(i, i + 3);
+        triples.push_back(Triple(i[0], i[1], i[2]));
+      }
+    }
+  }
+  sort(triples.begin(), triples.end());
+  triples.erase(unique(triples.begin(), triples.end()), triples.end());
+
+  for (size_t t = 0; t < triples.size(); t++) {
+    int i1 = triples[t].i1;
+    int i2 = triples[t].i2;
+    int i3 = triples[t].i3;
+    // Compare the expected module sizes; if they are really off, skip
+    if (i2 >= sizeLimit[i1] || i3 >= sizeLimit[i2]) {
+      continue;
+    }
+    Ref<FinderPattern> p1 = possibleCenters[i1];
+    Ref<FinderPattern> p2 = possibleCenters[i2];
+    Ref<FinderPattern> p3 = possibleCenters[i3];
+    vector<Ref<FinderPattern> > test;
+    test.push_back(p1);
+    test.push_back(p2);
+    test.push_back(p3);
+    test = FinderPatternFinder::orderBestPatterns(test);
+    // Calculate the distances: a = topleft-bottomleft, b=topleft-topright, c = diagonal
+    Ref<FinderPatternInfo> info = Ref<FinderPatternInfo>(new FinderPatternInfo(test));
+    float dA = FinderPatternFinder::distance(info->getTopLeft(), info->getBottomLeft());
+    float dC = FinderPatternFinder::distance(info->getTopRight(), info->getBottomLeft());
+    float dB = FinderPatternFinder::distance(info->getTopLeft(), info->getTopRight());
+    // Check the sizes
+    float estimatedModuleCount = (dA + dB) / (p1->getEstimatedModuleSize() * 2.0f);
+    if (estimatedModuleCount > MAX_MODULE_COUNT_PER_EDGE || estimatedModuleCount < MIN_MODULE_COUNT_PER_EDGE) {
+      continue;
+    }
+    // Calculate the difference of the edge lengths in percent
+    float vABBC = abs((dA - dB) / min(dA, dB));
+    if (vABBC >= 0.1f) {
+      continue;
+    }
+    // Calculate the diagonal length by assuming a 90° angle at topleft
+    float dCpy = (float) sqrt(dA * dA + dB * dB);
+    // Compare to the real distance in %
+    float vPyC = abs((dC - dCpy) / min(dC, dCpy));
+    if (vPyC >= 0.1f) {
+      continue;
+    }
+    // All tests passed!
+    results.push_back(test);
+  }
   if (results.empty()){
     // Nothing found!
     throw ReaderException("No code detected");    
@@ -26,12 +26,36 @@ namespace multi {
 
 class MultiFinderPatternFinder : zxing::qrcode::FinderPatternFinder {
   private:
+    struct Triple {
+      int i1, i2, i3;
+      Triple(int a, int b, int c) : i1(a), i2(b), i3(c) {}
+      bool operator<(Triple const& other) const {
+        if (i1 != other.i1) return i1 < other.i1;
+        if (i2 != other.i2) return i2 < other.i2;
+        return i3 < other.i3;
+      }
+      bool operator==(Triple const& other) const {
+        return i1 == other.i1 && i2 == other.i2 && i3 == other.i3;
+      }
+    };
+
+    struct Neighbour {
+      float angle, distance;
+      int index;
+      Neighbour(float a, float d, int i) : angle(a), distance(d), index(i) {}
+      bool operator<(Neighbour const& other) const { return angle < other.angle; }
+    };
+
     std::vector<std::vector<Ref<zxing::qrcode::FinderPattern> > > selectBestPatterns();
+    static bool moduleSizesDiffer(Ref<zxing::qrcode::FinderPattern> a, Ref<zxing::qrcode::FinderPattern> b);
 
     static const float MAX_MODULE_COUNT_PER_EDGE;
     static const float MIN_MODULE_COUNT_PER_EDGE;
     static const float DIFF_MODSIZE_CUTOFF_PERCENT;
     static const float DIFF_MODSIZE_CUTOFF;
+    static const float MAX_EDGE_MODULES;
+    static const float CANDIDATE_TOLERANCE;
+    static const float MAX_ANGLE_DEVIATION;
 
   public:
     MultiFinderPatternFinder(Ref<BitMatrix> image, Ref<ResultPointCallback> resultPointCallback);
@@ -20,8 +20,10 @@
 #include <zxing/ReaderException.h>
 #include <zxing/oned/OneDResultPoint.h>
 #include <zxing/NotFoundException.h>
+#include <zxing/common/Trace.h>
 #include <math.h>
 #include <limits.h>
+#include <algorithm>
 
 using std::vector;
 using zxing::Ref;
@@ -32,36 +34,193 @@ using zxing::oned::OneDReader;
 // VC++
 using zxing::BinaryBitmap;
 using zxing::BitArray;
+using zxing::BitMatrix;
 using zxing::DecodeHints;
 
 OneDReader::OneDReader() {}
 
 Ref<Result> OneDReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+  ZXING_TRACE_SPAN("OneDReader::decode");
+  DecodeHints::Orientation orientation = hints.getOrientation();
+  if (orientation == DecodeHints::ORIENTATION_VERTICAL) {
+    // Known to be read along the columns: only the rotated image can hold it
+    if (!image->isRotateSupported()) {
+      throw NotFoundException();
+    }
+    return doDecodeRotated(image, hints);
+  }
   try {
     return doDecode(image, hints);
   } catch (NotFoundException const& nfe) {
     // std::cerr << "trying harder" << std::endl;
     bool tryHarder = hints.getTryHarder();
+    if (orientation == DecodeHints::ORIENTATION_HORIZONTAL) {
+      // Rotated and tilted lines cannot hold a horizontal symbol
+      throw nfe;
+    }
     if (tryHarder && image->isRotateSupported()) {
-      // std::cerr << "v rotate" << std::endl;
-      Ref<BinaryBitmap> rotatedImage(image->rotateCounterClockwise());
-      // std::cerr << "^ rotate" << std::endl;
-      Ref<Result> result = doDecode(rotatedImage, hints);
-      // Doesn't have java metadata stuff
-      ArrayRef< Ref<ResultPoint> >& points (result->getResultPoints());
-      if (points && !points->empty()) {
-        int height = rotatedImage->getHeight();
-        for (int i = 0; i < points->size(); i++) {
-          points[i].reset(new OneDResultPoint(height - points[i]->getY() - 1, points[i]->getX()));
+      try {
+        return doDecodeRotated(image, hints);
+      } catch (NotFoundException const& ignored) {
+        (void)ignored;
+      }
+    }
+    if (tryHarder && hints.getScanlineAngleStep() > 0) {
+      return doDecodeTilted(image, hints);
+    }
+    // std::cerr << "tried harder nfe" << std::endl;
+    throw nfe;
+  }
+}
+
+Ref<Result> OneDReader::doDecodeRotated(Ref<BinaryBitmap> image, DecodeHints hints) {
+  // std::cerr << "v rotate" << std::endl;
+  Ref<BinaryBitmap> rotatedImage(image->rotateCounterClockwise());
+  // std::cerr << "^ rotate" << std::endl;
+  Ref<Result> result = doDecode(rotatedImage, hints);
+  // Doesn't have java metadata stuff
+  ArrayRef< Ref<ResultPoint> >& points (result->getResultPoints());
+  if (points && !points->empty()) {
+    int height = rotatedImage->getHeight();
+    for (int i = 0; i < points->size(); i++) {
+      points[i].reset(new OneDResultPoint(height - points[i]->getY() - 1, points[i]->getX()));
+    }
+  }
+  // std::cerr << "tried harder" << std::endl;
+  return result;
+}
+
+namespace {
+  // Scanlines step one pixel along their major axis and a fixed point fraction of a pixel
+  // along the other one, Bresenham style
+  const int SCANLINE_SHIFT = 16;
+  const int SCANLINE_HALF = 1 << (SCANLINE_SHIFT - 1);
+  // Tilted scanlines per angle, spread evenly across the image
+  const int SCANLINES_PER_ANGLE = 32;
+  const double DEGREES_TO_RADIANS = 3.14159265358979323846 / 180.0;
+}
+
+Ref<Result> OneDReader::doDecodeTilted(Ref<BinaryBitmap> image, DecodeHints hints) {
+  Ref<BitMatrix> matrix = image->getBlackMatrix();
+  int width = matrix->getWidth();
+  int height = matrix->getHeight();
+  Ref<BitArray> row;
+
+  // Horizontal and vertical lines have been covered by doDecode already. Lines at angle and
+  // at angle + 180 are the same line reversed, which doDecode handles by reversing the row,
+  // so angles in (0, 180) are enough. Try the angles closest to horizontal first.
+  int angleStep = hints.getScanlineAngleStep();
+  int lineNumber = 0;
+  for (int deviation = angleStep; deviation < 90; deviation += angleStep) {
+    for (int side = 0; side < 2; side++) {
+      int angle = side == 0 ? deviation : 180 - deviation;
+      double radians = angle * DEGREES_TO_RADIANS;
+      // Parameterise the lines along the axis they are closer to
+      bool xMajor = deviation < 45 || (deviation == 45 && side == 0);
+      double gradient = xMajor ? tan(radians) : 1.0 / tan(radians);
+      int slope = (int) floor(gradient * (1 << SCANLINE_SHIFT) + 0.5);
+      int major = xMajor ? width : height;
+      int minor = xMajor ? height : width;
+
+      // Intercepts on the minor axis at major coordinate 0 for which the line still crosses
+      // the image, scanned from the middle out
+      double minIntercept = std::min(0.0, -gradient * (major - 1));
+      double maxIntercept = std::max((double) (minor - 1), (minor - 1) - gradient * (major - 1));
+      double interceptStep = std::max(1.0, (maxIntercept - minIntercept) / SCANLINES_PER_ANGLE);
+      double middle = (minIntercept + maxIntercept) / 2;
+      int lines = (int) ((maxIntercept - minIntercept) / interceptStep) + 1;
+      for (int x = 0; x < lines; x++) {
+        int stepsAboveOrBelow = (x + 1) >> 1;
+        bool isAbove = (x & 0x01) == 0;
+        double intercept = middle + interceptStep * (isAbove ? stepsAboveOrBelow : -stepsAboveOrBelow);
+        if (intercept < minIntercept || intercept > maxIntercept) {
+          continue;
+        }
+        hints.checkCancelled();
+        Ref<Result> result =
+          decodeScanline(matrix, xMajor, (int) floor(intercept * (1 << SCANLINE_SHIFT) + 0.5), slope, lineNumber++, row);
+        if (result) {
+          return result;
         }
       }
-      // std::cerr << "tried harder" << std::endl;
-      return result;
-    } else {
-      // std::cerr << "tried harder nfe" << std::endl;
-      throw nfe;
     }
   }
+  throw NotFoundException();
+}
+
+// Samples the part of the line minor = intercept + major * slope (both fixed point) that lies
+// within the matrix into row and tries to decode it both ways. Result points are mapped back
+// onto the line.
+Ref<Result> OneDReader::decodeScanline(Ref<BitMatrix> const& matrix,
+                                       bool xMajor,
+                                       int intercept,
+                                       int slope,
+                                       int lineNumber,
+                                       Ref<BitArray>& row) {
+  int major = xMajor ? matrix->getWidth() : matrix->getHeight();
+  int minor = xMajor ? matrix->getHeight() : matrix->getWidth();
+
+  int start = 0;
+  int position = intercept + SCANLINE_HALF;
+  while (start < major && (position < 0 || (position >> SCANLINE_SHIFT) >= minor)) {
+    start++;
+    position += slope;
+  }
+  int end = start;
+  int endPosition = position;
+  while (end < major && endPosition >= 0 && (endPosition >> SCANLINE_SHIFT) < minor) {
+    end++;
+    endPosition += slope;
+  }
+  int length = end - start;
+  // Too short to hold a barcode worth finding this way
+  if (length < major / 4 || length < 2) {
+    return Ref<Result>();
+  }
+
+  if (!row || row->getSize() != length) {
+    row = new BitArray(length);
+  } else {
+    row->clear();
+  }
+  BitMatrix const& bits = *matrix;
+  for (int i = 0; i < length; i++, position += slope) {
+    int m = position >> SCANLINE_SHIFT;
+    if (xMajor ? bits.get(start + i, m) : bits.get(m, start + i)) {
+      row->set(i);
+    }
+  }
+
+  for (int attempt = 0; attempt < 2; attempt++) {
+    if (attempt == 1) {
+      row->reverse();
+    }
+    Ref<Result> result;
+    try {
+      result = decodeRow(lineNumber, row);
+    } catch (ReaderException const& re) {
+      (void)re;
+      continue;
+    }
+    if (!result) {
+      continue;
+    }
+    ArrayRef< Ref<ResultPoint> >& points (result->getResultPoints());
+    if (points) {
+      for (int i = 0; i < points->size(); i++) {
+        float along = points[i]->getX();
+        if (attempt == 1) {
+          along = length - along - 1;
+        }
+        float m = ((float) intercept + (start + along) * (float) slope) / (1 << SCANLINE_SHIFT);
+        float x = xMajor ? start + along : m;
+        float y = xMajor ? m : start + along;
+        points[i].reset(new OneDResultPoint(x, y));
+      }
+    }
+    return result;
+  }
+  return Ref<Result>();
 }
 
 #include <typeinfo>
@@ -84,6 +243,7 @@ Ref<Result> OneDReader::doDecode(Ref<BinaryBitmap> image, DecodeHints hints) {
   }
 
   for (int x = 0; x < maxLines; x++) {
+    hints.checkCancelled();
 
     // Scanning from the middle out. Determine which row we're looking at next:
     int rowStepsAboveOrBelow = (x + 1) >> 1;
@@ -29,6 +29,14 @@ namespace oned {
 class OneDReader : public Reader {
 private:
   Ref<Result> doDecode(Ref<BinaryBitmap> image, DecodeHints hints);
+  Ref<Result> doDecodeRotated(Ref<BinaryBitmap> image, DecodeHints hints);
+  Ref<Result> doDecodeTilted(Ref<BinaryBitmap> image, DecodeHints hints);
+  Ref<Result> decodeScanline(Ref<BitMatrix> const& matrix,
+                             bool xMajor,
+                             int intercept,
+                             int slope,
+                             int lineNumber,
+                             Ref<BitArray>& row);
 
 protected:
   static const int INTEGER_MATH_SHIFT = 8;
@@ -17,6 +17,7 @@
 
 #include <zxing/pdf417/PDF417Reader.h>
 #include <zxing/pdf417/detector/Detector.h>
+#include <zxing/common/Trace.h>
 
 using zxing::Ref;
 using zxing::Result;
@@ -30,6 +31,7 @@ using zxing::BinaryBitmap;
 using zxing::DecodeHints;
 
 Ref<Result> PDF417Reader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+  ZXING_TRACE_SPAN("PDF417Reader::decode");
   Ref<DecoderResult> decoderResult;
   /* 2012-05-30 hfn C++ DecodeHintType does not yet know a type "PURE_BARCODE", */
   /* therefore skip this for now, todo: may be add this type later */
@@ -53,6 +55,7 @@ Ref<Result> PDF417Reader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
       }
     }
   }
+  hints.checkCancelled();
   decoderResult = decoder.decode(detectorResult->getBits(),hints);
   /*
     }
@@ -20,6 +20,7 @@
 #include <zxing/FormatException.h>
 #include <zxing/pdf417/decoder/DecodedBitStreamParser.h>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/StringUtils.h>
 
 using std::string;
 using zxing::pdf417::DecodedBitStreamParser;
@@ -27,6 +28,7 @@ using zxing::ArrayRef;
 using zxing::Ref;
 using zxing::DecoderResult;
 using zxing::String;
+using zxing::common::StringUtils;
 
 const int DecodedBitStreamParser::TEXT_COMPACTION_MODE_LATCH = 900;
 const int DecodedBitStreamParser::BYTE_COMPACTION_MODE_LATCH = 901;
@@ -113,7 +115,12 @@ Ref<DecoderResult> DecodedBitStreamParser::decode(ArrayRef<int> codewords)
       throw FormatException();
     }
   }
-  return Ref<DecoderResult>(new DecoderResult(ArrayRef<char>(), result));
+  // Byte compaction yields ISO-8859-1; hand back UTF-8 like the other
+  // 2D decoders.
+  std::string const& latin1 = result->getText();
+  std::string utf8;
+  StringUtils::append(utf8, latin1.data(), latin1.size(), StringUtils::ISO88591);
+  return Ref<DecoderResult>(new DecoderResult(ArrayRef<char>(), Ref<String>(new String(utf8))));
 }
 
 /**
@@ -25,6 +25,7 @@
 #include <zxing/pdf417/decoder/DecodedBitStreamParser.h>
 #include <zxing/ReaderException.h>
 #include <zxing/common/reedsolomon/ReedSolomonException.h>
+#include <zxing/common/Metrics.h>
 
 using zxing::pdf417::decoder::Decoder;
 using zxing::pdf417::decoder::ec::ErrorCorrection;
@@ -36,6 +37,7 @@ using zxing::DecoderResult;
 using zxing::BitMatrix;
 using zxing::DecodeHints;
 using zxing::ArrayRef;
+using zxing::Metrics;
 
 const int Decoder::MAX_ERRORS = 3;
 const int Decoder::MAX_EC_CODEWORDS = 512;
@@ -57,6 +59,8 @@ Ref<DecoderResult> Decoder::decode(Ref<BitMatrix> bits, DecodeHints const& hints
   verifyCodewordCount(codewords, numECCodewords);
 
   // Decode the codewords
+  static const Metrics::Histogram parsing = Metrics::stage("parse");
+  Metrics::Timer timer(parsing);
   return DecodedBitStreamParser::decode(codewords);
 }
 
@@ -105,8 +109,12 @@ void Decoder::correctErrors(ArrayRef<int> codewords,
     throw FormatException("PDF:Decoder:correctErrors: Too many errors or EC Codewords corrupted");
   }
 
-  Ref<ErrorCorrection> errorCorrection(new ErrorCorrection);
-  errorCorrection->decode(codewords, numECCodewords, erasures);
+  {
+    static const Metrics::Histogram latency = Metrics::stage("rs_correct");
+    Metrics::Timer timer(latency);
+    Ref<ErrorCorrection> errorCorrection(new ErrorCorrection);
+    errorCorrection->decode(codewords, numECCodewords, erasures);
+  }
 
   // 2012-06-27 HFN if, despite of error correction, there are still codewords with invalid
   // value, throw an exception here:
@@ -21,8 +21,10 @@
 #include <zxing/common/GridSampler.h>
 #include <zxing/common/detector/JavaMath.h>
 #include <zxing/common/detector/MathUtils.h>
+#include <zxing/common/Trace.h>
 
 using std::max;
+using std::min;
 using std::abs;
 using std::numeric_limits;
 using zxing::pdf417::detector::Detector;
@@ -80,12 +82,17 @@ Ref<DetectorResult> Detector::detect() {
 }
 
 Ref<DetectorResult> Detector::detect(DecodeHints const& hints) {
-  (void)hints;
+  ZXING_TRACE_SPAN("pdf417::Detector::detect");
   // Fetch the 1 bit matrix once up front.
   Ref<BitMatrix> matrix = image_->getBlackMatrix();
 
-  // Try to find the vertices assuming the image is upright.
-  const int rowStep = 8;
+  // Try to find the vertices assuming the image is upright. Every row of
+  // the symbol is at least 3 modules tall, so with a known module size
+  // the scan can step one symbol row at a time.
+  int rowStep = ROW_STEP;
+  if (hints.getMinModuleSize() > 0) {
+    rowStep = max(rowStep, (int) (3 * hints.getMinModuleSize()));
+  }
   ArrayRef< Ref<ResultPoint> > vertices (findVertices(matrix, rowStep));
   if (!vertices) {
     // Maybe the image is rotated 180 degrees?
@@ -158,8 +165,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices(Ref<BitMatrix> matrix, int r
     ArrayRef<int> loc = findGuardPattern(matrix, 0, i, width, false, START_PATTERN,
                                          START_PATTERN_LENGTH, counters);
     if (loc) {
-      result[0] = new ResultPoint((float)loc[0], (float)i);
-      result[4] = new ResultPoint((float)loc[1], (float)i);
+      int row = findEdgeRow(matrix, 0, width, false, START_PATTERN,
+                            START_PATTERN_LENGTH, counters, i, rowStep, loc);
+      result[0] = new ResultPoint((float)loc[0], (float)row);
+      result[4] = new ResultPoint((float)loc[1], (float)row);
       found = true;
       break;
     }
@@ -171,8 +180,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices(Ref<BitMatrix> matrix, int r
       ArrayRef<int> loc = findGuardPattern(matrix, 0, i, width, false, START_PATTERN,
                                            START_PATTERN_LENGTH, counters);
       if (loc) {
-        result[1] = new ResultPoint((float)loc[0], (float)i);
-        result[5] = new ResultPoint((float)loc[1], (float)i);
+        int row = findEdgeRow(matrix, 0, width, false, START_PATTERN,
+                              START_PATTERN_LENGTH, counters, i, -rowStep, loc);
+        result[1] = new ResultPoint((float)loc[0], (float)row);
+        result[5] = new ResultPoint((float)loc[1], (float)row);
         found = true;
         break;
       }
@@ -188,8 +199,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices(Ref<BitMatrix> matrix, int r
       ArrayRef<int> loc = findGuardPattern(matrix, 0, i, width, false, STOP_PATTERN,
                                            STOP_PATTERN_LENGTH, counters);
       if (loc) {
-        result[2] = new ResultPoint((float)loc[1], (float)i);
-        result[6] = new ResultPoint((float)loc[0], (float)i);
+        int row = findEdgeRow(matrix, 0, width, false, STOP_PATTERN,
+                              STOP_PATTERN_LENGTH, counters, i, rowStep, loc);
+        result[2] = new ResultPoint((float)loc[1], (float)row);
+        result[6] = new ResultPoint((float)loc[0], (float)row);
         found = true;
         break;
       }
@@ -202,8 +215,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices(Ref<BitMatrix> matrix, int r
       ArrayRef<int> loc = findGuardPattern(matrix, 0, i, width, false, STOP_PATTERN,
                                            STOP_PATTERN_LENGTH, counters);
       if (loc) {
-        result[3] = new ResultPoint((float)loc[1], (float)i);
-        result[7] = new ResultPoint((float)loc[0], (float)i);
+        int row = findEdgeRow(matrix, 0, width, false, STOP_PATTERN,
+                              STOP_PATTERN_LENGTH, counters, i, -rowStep, loc);
+        result[3] = new ResultPoint((float)loc[1], (float)row);
+        result[7] = new ResultPoint((float)loc[0], (float)row);
         found = true;
         break;
       }
@@ -229,8 +244,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices180(Ref<BitMatrix> matrix, in
         findGuardPattern(matrix, halfWidth, i, halfWidth, true, START_PATTERN_REVERSE,
                          START_PATTERN_REVERSE_LENGTH, counters);
     if (loc) {
-      result[0] = new ResultPoint((float)loc[1], (float)i);
-      result[4] = new ResultPoint((float)loc[0], (float)i);
+      int row = findEdgeRow(matrix, halfWidth, halfWidth, true, START_PATTERN_REVERSE,
+                            START_PATTERN_REVERSE_LENGTH, counters, i, -rowStep, loc);
+      result[0] = new ResultPoint((float)loc[1], (float)row);
+      result[4] = new ResultPoint((float)loc[0], (float)row);
       found = true;
       break;
     }
@@ -243,8 +260,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices180(Ref<BitMatrix> matrix, in
           findGuardPattern(matrix, halfWidth, i, halfWidth, true, START_PATTERN_REVERSE,
                            START_PATTERN_REVERSE_LENGTH, counters);
       if (loc) {
-        result[1] = new ResultPoint((float)loc[1], (float)i);
-        result[5] = new ResultPoint((float)loc[0], (float)i);
+        int row = findEdgeRow(matrix, halfWidth, halfWidth, true, START_PATTERN_REVERSE,
+                              START_PATTERN_REVERSE_LENGTH, counters, i, rowStep, loc);
+        result[1] = new ResultPoint((float)loc[1], (float)row);
+        result[5] = new ResultPoint((float)loc[0], (float)row);
         found = true;
         break;
       }
@@ -260,8 +279,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices180(Ref<BitMatrix> matrix, in
       ArrayRef<int> loc = findGuardPattern(matrix, 0, i, halfWidth, false, STOP_PATTERN_REVERSE,
                                            STOP_PATTERN_REVERSE_LENGTH, counters);
       if (loc) {
-        result[2] = new ResultPoint((float)loc[0], (float)i);
-        result[6] = new ResultPoint((float)loc[1], (float)i);
+        int row = findEdgeRow(matrix, 0, halfWidth, false, STOP_PATTERN_REVERSE,
+                              STOP_PATTERN_REVERSE_LENGTH, counters, i, -rowStep, loc);
+        result[2] = new ResultPoint((float)loc[0], (float)row);
+        result[6] = new ResultPoint((float)loc[1], (float)row);
         found = true;
         break;
       }
@@ -274,8 +295,10 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices180(Ref<BitMatrix> matrix, in
       ArrayRef<int> loc = findGuardPattern(matrix, 0, i, halfWidth, false, STOP_PATTERN_REVERSE,
                                            STOP_PATTERN_REVERSE_LENGTH, counters);
       if (loc) {
-        result[3] = new ResultPoint((float)loc[0], (float)i);
-        result[7] = new ResultPoint((float)loc[1], (float)i);
+        int row = findEdgeRow(matrix, 0, halfWidth, false, STOP_PATTERN_REVERSE,
+                              STOP_PATTERN_REVERSE_LENGTH, counters, i, rowStep, loc);
+        result[3] = new ResultPoint((float)loc[0], (float)row);
+        result[7] = new ResultPoint((float)loc[1], (float)row);
         found = true;
         break;
       }
@@ -285,6 +308,43 @@ ArrayRef< Ref<ResultPoint> > Detector::findVertices180(Ref<BitMatrix> matrix, in
   return found ? result : ArrayRef< Ref<ResultPoint> >();
 }
 
+/**
+ * The vertex scans step rowStep rows at a time, so the first row found to
+ * hold a guard pattern may lie up to rowStep - 1 rows inside the symbol.
+ * Searches the rows between it and the last row scanned without the
+ * pattern, halving the gap, for the row nearest the edge that holds it.
+ *
+ * @param row the row the scan found the pattern in
+ * @param step the scan's step, negative when it went upwards
+ * @param loc the pattern found in row, replaced by the one in the row returned
+ * @return the refined row
+ */
+int Detector::findEdgeRow(Ref<BitMatrix> matrix,
+                          int column,
+                          int width,
+                          bool whiteFirst,
+                          const int pattern[],
+                          int patternSize,
+                          ArrayRef<int>& counters,
+                          int row,
+                          int step,
+                          ArrayRef<int>& loc) {
+  // The last row known to lie outside, clipped to just off the matrix
+  int outside = max(-1, min(matrix->getHeight(), row - step));
+  while (abs(row - outside) > 1) {
+    int middle = (row + outside) / 2;
+    ArrayRef<int> middleLoc = findGuardPattern(matrix, column, middle, width, whiteFirst, pattern,
+                                               patternSize, counters);
+    if (middleLoc) {
+      row = middle;
+      loc = middleLoc;
+    } else {
+      outside = middle;
+    }
+  }
+  return row;
+}
+
 /**
  * @param matrix row of black/white values to search
  * @param column x position to start search
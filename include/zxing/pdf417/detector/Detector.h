@@ -31,11 +31,13 @@ namespace pdf417 {
 namespace detector {
 
 class Detector {
-private:
+protected:
   static const int INTEGER_MATH_SHIFT = 8;
   static const int PATTERN_MATCH_RESULT_SCALE_FACTOR = 1 << INTEGER_MATH_SHIFT;
   static const int MAX_AVG_VARIANCE;
   static const int MAX_INDIVIDUAL_VARIANCE;
+  // Rows between start/stop pattern probes when the module size is unknown
+  static const int ROW_STEP = 8;
 
   static const int START_PATTERN[];
   static const int START_PATTERN_LENGTH;
@@ -59,6 +61,16 @@ private:
                                         const int pattern[],
                                         int patternSize,
                                         ArrayRef<int>& counters);
+  static int findEdgeRow(Ref<BitMatrix> matrix,
+                         int column,
+                         int width,
+                         bool whiteFirst,
+                         const int pattern[],
+                         int patternSize,
+                         ArrayRef<int>& counters,
+                         int row,
+                         int step,
+                         ArrayRef<int>& loc);
   static int patternMatchVariance(ArrayRef<int>& counters, const int pattern[],
                                   int maxIndividualVariance);
 
@@ -16,6 +16,8 @@
  */
 
 #include <map>
+#include <algorithm>
+#include <limits>
 #include <zxing/pdf417/detector/LinesSampler.h>
 #include <zxing/pdf417/decoder/BitMatrixParser.h>
 #include <zxing/NotFoundException.h>
@@ -109,6 +111,79 @@ vector<float> LinesSampler::init_ratios_table() {
 
 const vector<float> LinesSampler::RATIOS_TABLE = init_ratios_table();
 
+namespace {
+
+// Orders symbols by their ratios, first bar first, and equal ones by index
+class ByRatios {
+ private:
+  const vector<float>& ratios_;
+  const int bars_;
+ public:
+  ByRatios(const vector<float>& ratios, int bars) : ratios_(ratios), bars_(bars) {}
+  bool operator()(int a, int b) const {
+    for (int k = 0; k < bars_; k++) {
+      if (ratios_[a * bars_ + k] != ratios_[b * bars_ + k]) {
+        return ratios_[a * bars_ + k] < ratios_[b * bars_ + k];
+      }
+    }
+    return a < b;
+  }
+};
+
+}
+
+vector<LinesSampler::SymbolNode> LinesSampler::init_symbol_tree() {
+  // Sorted, the symbols below any node of the tree are next to each other.
+  vector<int> order(POSSIBLE_SYMBOLS);
+  for (int i = 0; i < POSSIBLE_SYMBOLS; i++) {
+    order[i] = i;
+  }
+  std::sort(order.begin(), order.end(), ByRatios(RATIOS_TABLE, BARS_IN_SYMBOL));
+
+  vector<SymbolNode> tree(1);
+  tree[0].ratio = 0.0f;
+  tree[0].symbol = -1;
+  addSymbolChildren(tree, 0, order, 0, POSSIBLE_SYMBOLS, 0);
+  return tree;
+}
+
+// Adds a child to node for each ratio the bar at depth has in the symbols
+// order[begin, end), then the children of those.
+void LinesSampler::addSymbolChildren(vector<SymbolNode>& tree, int node,
+                                     const vector<int>& order,
+                                     int begin, int end, int depth) {
+  vector<int> starts;
+  for (int i = begin; i < end; i++) {
+    if (i == begin ||
+        RATIOS_TABLE[order[i] * BARS_IN_SYMBOL + depth] != RATIOS_TABLE[order[i - 1] * BARS_IN_SYMBOL + depth]) {
+      starts.push_back(i);
+    }
+  }
+  starts.push_back(end);
+
+  const int firstChild = (int)tree.size();
+  const int children = (int)starts.size() - 1;
+  tree[node].firstChild = firstChild;
+  tree[node].children = children;
+  for (int c = 0; c < children; c++) {
+    SymbolNode child;
+    child.ratio = RATIOS_TABLE[order[starts[c]] * BARS_IN_SYMBOL + depth];
+    child.firstChild = 0;
+    child.children = 0;
+    // Should two symbols have the same ratios, the first is the one found.
+    child.symbol = depth == BARS_IN_SYMBOL - 1 ? order[starts[c]] : -1;
+    tree.push_back(child);
+  }
+  if (depth < BARS_IN_SYMBOL - 1) {
+    for (int c = 0; c < children; c++) {
+      addSymbolChildren(tree, firstChild + c, order, starts[c], starts[c + 1], depth + 1);
+    }
+  }
+}
+
+// Built once, before any thread decodes, and only read after.
+const vector<LinesSampler::SymbolNode> LinesSampler::SYMBOL_TREE = init_symbol_tree();
+
 LinesSampler::LinesSampler(Ref<BitMatrix> linesMatrix, int dimension)
     : linesMatrix_(linesMatrix), dimension_(dimension) {}
 
@@ -399,26 +474,7 @@ void LinesSampler::linesMatrixToCodewords(vector<vector<int> >& clusterNumbers,
         }
       }
 
-      float bestMatchError = std::numeric_limits<float>::max();
-      int bestMatch = 0;
-
-      // Search for the most possible codeword by comparing the ratios of bar size to symbol width.
-      // The sum of the squared differences is used as similarity metric.
-      // (Picture it as the square euclidian distance in the space of eight tuples where a tuple represents the bar ratios.)
-      for (int j = 0; j < POSSIBLE_SYMBOLS; j++) {
-        float error = 0.0f;
-        for (int k = 0; k < BARS_IN_SYMBOL; k++) {
-          float diff = RATIOS_TABLE[j * BARS_IN_SYMBOL + k] - cwRatios[i][k];
-          error += diff * diff;
-          if (error >= bestMatchError) {
-            break;
-          }
-        }
-        if (error < bestMatchError) {
-          bestMatchError = error;
-          bestMatch = BitMatrixParser::SYMBOL_TABLE[j];
-        }
-      }
+      int bestMatch = findBestSymbol(cwRatios[i]);
       codewords[y][i] = bestMatch;
       clusterNumbers[y][i] = calculateClusterNumber(bestMatch);
     }
@@ -449,6 +505,53 @@ void LinesSampler::linesMatrixToCodewords(vector<vector<int> >& clusterNumbers,
 #endif
 }
 
+// Search for the most possible codeword by comparing the ratios of bar size to symbol width.
+// The sum of the squared differences is used as similarity metric.
+// (Picture it as the square euclidian distance in the space of eight tuples where a tuple represents the bar ratios.)
+// The symbol found is the one a comparison with every entry of RATIOS_TABLE in turn would find: the first of those
+// with the least error, summed bar by bar in the same order, so to the same float.
+int LinesSampler::findBestSymbol(const vector<float>& ratios) {
+  float bestError = std::numeric_limits<float>::max();
+  int best = -1;
+  searchSymbolTree(0, 0, 0.0f, ratios, bestError, best);
+  return best < 0 ? 0 : BitMatrixParser::SYMBOL_TABLE[best];
+}
+
+// Visits the children of node nearest first, skipping those whose error is
+// already more than the best; adding the error of more bars cannot lower it.
+void LinesSampler::searchSymbolTree(int node, int depth, float error,
+                                    const vector<float>& ratios,
+                                    float& bestError, int& best) {
+  const SymbolNode& parent = SYMBOL_TREE[node];
+  float errors[MODULES_IN_SYMBOL];
+  int nearest[MODULES_IN_SYMBOL];
+  int count = 0;
+  for (int c = 0; c < parent.children; c++) {
+    float diff = SYMBOL_TREE[parent.firstChild + c].ratio - ratios[depth];
+    float childError = error + diff * diff;
+    int at = count++;
+    for (; at > 0 && errors[at - 1] > childError; at--) {
+      errors[at] = errors[at - 1];
+      nearest[at] = nearest[at - 1];
+    }
+    errors[at] = childError;
+    nearest[at] = parent.firstChild + c;
+  }
+
+  for (int c = 0; c < count; c++) {
+    const SymbolNode& child = SYMBOL_TREE[nearest[c]];
+    if (errors[c] > bestError) {
+      continue;
+    }
+    if (child.symbol < 0) {
+      searchSymbolTree(nearest[c], depth + 1, errors[c], ratios, bestError, best);
+    } else if (errors[c] < bestError || (errors[c] == bestError && best >= 0 && child.symbol < best)) {
+      bestError = errors[c];
+      best = child.symbol;
+    }
+  }
+}
+
 vector<vector<map<int,  int> > >
 LinesSampler::distributeVotes(const int symbolsPerLine,
                               const vector<vector<int> >& codewords,
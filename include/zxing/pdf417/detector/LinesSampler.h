@@ -33,6 +33,26 @@ private:
   static const int POSSIBLE_SYMBOLS = 2787;
   static const std::vector<float> RATIOS_TABLE;
   static std::vector<float> init_ratios_table();
+
+  // RATIOS_TABLE as a tree of the symbols' bar ratios, first bar at the
+  // root, so symbols sharing their first bars share the error of those bars
+  struct SymbolNode {
+    float ratio;
+    // The children of a node are next to each other in SYMBOL_TREE
+    int firstChild;
+    int children;
+    // Index into RATIOS_TABLE of the symbol at a leaf, -1 elsewhere
+    int symbol;
+  };
+  static const std::vector<SymbolNode> SYMBOL_TREE;
+  static std::vector<SymbolNode> init_symbol_tree();
+  static void addSymbolChildren(std::vector<SymbolNode> &tree, int node,
+                                const std::vector<int> &order,
+                                int begin, int end, int depth);
+  static void searchSymbolTree(int node, int depth, float error,
+                               const std::vector<float> &ratios,
+                               float &bestError, int &best);
+  static int findBestSymbol(const std::vector<float> &ratios);
   static const int BARCODE_START_OFFSET = 2;
 
   Ref<BitMatrix> linesMatrix_;
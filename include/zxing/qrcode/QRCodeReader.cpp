@@ -21,6 +21,7 @@
 
 #include <zxing/qrcode/QRCodeReader.h>
 #include <zxing/qrcode/detector/Detector.h>
+#include <zxing/common/Trace.h>
 
 #include <iostream>
 
@@ -33,9 +34,11 @@ namespace zxing {
 		}
 		//TODO: see if any of the other files in the qrcode tree need tryHarder
 		Ref<Result> QRCodeReader::decode(Ref<BinaryBitmap> image, DecodeHints hints) {
+			ZXING_TRACE_SPAN("QRCodeReader::decode");
 			Detector detector(image->getBlackMatrix());
 			Ref<DetectorResult> detectorResult(detector.detect(hints));
 			ArrayRef< Ref<ResultPoint> > points (detectorResult->getPoints());
+			hints.checkCancelled();
 			Ref<DecoderResult> decoderResult(decoder_.decode(detectorResult->getBits()));
 			Ref<Result> result(
 							   new Result(decoderResult->getText(), decoderResult->getRawBytes(), points, BarcodeFormat::QR_CODE));
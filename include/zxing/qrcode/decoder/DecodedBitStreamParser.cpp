@@ -24,19 +24,6 @@
 #include <zxing/FormatException.h>
 #include <zxing/common/StringUtils.h>
 #include <iostream>
-#ifndef NO_ICONV
-#include <iconv.h>
-#endif
-
-// Required for compatibility. TODO: test on Symbian
-#ifdef ZXING_ICONV_CONST
-#undef ICONV_CONST
-#define ICONV_CONST const
-#endif
-
-#ifndef ICONV_CONST
-#define ICONV_CONST /**/
-#endif
 
 using namespace std;
 using namespace zxing;
@@ -62,42 +49,7 @@ void DecodedBitStreamParser::append(std::string &result,
                                     const char *bufIn,
                                     size_t nIn,
                                     const char *src) {
-#ifndef NO_ICONV
-  if (nIn == 0) {
-    return;
-  }
-
-  iconv_t cd = iconv_open(StringUtils::UTF8, src);
-  if (cd == (iconv_t)-1) {
-    result.append((const char *)bufIn, nIn);
-    return;
-  }
-
-  const int maxOut = 4 * nIn + 1;
-  char* bufOut = new char[maxOut];
-
-  ICONV_CONST char *fromPtr = (ICONV_CONST char *)bufIn;
-  size_t nFrom = nIn;
-  char *toPtr = (char *)bufOut;
-  size_t nTo = maxOut;
-
-  while (nFrom > 0) {
-    size_t oneway = iconv(cd, &fromPtr, &nFrom, &toPtr, &nTo);
-    if (oneway == (size_t)(-1)) {
-      iconv_close(cd);
-      delete[] bufOut;
-      throw ReaderException("error converting characters");
-    }
-  }
-  iconv_close(cd);
-
-  int nResult = maxOut - nTo;
-  bufOut[nResult] = '\0';
-  result.append((const char *)bufOut);
-  delete[] bufOut;
-#else
-  result.append((const char *)bufIn, nIn);
-#endif
+  StringUtils::append(result, bufIn, nIn, src);
 }
 
 void DecodedBitStreamParser::decodeHanziSegment(Ref<BitSource> bits_,
@@ -28,6 +28,7 @@
 #include <zxing/ReaderException.h>
 #include <zxing/ChecksumException.h>
 #include <zxing/common/reedsolomon/ReedSolomonException.h>
+#include <zxing/common/Metrics.h>
 
 using zxing::qrcode::Decoder;
 using zxing::DecoderResult;
@@ -36,6 +37,7 @@ using zxing::Ref;
 // VC++
 using zxing::ArrayRef;
 using zxing::BitMatrix;
+using zxing::Metrics;
 
 Decoder::Decoder() :
   rsDecoder_(GenericGF::QR_CODE_FIELD_256) {
@@ -74,6 +76,12 @@ Ref<DecoderResult> Decoder::decode(Ref<BitMatrix> bits) {
   // Read codewords
   ArrayRef<char> codewords(parser.readCodewords());
 
+  // The same label seen again samples to the same codewords
+  std::string key = DecoderResultCache::makeKey(version->getVersionNumber(), ecLevel.ordinal(), codewords);
+  Ref<DecoderResult> cached = resultCache_.get(key);
+  if (!cached.empty()) {
+    return cached;
+  }
 
   // Separate into data blocks
   std::vector<Ref<DataBlock> > dataBlocks(DataBlock::getDataBlocks(codewords, version, ecLevel));
@@ -99,9 +107,20 @@ Ref<DecoderResult> Decoder::decode(Ref<BitMatrix> bits) {
     }
   }
 
-  return DecodedBitStreamParser::decode(resultBytes,
-                                        version,
-                                        ecLevel,
-                                        DecodedBitStreamParser::Hashtable());
+  Ref<DecoderResult> result;
+  {
+    static const Metrics::Histogram parsing = Metrics::stage("parse");
+    Metrics::Timer timer(parsing);
+    result = DecodedBitStreamParser::decode(resultBytes,
+                                            version,
+                                            ecLevel,
+                                            DecodedBitStreamParser::Hashtable());
+  }
+  resultCache_.put(key, result);
+  return result;
+}
+
+zxing::DecoderResultCache& Decoder::getResultCache() {
+  return resultCache_;
 }
 
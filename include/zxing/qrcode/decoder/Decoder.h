@@ -24,6 +24,7 @@
 #include <zxing/common/Counted.h>
 #include <zxing/common/Array.h>
 #include <zxing/common/DecoderResult.h>
+#include <zxing/common/DecoderResultCache.h>
 #include <zxing/common/BitMatrix.h>
 
 namespace zxing {
@@ -32,12 +33,14 @@ namespace qrcode {
 class Decoder {
 private:
   ReedSolomonDecoder rsDecoder_;
+  DecoderResultCache resultCache_;
 
   void correctErrors(ArrayRef<char> bytes, int numDataCodewords);
 
 public:
   Decoder();
   Ref<DecoderResult> decode(Ref<BitMatrix> bits);
+  DecoderResultCache& getResultCache();
 };
 
 }
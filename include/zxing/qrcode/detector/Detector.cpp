@@ -28,6 +28,7 @@
 #include <zxing/common/GridSampler.h>
 #include <zxing/DecodeHints.h>
 #include <zxing/common/detector/MathUtils.h>
+#include <zxing/common/Trace.h>
 #include <sstream>
 #include <cstdlib>
 
@@ -63,6 +64,7 @@ Ref<ResultPointCallback> Detector::getResultPointCallback() const {
 }
 
 Ref<DetectorResult> Detector::detect(DecodeHints const& hints) {
+  ZXING_TRACE_SPAN("qrcode::Detector::detect");
   callback_ = hints.getResultPointCallback();
   FinderPatternFinder finder(image_, hints.getResultPointCallback());
   Ref<FinderPatternInfo> info(finder.find(hints));
@@ -20,14 +20,19 @@
  */
 
 #include <algorithm>
+#include <cmath>
+#include <thread>
 #include <zxing/qrcode/detector/FinderPatternFinder.h>
 #include <zxing/ReaderException.h>
 #include <zxing/DecodeHints.h>
 
 using std::sort;
+using std::min;
 using std::max;
 using std::abs;
 using std::vector;
+using std::thread;
+using zxing::BitArray;
 using zxing::Ref;
 using zxing::qrcode::FinderPatternFinder;
 using zxing::qrcode::FinderPattern;
@@ -56,6 +61,14 @@ public:
   }
 };
 
+int gridCell(float position, float cellSize) {
+  return (int)std::floor(position / cellSize);
+}
+
+long long gridKey(int cellX, int cellY) {
+  return (long long)(((unsigned long long)(unsigned int)cellY << 32) | (unsigned int)cellX);
+}
+
 class CenterComparator {
   const float averageModuleSize_;
 public:
@@ -79,6 +92,7 @@ public:
 int FinderPatternFinder::CENTER_QUORUM = 2;
 int FinderPatternFinder::MIN_SKIP = 3;
 int FinderPatternFinder::MAX_MODULES = 57;
+int FinderPatternFinder::ROWS_PER_THREAD = 16;
 
 float FinderPatternFinder::centerFromEnd(int* stateCount, int end) {
   return (float)(end - stateCount[4] - stateCount[3]) - stateCount[2] / 2.0f;
@@ -234,37 +248,171 @@ float FinderPatternFinder::crossCheckHorizontal(size_t startJ, size_t centerI, i
   return foundPatternCross(stateCount) ? centerFromEnd(stateCount, j) : nan();
 }
 
-bool FinderPatternFinder::handlePossibleCenter(int* stateCount, size_t i, size_t j) {
+bool FinderPatternFinder::crossCheckCenter(int* stateCount, size_t i, size_t j, RowHit& hit) {
   int stateCountTotal = stateCount[0] + stateCount[1] + stateCount[2] + stateCount[3] + stateCount[4];
   float centerJ = centerFromEnd(stateCount, j);
   float centerI = crossCheckVertical(i, (size_t)centerJ, stateCount[2], stateCountTotal);
-  if (!isnan(centerI)) {
-    // Re-cross check
-    centerJ = crossCheckHorizontal((size_t)centerJ, (size_t)centerI, stateCount[2], stateCountTotal);
-    if (!isnan(centerJ)) {
-      float estimatedModuleSize = (float)stateCountTotal / 7.0f;
-      bool found = false;
-      size_t max = possibleCenters_.size();
-      for (size_t index = 0; index < max; index++) {
-        Ref<FinderPattern> center = possibleCenters_[index];
+  if (isnan(centerI)) {
+    return false;
+  }
+  // Re-cross check
+  centerJ = crossCheckHorizontal((size_t)centerJ, (size_t)centerI, stateCount[2], stateCountTotal);
+  if (isnan(centerJ)) {
+    return false;
+  }
+  hit.centerI = centerI;
+  hit.centerJ = centerJ;
+  hit.estimatedModuleSize = (float)stateCountTotal / 7.0f;
+  hit.firstCount = stateCount[0];
+  hit.centerCount = stateCount[2];
+  return true;
+}
+
+void FinderPatternFinder::addPossibleCenter(RowHit const& hit) {
+  // aboutEquals() only accepts centers within one module of the hit, so with cells at least a
+  // module wide the neighbouring cells hold every candidate. Widen the cells when needed.
+  if (hit.estimatedModuleSize > grid_.cellSize) {
+    grid_.cellSize = 2.0f * hit.estimatedModuleSize;
+    grid_.cells.clear();
+    for (size_t index = 0; index < possibleCenters_.size(); index++) {
+      Ref<FinderPattern> center = possibleCenters_[index];
+      grid_.cells[gridKey(gridCell(center->getX(), grid_.cellSize), gridCell(center->getY(), grid_.cellSize))]
+        .push_back(index);
+    }
+  }
+
+  // Like a linear search of possibleCenters_, the earliest matching center wins
+  int cellX = gridCell(hit.centerJ, grid_.cellSize);
+  int cellY = gridCell(hit.centerI, grid_.cellSize);
+  int match = -1;
+  for (int y = cellY - 1; y <= cellY + 1; y++) {
+    for (int x = cellX - 1; x <= cellX + 1; x++) {
+      std::unordered_map<long long, vector<int> >::const_iterator cell = grid_.cells.find(gridKey(x, y));
+      if (cell == grid_.cells.end()) {
+        continue;
+      }
+      for (size_t c = 0; c < cell->second.size(); c++) {
+        int index = cell->second[c];
         // Look for about the same center and module size:
-        if (center->aboutEquals(estimatedModuleSize, centerI, centerJ)) {
-          possibleCenters_[index] = center->combineEstimate(centerI, centerJ, estimatedModuleSize);
-          found = true;
-          break;
+        if ((match < 0 || index < match) &&
+            possibleCenters_[index]->aboutEquals(hit.estimatedModuleSize, hit.centerI, hit.centerJ)) {
+          match = index;
         }
       }
-      if (!found) {
-        Ref<FinderPattern> newPattern(new FinderPattern(centerJ, centerI, estimatedModuleSize));
-        possibleCenters_.push_back(newPattern);
-        if (callback_ != 0) {
-          callback_->foundPossibleResultPoint(*newPattern);
-        }
+    }
+  }
+
+  if (match < 0) {
+    Ref<FinderPattern> newPattern(new FinderPattern(hit.centerJ, hit.centerI, hit.estimatedModuleSize));
+    grid_.cells[gridKey(cellX, cellY)].push_back(possibleCenters_.size());
+    possibleCenters_.push_back(newPattern);
+    if (callback_ != 0) {
+      callback_->foundPossibleResultPoint(*newPattern);
+    }
+    return;
+  }
+
+  Ref<FinderPattern> center = possibleCenters_[match];
+  Ref<FinderPattern> combined = center->combineEstimate(hit.centerI, hit.centerJ, hit.estimatedModuleSize);
+  possibleCenters_[match] = combined;
+  long long oldKey = gridKey(gridCell(center->getX(), grid_.cellSize), gridCell(center->getY(), grid_.cellSize));
+  long long newKey = gridKey(gridCell(combined->getX(), grid_.cellSize), gridCell(combined->getY(), grid_.cellSize));
+  if (oldKey != newKey) {
+    vector<int>& oldCell = grid_.cells[oldKey];
+    oldCell.erase(std::find(oldCell.begin(), oldCell.end(), match));
+    grid_.cells[newKey].push_back(match);
+  }
+}
+
+void FinderPatternFinder::scanRow(size_t i, Ref<BitArray>& row, vector<int>& runs, vector<RowHit>& hits) {
+  // Run-length encode the row, starting with a (possibly empty) white run
+  int maxJ = image_->getWidth();
+  row = image_->getRow(i, row);
+  runs.clear();
+  int position = 0;
+  bool black = false;
+  do {
+    int next = black ? row->getNextUnset(position) : row->getNextSet(position);
+    runs.push_back(next - position);
+    position = next;
+    black = !black;
+  } while (position < maxJ);
+
+  // We are looking for black/white/black/white/black modules in 1:1:3:1:1 ratio. Every five runs
+  // starting on a black run are a candidate; after a miss move on by one black/white pair, after
+  // a confirmed center resume behind the white run that follows it.
+  int stateCount[5];
+  size_t runCount = runs.size();
+  size_t start = runs[0];
+  size_t k = 1;
+  hits.clear();
+  while (k + 4 < runCount) {
+    size_t j = start;
+    for (int s = 0; s < 5; s++) {
+      stateCount[s] = runs[k + s];
+      j += stateCount[s];
+    }
+    RowHit hit;
+    if (foundPatternCross(stateCount) && crossCheckCenter(stateCount, i, j, hit)) {
+      hit.atRowEnd = k + 5 == runCount;
+      hits.push_back(hit);
+      if (hit.atRowEnd) {
+        break;
       }
-      return true;
+      start = j + runs[k + 5];
+      k += 6;
+    } else {
+      start += runs[k] + runs[k + 1];
+      k += 2;
     }
   }
-  return false;
+}
+
+void FinderPatternFinder::scanRows(vector<size_t> const& rows, size_t first, size_t step) {
+  Ref<BitArray> row;
+  vector<int> runs;
+  for (size_t r = first; r < rows.size(); r += step) {
+    scanRow(rows[r], row, runs, rowHits_[rows[r]]);
+  }
+}
+
+vector<FinderPatternFinder::RowHit> const& FinderPatternFinder::getRowHits(size_t i, int iSkip) {
+  size_t maxI = image_->getHeight();
+  if (rowScanned_.empty()) {
+    rowHits_.assign(maxI, vector<RowHit>());
+    rowScanned_.assign(maxI, false);
+  }
+  if (rowScanned_[i]) {
+    return rowHits_[i];
+  }
+  size_t threads = threads_;
+  if (threads > 1) {
+    // A row's hits don't depend on what was found before, so scan a band of the rows the caller
+    // will ask for next across the threads the hints allow. The caller replays them in order,
+    // which keeps the result identical to a single-threaded scan.
+    vector<size_t> rows;
+    for (size_t r = i; r < maxI && rows.size() < threads * ROWS_PER_THREAD; r += iSkip) {
+      if (!rowScanned_[r]) {
+        rows.push_back(r);
+      }
+    }
+    threads = min(threads, rows.size());
+    vector<thread> workers;
+    for (size_t t = 1; t < threads; t++) {
+      workers.push_back(thread(&FinderPatternFinder::scanRows, this, std::cref(rows), t, threads));
+    }
+    scanRows(rows, 0, threads);
+    for (size_t t = 0; t < workers.size(); t++) {
+      workers[t].join();
+    }
+    for (size_t r = 0; r < rows.size(); r++) {
+      rowScanned_[rows[r]] = true;
+    }
+  } else {
+    scanRow(i, row_, runs_, rowHits_[i]);
+    rowScanned_[i] = true;
+  }
+  return rowHits_[i];
 }
 
 int FinderPatternFinder::findRowSkip() {
@@ -425,24 +573,17 @@ float FinderPatternFinder::distance(Ref<ResultPoint> p1, Ref<ResultPoint> p2) {
 
 FinderPatternFinder::FinderPatternFinder(Ref<BitMatrix> image,
                                            Ref<ResultPointCallback>const& callback) :
-    image_(image), possibleCenters_(), hasSkipped_(false), callback_(callback) {
+    image_(image), possibleCenters_(), hasSkipped_(false), threads_(1), callback_(callback) {
+  grid_.cellSize = 0.0f;
 }
 
 Ref<FinderPatternInfo> FinderPatternFinder::find(DecodeHints const& hints) {
   bool tryHarder = hints.getTryHarder();
+  threads_ = hints.getThreads();
 
   size_t maxI = image_->getHeight();
-  size_t maxJ = image_->getWidth();
-
-
-  // We are looking for black/white/black/white/black modules in
-  // 1:1:3:1:1 ratio; this tracks the number of such modules seen so far
-
-  // As this is used often, we use an integer array instead of vector
-  int stateCount[5];
   bool done = false;
 
-
   // Let's assume that the maximum version QR Code we support takes up 1/4
   // the height of the image, and then account for the center being 3
   // modules in size. This gives the smallest number of pixels the center
@@ -452,93 +593,47 @@ Ref<FinderPatternInfo> FinderPatternFinder::find(DecodeHints const& hints) {
   if (iSkip < MIN_SKIP || tryHarder) {
       iSkip = MIN_SKIP;
   }
-
-  // This is slightly faster than using the Ref. Efficiency is important here
-  BitMatrix& matrix = *image_;
+  // A known module size replaces the guess: the center is 3 modules tall
+  if (hints.getMinModuleSize() > 0) {
+    iSkip = max(MIN_SKIP, (int) (3 * hints.getMinModuleSize()));
+  }
 
   for (size_t i = iSkip - 1; i < maxI && !done; i += iSkip) {
-    // Get a row of black/white values
-
-    stateCount[0] = 0;
-    stateCount[1] = 0;
-    stateCount[2] = 0;
-    stateCount[3] = 0;
-    stateCount[4] = 0;
-    int currentState = 0;
-    for (size_t j = 0; j < maxJ; j++) {
-      if (matrix.get(j, i)) {
-        // Black pixel
-        if ((currentState & 1) == 1) { // Counting white pixels
-          currentState++;
-        }
-        stateCount[currentState]++;
-      } else { // White pixel
-        if ((currentState & 1) == 0) { // Counting black pixels
-          if (currentState == 4) { // A winner?
-            if (foundPatternCross(stateCount)) { // Yes
-              bool confirmed = handlePossibleCenter(stateCount, i, j);
-              if (confirmed) {
-                // Start examining every other line. Checking each line turned out to be too
-                // expensive and didn't improve performance.
-                iSkip = 2;
-                if (hasSkipped_) {
-                  done = haveMultiplyConfirmedCenters();
-                } else {
-                  int rowSkip = findRowSkip();
-                  if (rowSkip > stateCount[2]) {
-                    // Skip rows between row of lower confirmed center
-                    // and top of presumed third confirmed center
-                    // but back up a bit to get a full chance of detecting
-                    // it, entire width of center of finder pattern
-
-                    // Skip by rowSkip, but back off by stateCount[2] (size
-                    // of last center of pattern we saw) to be conservative,
-                    // and also back off by iSkip which is about to be
-                    // re-added
-                    i += rowSkip - stateCount[2] - iSkip;
-                    j = maxJ - 1;
-                  }
-                }
-              } else {
-                stateCount[0] = stateCount[2];
-                stateCount[1] = stateCount[3];
-                stateCount[2] = stateCount[4];
-                stateCount[3] = 1;
-                stateCount[4] = 0;
-                currentState = 3;
-                continue;
-              }
-              // Clear state to start looking again
-              currentState = 0;
-              stateCount[0] = 0;
-              stateCount[1] = 0;
-              stateCount[2] = 0;
-              stateCount[3] = 0;
-              stateCount[4] = 0;
-            } else { // No, shift counts back by two
-              stateCount[0] = stateCount[2];
-              stateCount[1] = stateCount[3];
-              stateCount[2] = stateCount[4];
-              stateCount[3] = 1;
-              stateCount[4] = 0;
-              currentState = 3;
-            }
-          } else {
-            stateCount[++currentState]++;
-          }
-        } else { // Counting white pixels
-          stateCount[currentState]++;
-        }
+    hints.checkCancelled();
+    vector<RowHit> const& hits = getRowHits(i, iSkip);
+    for (size_t h = 0; h < hits.size(); h++) {
+      if (!hints.acceptsModuleSize(hits[h].estimatedModuleSize)) {
+        continue;
       }
-    }
-    if (foundPatternCross(stateCount)) {
-      bool confirmed = handlePossibleCenter(stateCount, i, maxJ);
-      if (confirmed) {
-        iSkip = stateCount[0];
+      addPossibleCenter(hits[h]);
+      if (hits[h].atRowEnd) {
+        iSkip = hits[h].firstCount;
         if (hasSkipped_) {
           // Found a third one
           done = haveMultiplyConfirmedCenters();
         }
+      } else {
+        // Start examining every other line. Checking each line turned out to be too
+        // expensive and didn't improve performance.
+        iSkip = 2;
+        if (hasSkipped_) {
+          done = haveMultiplyConfirmedCenters();
+        } else {
+          int rowSkip = findRowSkip();
+          if (rowSkip > hits[h].centerCount) {
+            // Skip rows between row of lower confirmed center
+            // and top of presumed third confirmed center
+            // but back up a bit to get a full chance of detecting
+            // it, entire width of center of finder pattern
+
+            // Skip by rowSkip, but back off by the size of the
+            // center of the last pattern we saw to be conservative,
+            // and also back off by iSkip which is about to be
+            // re-added
+            i += rowSkip - hits[h].centerCount - iSkip;
+            break;
+          }
+        }
       }
     }
   }
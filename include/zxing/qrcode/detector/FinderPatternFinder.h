@@ -25,8 +25,10 @@
 #include <zxing/qrcode/detector/FinderPatternInfo.h>
 #include <zxing/common/Counted.h>
 #include <zxing/common/BitMatrix.h>
+#include <zxing/common/BitArray.h>
 #include <zxing/ResultPointCallback.h>
 #include <vector>
+#include <unordered_map>
 
 namespace zxing {
 
@@ -41,10 +43,33 @@ private:
 protected:
   static int MIN_SKIP;
   static int MAX_MODULES;
+  static int ROWS_PER_THREAD;
+
+  /** A window of runs on a row that passed both cross checks */
+  struct RowHit {
+    float centerI;
+    float centerJ;
+    float estimatedModuleSize;
+    int firstCount;
+    int centerCount;
+    bool atRowEnd;
+  };
+
+  /** Buckets possibleCenters_ indices by position so a new hit is only compared with its neighbours */
+  struct CenterGrid {
+    float cellSize;
+    std::unordered_map<long long, std::vector<int> > cells;
+  };
 
   Ref<BitMatrix> image_;
   std::vector<Ref<FinderPattern> > possibleCenters_;
   bool hasSkipped_;
+  std::vector<std::vector<RowHit> > rowHits_;
+  std::vector<bool> rowScanned_;
+  size_t threads_;
+  Ref<BitArray> row_;
+  std::vector<int> runs_;
+  CenterGrid grid_;
 
   Ref<ResultPointCallback> callback_;
 
@@ -56,7 +81,12 @@ protected:
   float crossCheckHorizontal(size_t startJ, size_t centerI, int maxCount, int originalStateCountTotal);
 
   /** stateCount must be int[5] */
-  bool handlePossibleCenter(int* stateCount, size_t i, size_t j);
+  bool crossCheckCenter(int* stateCount, size_t i, size_t j, RowHit& hit);
+  void addPossibleCenter(RowHit const& hit);
+
+  void scanRow(size_t i, Ref<BitArray>& row, std::vector<int>& runs, std::vector<RowHit>& hits);
+  void scanRows(std::vector<size_t> const& rows, size_t first, size_t step);
+  std::vector<RowHit> const& getRowHits(size_t i, int iSkip);
   int findRowSkip();
   bool haveMultiplyConfirmedCenters();
   std::vector<Ref<FinderPattern> > selectBestPatterns();
@@ -62,8 +62,29 @@
 #include "zxing/qrcode/QRCodeReader.h"
 #include "zxing/aztec/AztecReader.h"
 #include "zxing/common/GlobalHistogramBinarizer.h"
+#include "zxing/common/CameraLuminanceSource.h"
+#include "zxing/common/FrameChangeDetector.h"
+#include "zxing/common/FrameQuality.h"
+#include "zxing/multi/LineScanDecoder.h"
+#include "zxing/multi/DecodePool.h"
+#include "zxing/common/GreyscaleLuminanceSource.h"
+#include "zxing/common/Metrics.h"
+#include "zxing/common/Trace.h"
+#include "zxing/TimeoutException.h"
 #include "zxing/Exception.h"
 
+#include "decodeprotocol.h"
+#ifndef PYLON_WIN_BUILD
+#include "decodeserver.h"
+#include "metricsserver.h"
+#endif
+
+#include <csignal>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <thread>
+
 // Include files to use the PYLON API.
 #include <pylon/PylonIncludes.h>
 #ifdef PYLON_WIN_BUILD
@@ -79,105 +100,275 @@ using namespace std;
 // Number of images to be grabbed.
 static const uint32_t c_countOfImagesToGrab = 1000;
 
-class BarcodeReader
+// Longest a single frame may spend decoding before it is reported as not found.
+static const int c_decodeBudgetMs = 200;
+
+// Luminance taken from color frames. GREEN is cheaper and loses little contrast on black-on-white labels.
+static const zxing::CameraLuminanceSource::Channel c_luminanceChannel = zxing::CameraLuminanceSource::LUMA;
+
+// Frames that barely differ from the last decoded one are not decoded again; changed tiles alone are searched.
+// Optional, for stations whose view stays still between items; off, every frame is decoded in full.
+static const bool c_skipUnchangedFrames = false;
+static const int c_changeTileSize = 64;
+// Tiles are compared on every 4th pixel of every 4th row.
+static const int c_changeSubsample = 4;
+// Mean absolute difference, in grey levels, above which a tile counts as changed.
+static const int c_changeThreshold = 6;
+// Above this fraction of changed tiles the whole frame is decoded.
+static const float c_maxChangedFraction = 0.5f;
+
+// Frames below either threshold are blurred or underexposed. They are decoded with the shorter budget, or, if
+// c_rejectPoorFrames is set, rejected without decoding.
+static const int c_minContrast = 24;
+// Steepest edges as a fraction of the contrast: about 1 when sharp, 1/n when smeared over n pixels.
+static const float c_minSharpness = 0.2f;
+static const bool c_rejectPoorFrames = false;
+static const int c_poorFrameBudgetMs = 40;
+
+// Set for line-scan cameras: each grab result is the next strip of one endless image, and symbols are reported
+// as soon as the rows completing them arrive.
+static const bool c_lineScanCamera = false;
+
+// Decode every attached camera rather than only the first. Image files named on the command line are added as
+// stand-in cameras either way; with any source beyond one camera, frames are decoded on a shared pool.
+static const bool c_allCameras = false;
+// Threads of the shared decode pool; 0 for one per core.
+static const int c_decodeThreads = 0;
+// Frames a source may have queued or decoding before its acquisition thread waits for the pool.
+static const int c_maxPendingPerSource = 4;
+// Pin each source's acquisition thread to a CPU of its own, in the order the sources were added, and the decode
+// threads to the CPUs after those. Grab buffers are then allocated on the memory node of the CPU that fills them.
+static const bool c_pinThreads = false;
+
+// "barcodereader --serve [socket]" runs a decode service for other processes instead, on c_decodeThreads threads;
+// see decodeprotocol.h.
+static const char *const c_serveOption = "--serve";
+
+// Loopback port serving per-stage latencies, success rates, drops, queue depths and allocations to Prometheus at
+// /metrics, and trace spans at /trace?ms=N for builds with ZXING_TRACE, e.g. 9464; 0 for none. Not available on
+// Windows.
+static const int c_metricsPort = 0;
+// Seconds between snapshots of the same metrics on the console, e.g. 60; 0 for none.
+static const int c_metricsLogIntervalS = 0;
+// Record trace spans all along, so /trace returns those just past at once rather than recording for a while first.
+static const bool c_traceAlways = false;
+
+// barcodereader_frames_dropped_total for one reason a frame was never decoded
+static zxing::Metrics::Counter DroppedFrames(const char *reason)
 {
-private:
-	class PylonImageSource : public zxing::LuminanceSource
+	return zxing::Metrics::counter("barcodereader_frames_dropped_total", "Frames that were never decoded, by reason",
+		std::string("reason=\"") + reason + "\"");
+}
+
+static bool ToCameraFormat(EPixelType pixelType, zxing::CameraLuminanceSource::PixelFormat &format)
+{
+	switch (pixelType)
 	{
-	private:
-		Pylon::CPylonImage m_Image;
+	case PixelType_Mono8: format = zxing::CameraLuminanceSource::MONO8; return true;
+	case PixelType_BayerRG8: format = zxing::CameraLuminanceSource::BAYER_RG8; return true;
+	case PixelType_BayerBG8: format = zxing::CameraLuminanceSource::BAYER_BG8; return true;
+	case PixelType_BayerGR8: format = zxing::CameraLuminanceSource::BAYER_GR8; return true;
+	case PixelType_BayerGB8: format = zxing::CameraLuminanceSource::BAYER_GB8; return true;
+	case PixelType_RGB8packed: format = zxing::CameraLuminanceSource::RGB8; return true;
+	case PixelType_BGR8packed: format = zxing::CameraLuminanceSource::BGR8; return true;
+	case PixelType_YUV422_YUYV_Packed: format = zxing::CameraLuminanceSource::YUV422_YUYV; return true;
+	case PixelType_YUV422packed: format = zxing::CameraLuminanceSource::YUV422_UYVY; return true;
+	default: return false;
+	}
+}
 
-	public:
-		PylonImageSource(Pylon::CPylonImage &image) : LuminanceSource(image.GetWidth(), image.GetHeight())
-		{
-			m_Image.CopyImage(image);
-		}
+class BarcodeReader
+{
+public:
+	struct BRResult
+	{
+		bool BarcodeFound = false;
+		double XLocation = -1;
+		double YLocation = -1;
+		std::string BarcodeData = "";
+		std::string ErrorMessage = "";
+		// The frame matched the last decoded one closely enough that its result was reused
+		bool FromCache = false;
+		// Measured before decoding; 0 when the frame was not measured
+		int Contrast = 0;
+		double Sharpness = 0;
+	};
 
-		~PylonImageSource()
-		{}
+	struct BRStatistics
+	{
+		uint64_t Frames = 0;
+		// Unchanged frames that were not decoded at all
+		uint64_t Skipped = 0;
+		// Frames where only the changed tiles were decoded
+		uint64_t PartialDecodes = 0;
+		uint64_t FullDecodes = 0;
+		// Frames answered with the symbol found in an earlier frame, skipped ones included
+		uint64_t CacheHits = 0;
+		// Frames too blurred or too dark to decode
+		uint64_t PoorQuality = 0;
+	};
 
-		int getWidth() const { return m_Image.GetWidth(); }
-		int getHeight() const { return m_Image.GetHeight(); }
+private:
+	zxing::MultiFormatReader m_reader;
+	zxing::DecodeHints m_hints;
 
-		zxing::ArrayRef<char> getRow(int y, zxing::ArrayRef<char> row) const //See Zxing Array.h for ArrayRef def
-		{
-			int width_ = getWidth();
-			if (!row)
-				row = zxing::ArrayRef<char>(width_);
-			int yoffset = y * width_;
-			uint8_t* pBuffer = (uint8_t*)m_Image.GetBuffer();
-			for (int x = 0; x < width_; ++x)
-			{
-				row[x] = pBuffer[yoffset + x];
-			}
+	// Only formats the luminance source cannot read are converted, into a buffer kept across frames
+	Pylon::CImageFormatConverter m_converter;
+	Pylon::CPylonImage m_converted;
 
-			return row;
-		}
+	zxing::Ref<zxing::FrameChangeDetector> m_changes;
+	zxing::Ref<zxing::multi::LineScanDecoder> m_lineScan;
+	BRResult m_last;
+	BRStatistics m_statistics;
 
-		zxing::ArrayRef<char> getMatrix() const
+	// A cached result still holds if its location is outside every changed region
+	static bool IsUnchanged(const BRResult &result, const std::vector<zxing::DecodeHints::Region> &changed)
+	{
+		for (size_t i = 0; i < changed.size(); i++)
 		{
-			int width_ = getWidth();
-			int height_ = getHeight();
-			zxing::ArrayRef<char> matrix = zxing::ArrayRef<char>(width_ * height_);
-			uint8_t* pBuffer = (uint8_t*)m_Image.GetBuffer();
-			for (int y = 0; y < height_; ++y)
-			{
-				int yoffset = y * width_;
-				for (int x = 0; x < width_; ++x)
-				{
-					matrix[yoffset + x] = pBuffer[yoffset + x];
-				}
-			}
-			return matrix;
+			const zxing::DecodeHints::Region &region = changed[i];
+			if (result.XLocation >= region.left && result.XLocation < region.left + region.width &&
+				result.YLocation >= region.top && result.YLocation < region.top + region.height)
+				return false;
 		}
+		return true;
+	}
 
-		CPylonImage GetImage()
+	// The source reads the grab result's buffer in place, so the grab result must outlive it
+	zxing::Ref<zxing::LuminanceSource> CreateSource(const CGrabResultPtr &grabResult)
+	{
+		int width = (int)grabResult->GetWidth();
+		int height = (int)grabResult->GetHeight();
+		zxing::CameraLuminanceSource::PixelFormat format;
+		if (ToCameraFormat(grabResult->GetPixelType(), format))
 		{
-			return m_Image;
+			size_t stride = 0;
+			if (!grabResult->GetStride(stride))
+				stride = width * zxing::CameraLuminanceSource::bytesPerPixel(format) + grabResult->GetPaddingX();
+			return zxing::Ref<zxing::LuminanceSource>(new zxing::CameraLuminanceSource(
+				grabResult->GetBuffer(), width, height, (int)stride, format, c_luminanceChannel));
 		}
-		/*
-		// The following methods are not supported by this demo (the DataMatrix Reader doesn't call these methods)
-		bool isCropSupported() const { return false; }
-		Ref<LuminanceSource> crop(int left, int top, int width, int height) {}
-		bool isRotateSupported() const { return false; }
-		Ref<LuminanceSource> rotateCounterClockwise() {}
-		*/
-	};
 
-	zxing::MultiFormatReader m_reader;
+		m_converter.Convert(m_converted, grabResult);
+		return zxing::Ref<zxing::LuminanceSource>(new zxing::CameraLuminanceSource(
+			m_converted.GetBuffer(), width, height, width, zxing::CameraLuminanceSource::MONO8));
+	}
 
 public:
-	BarcodeReader(){}
+	BarcodeReader()
+	{
+		// The reader is kept across frames, so let it learn which formats the line actually prints
+		m_hints = zxing::DecodeHints(zxing::DecodeHints::DEFAULT_HINT);
+		m_hints.setAdaptiveOrder(true);
+		// Most of a conveyor frame is belt; only search the parts that look like barcodes
+		m_hints.setProposeRegions(true);
+		// Frames are decoded one at a time on this thread, so a decode may spread over every core
+		m_hints.setThreads(0);
+		m_reader.setHints(m_hints);
+		m_converter.OutputPixelFormat = Pylon::PixelType_Mono8;
+		if (c_skipUnchangedFrames)
+			m_changes = new zxing::FrameChangeDetector(c_changeTileSize, c_changeSubsample, c_changeThreshold, c_maxChangedFraction);
+	}
 	~BarcodeReader(){}
 
-	struct BRResult
+	const BRStatistics &GetStatistics() const { return m_statistics; }
+
+	// Adds the grab result's rows to the line-scan stream; Y locations count rows since the first strip
+	std::vector<BRResult> ReadLines(const CGrabResultPtr &grabResult)
 	{
-		bool BarcodeFound = false;
-		double XLocation = -1;
-		double YLocation = -1;
-		std::string BarcodeData = "";
-		std::string ErrorMessage = "";
-	};
+		std::vector<BRResult> results;
+
+		zxing::Ref<zxing::LuminanceSource> source = CreateSource(grabResult);
+		if (m_lineScan.empty())
+			m_lineScan = new zxing::multi::LineScanDecoder(source->getWidth(), m_hints);
+		zxing::ArrayRef<char> rows = source->getMatrix();
+		std::vector<zxing::Ref<zxing::Result> > found = m_lineScan->addRows(&rows[0], source->getHeight(), source->getWidth());
+		zxing::Metrics::frame(found.empty() ? zxing::BarcodeFormat::NONE : found[0]->getBarcodeFormat().value, false);
+		for (size_t i = 0; i < found.size(); i++)
+		{
+			BRResult r;
+			r.BarcodeFound = true;
+			r.BarcodeData = found[i]->getText()->getText();
+			zxing::ArrayRef<zxing::Ref<zxing::ResultPoint>> pts = found[i]->getResultPoints();
+			r.XLocation = pts[0]->getX();
+			r.YLocation = pts[0]->getY();
+			results.push_back(r);
+		}
+		return results;
+	}
 
-	BRResult ReadImage(CPylonImage image)
+	BRResult ReadImage(const CGrabResultPtr &grabResult)
 	{
+		ZXING_TRACE_SPAN("BarcodeReader::ReadImage");
 		BRResult r;
 
-		zxing::Ref<PylonImageSource> source(new PylonImageSource(image));
+		zxing::Ref<zxing::LuminanceSource> source = CreateSource(grabResult);
+		m_statistics.Frames++;
+
+		std::vector<zxing::DecodeHints::Region> changed;
+		zxing::FrameChangeDetector::Change change = zxing::FrameChangeDetector::FULL;
+		if (!m_changes.empty())
+			change = m_changes->compare(source, changed);
+		if (change == zxing::FrameChangeDetector::UNCHANGED)
+		{
+			m_statistics.Skipped++;
+			if (m_last.BarcodeFound)
+				m_statistics.CacheHits++;
+			r = m_last;
+			r.FromCache = true;
+			return r;
+		}
+
+		zxing::FrameQuality::Measure quality = zxing::FrameQuality::measure(source);
+		r.Contrast = quality.contrast;
+		r.Sharpness = quality.sharpness;
+		bool poor = quality.contrast < c_minContrast || quality.sharpness < c_minSharpness;
+		if (poor)
+		{
+			m_statistics.PoorQuality++;
+			if (c_rejectPoorFrames)
+			{
+				static const zxing::Metrics::Counter dropped = DroppedFrames("poor_quality");
+				dropped.add();
+				r.ErrorMessage = "Frame too blurred or too dark to decode";
+				return r;
+			}
+		}
+
 		zxing::Ref<zxing::Binarizer> binarizer(new zxing::GlobalHistogramBinarizer(source));
 		zxing::Ref<zxing::BinaryBitmap> bitmap(new zxing::BinaryBitmap(binarizer));
 
+		// Each frame gets a fresh time budget; the readers themselves are kept
+		zxing::DecodeHints hints(m_hints);
+		hints.setCancellationToken(zxing::Ref<zxing::CancellationToken>(new zxing::CancellationToken(poor ? c_poorFrameBudgetMs : c_decodeBudgetMs)));
+		for (size_t i = 0; i < changed.size(); i++)
+			hints.addSearchRegion(changed[i].left, changed[i].top, changed[i].width, changed[i].height);
+		m_reader.setHints(hints);
+		if (change == zxing::FrameChangeDetector::PARTIAL)
+			m_statistics.PartialDecodes++;
+		else
+			m_statistics.FullDecodes++;
+
 		try
 		{
-			zxing::Ref<zxing::Result> result = m_reader.decode(bitmap);
+			zxing::Ref<zxing::Result> result = m_reader.decodeWithState(bitmap);
+			zxing::Metrics::frame(result->getBarcodeFormat(), false);
 			r.BarcodeFound = true;
 			r.BarcodeData = result->getText()->getText();
 			zxing::ArrayRef<zxing::Ref<zxing::ResultPoint>> pts = result->getResultPoints();
 			r.XLocation = pts[0]->getX();
 			r.YLocation = pts[0]->getY();
 		}
+		catch (zxing::TimeoutException& e)
+		{
+			zxing::Metrics::frame(zxing::BarcodeFormat::NONE, true);
+			// Not a verdict on the frame, so it does not become the reference
+			r.ErrorMessage = e.what();
+			return r;
+		}
 		catch (zxing::Exception& e)
 		{
+			zxing::Metrics::frame(zxing::BarcodeFormat::NONE, false);
 			r.BarcodeFound = false;
 			r.BarcodeData = "";
 			r.XLocation = -1;
@@ -185,113 +376,489 @@ public:
 			r.ErrorMessage = e.what();
 		}
 
+		// The barcode found last time is still there if nothing changed around it
+		if (!r.BarcodeFound && change == zxing::FrameChangeDetector::PARTIAL && m_last.BarcodeFound && IsUnchanged(m_last, changed))
+		{
+			m_statistics.CacheHits++;
+			r = m_last;
+			r.FromCache = true;
+			r.Contrast = quality.contrast;
+			r.Sharpness = quality.sharpness;
+		}
+
+		if (!m_changes.empty())
+			m_changes->accept();
+		m_last = r;
+		m_last.FromCache = false;
 		return r;
 	}
 };
 
-int main(int argc, char* argv[])
+// The settings every camera is decoded with: default user set, continuous auto exposure and gain, software trigger
+static void ConfigureCamera(CInstantCamera &camera)
 {
-	// The exit code of the sample application.
-	int exitCode = 0;
+	GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("UserSetSelector"))->FromString("Default");
+	GenApi::CCommandPtr(camera.GetNodeMap().GetNode("UserSetLoad"))->Execute();
+
+	if (GenApi::IsWritable(camera.GetNodeMap().GetNode("ExposureAuto")))
+		GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("ExposureAuto"))->FromString("Continuous");
+	if (GenApi::IsWritable(camera.GetNodeMap().GetNode("GainAuto")))
+		GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("GainAuto"))->FromString("Continuous");
+
+	if (GenApi::IsWritable(camera.GetNodeMap().GetNode("BslBrightness")))
+		GenApi::CFloatPtr(camera.GetNodeMap().GetNode("BslBrightness"))->SetValue(0.4);
+	if (GenApi::IsWritable(camera.GetNodeMap().GetNode("BslContrast")))
+		GenApi::CFloatPtr(camera.GetNodeMap().GetNode("BslContrast"))->SetValue(GenApi::CFloatPtr(camera.GetNodeMap().GetNode("BslContrast"))->GetMax());
+	if (GenApi::IsWritable(camera.GetNodeMap().GetNode("AutoTargetBrightness")))
+		GenApi::CFloatPtr(camera.GetNodeMap().GetNode("AutoTargetBrightness"))->SetValue(0.5);
+
+	GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("TriggerSelector"))->FromString("FrameStart");
+	GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("TriggerSource"))->FromString("Software");
+	GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("TriggerMode"))->FromString("On");
+}
 
-	// Automagically call PylonInitialize and PylonTerminate to ensure the pylon runtime system
-	// is initialized during the lifetime of this object.
-	Pylon::PylonAutoInitTerm autoInitTerm;
+// Hints for decoders shared between sources, which learn the formats in use and search only barcode-like regions
+static zxing::DecodeHints SharedDecoderHints()
+{
+	zxing::DecodeHints hints(zxing::DecodeHints::DEFAULT_HINT);
+	hints.setAdaptiveOrder(true);
+	hints.setProposeRegions(true);
+	return hints;
+}
 
-	try
+// Allocates grab buffers on the thread that starts grabbing and writes every page of them once. Pages are placed on
+// the NUMA node of the CPU that first touches them, so a camera whose acquisition thread is pinned gets its buffers
+// next to that CPU rather than wherever the main thread happened to run.
+class FirstTouchBufferFactory : public IBufferFactory
+{
+public:
+	virtual void AllocateBuffer(size_t bufferSize, void** pCreatedBuffer, intptr_t& bufferContext)
+	{
+		uint8_t *buffer = new uint8_t[bufferSize];
+		memset(buffer, 0, bufferSize);
+		*pCreatedBuffer = buffer;
+		bufferContext = 0;
+	}
+	virtual void FreeBuffer(void* pCreatedBuffer, intptr_t bufferContext)
 	{
-		// Create an instant camera object with the camera device found first.
-		CInstantCamera camera(CTlFactory::GetInstance().CreateFirstDevice());
+		delete[] (uint8_t*)pCreatedBuffer;
+	}
+	virtual void DestroyBufferFactory() {}
+};
 
-		// Print the model name of the camera.
-		cout << "Using device " << camera.GetDeviceInfo().GetModelName() << endl;
+// A frame read in place from its grab buffer. It holds the grab result, so the buffer goes back to the camera only
+// once the decode worker has let go of the frame.
+class GrabbedFrame : public zxing::CameraLuminanceSource
+{
+private:
+	CGrabResultPtr m_grabResult;
 
-		camera.Open();
-		GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("UserSetSelector"))->FromString("Default");
-		GenApi::CCommandPtr(camera.GetNodeMap().GetNode("UserSetLoad"))->Execute();
+public:
+	GrabbedFrame(const CGrabResultPtr &grabResult, int stride, zxing::CameraLuminanceSource::PixelFormat format)
+		: zxing::CameraLuminanceSource(grabResult->GetBuffer(), (int)grabResult->GetWidth(), (int)grabResult->GetHeight(),
+			stride, format, c_luminanceChannel), m_grabResult(grabResult)
+	{
+	}
+};
 
-		if (GenApi::IsWritable(camera.GetNodeMap().GetNode("ExposureAuto")))
-			GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("ExposureAuto"))->FromString("Continuous");
-		if (GenApi::IsWritable(camera.GetNodeMap().GetNode("GainAuto")))
-			GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("GainAuto"))->FromString("Continuous");
+// Something grabbed from its own thread in a multi-source station
+class FrameSource
+{
+public:
+	virtual ~FrameSource(){}
+	virtual std::string GetName() = 0;
+	// Called on the acquisition thread, once it has been pinned
+	virtual void Start(uint32_t frames) = 0;
+	// False once the source has no more frames
+	virtual bool Grab(zxing::Ref<zxing::LuminanceSource> &frame) = 0;
+	virtual uint64_t GetFailedGrabs() { return 0; }
+};
 
-		if (GenApi::IsWritable(camera.GetNodeMap().GetNode("BslBrightness")))
-			GenApi::CFloatPtr(camera.GetNodeMap().GetNode("BslBrightness"))->SetValue(0.4);
-		if (GenApi::IsWritable(camera.GetNodeMap().GetNode("BslContrast")))
-			GenApi::CFloatPtr(camera.GetNodeMap().GetNode("BslContrast"))->SetValue(GenApi::CFloatPtr(camera.GetNodeMap().GetNode("BslContrast"))->GetMax());
-		if (GenApi::IsWritable(camera.GetNodeMap().GetNode("AutoTargetBrightness")))
-			GenApi::CFloatPtr(camera.GetNodeMap().GetNode("AutoTargetBrightness"))->SetValue(0.5);
+class CameraSource : public FrameSource
+{
+private:
+	// Declared before the camera, which frees its buffers through it
+	FirstTouchBufferFactory m_bufferFactory;
+	CInstantCamera m_camera;
+	// Frames in formats the luminance source cannot read are converted into a buffer of their own
+	CImageFormatConverter m_converter;
+	uint64_t m_failedGrabs;
 
-		GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("TriggerSelector"))->FromString("FrameStart");
-		GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("TriggerSource"))->FromString("Software");
-		GenApi::CEnumerationPtr(camera.GetNodeMap().GetNode("TriggerMode"))->FromString("On");
+public:
+	CameraSource(IPylonDevice *device) : m_camera(device), m_failedGrabs(0)
+	{
+		m_camera.Open();
+		ConfigureCamera(m_camera);
+		m_camera.SetBufferFactory(&m_bufferFactory, Cleanup_None);
+		// Enough buffers for the frames in the decode pool plus the one being grabbed
+		m_camera.MaxNumBuffer = c_maxPendingPerSource + 2;
+		m_converter.OutputPixelFormat = PixelType_Mono8;
+	}
 
-		int64_t width = GenApi::CIntegerPtr(camera.GetNodeMap().GetNode("Width"))->GetValue();
-		int64_t height = GenApi::CIntegerPtr(camera.GetNodeMap().GetNode("Height"))->GetValue();
+	std::string GetName()
+	{
+		return std::string(m_camera.GetDeviceInfo().GetModelName().c_str()) + " (" + m_camera.GetDeviceInfo().GetSerialNumber().c_str() + ")";
+	}
 
-		BarcodeReader myBarcodeReader;
+	void Start(uint32_t frames)
+	{
+		// Grab buffers are allocated here, on the acquisition thread
+		m_camera.StartGrabbing(frames);
+	}
 
-		// The parameter MaxNumBuffer can be used to control the count of buffers
-		// allocated for grabbing. The default value of this parameter is 10.
-		camera.MaxNumBuffer = 5;
+	bool Grab(zxing::Ref<zxing::LuminanceSource> &frame)
+	{
+		while (m_camera.IsGrabbing())
+		{
+			m_camera.ExecuteSoftwareTrigger();
+			CGrabResultPtr grabResult;
+			m_camera.RetrieveResult(5000, grabResult, TimeoutHandling_ThrowException);
+			if (!grabResult->GrabSucceeded())
+			{
+				static const zxing::Metrics::Counter dropped = DroppedFrames("failed_grab");
+				dropped.add();
+				m_failedGrabs++;
+				continue;
+			}
 
-		// Start the grabbing of c_countOfImagesToGrab images.
-		// The camera device is parameterized with a default configuration which
-		// sets up free-running continuous acquisition.
-		camera.StartGrabbing(c_countOfImagesToGrab);
+			zxing::CameraLuminanceSource::PixelFormat format;
+			if (ToCameraFormat(grabResult->GetPixelType(), format))
+			{
+				size_t stride = 0;
+				if (!grabResult->GetStride(stride))
+					stride = grabResult->GetWidth() * zxing::CameraLuminanceSource::bytesPerPixel(format) + grabResult->GetPaddingX();
+				frame = new GrabbedFrame(grabResult, (int)stride, format);
+				return true;
+			}
 
-		// This smart pointer will receive the grab result data.
-		CGrabResultPtr ptrGrabResult;
+			int width = (int)grabResult->GetWidth();
+			int height = (int)grabResult->GetHeight();
+			zxing::ArrayRef<char> pixels(width * height);
+			m_converter.Convert(&pixels[0], width * height, grabResult);
+			frame = new zxing::GreyscaleLuminanceSource(pixels, width, height, 0, 0, width, height);
+			return true;
+		}
+		return false;
+	}
 
-		// Camera.StopGrabbing() is called automatically by the RetrieveResult() method
-		// when c_countOfImagesToGrab images have been retrieved.
-		while (camera.IsGrabbing())
-		{
-			camera.ExecuteSoftwareTrigger();
+	uint64_t GetFailedGrabs() { return m_failedGrabs; }
+};
+
+// Replays one image file as a camera would deliver it, as fast as the decode pool takes the frames, so a station
+// can be exercised without its cameras
+class FileSource : public FrameSource
+{
+private:
+	std::string m_path;
+	zxing::Ref<zxing::LuminanceSource> m_frame;
+	uint32_t m_remaining;
+
+public:
+	FileSource(const std::string &path) : m_path(path), m_remaining(0)
+	{
+		CPylonImage image;
+		CImagePersistence::Load(path.c_str(), image);
+		int width = (int)image.GetWidth();
+		int height = (int)image.GetHeight();
+		zxing::ArrayRef<char> pixels(width * height);
+		CImageFormatConverter converter;
+		converter.OutputPixelFormat = PixelType_Mono8;
+		converter.Convert(&pixels[0], width * height, image);
+		m_frame = new zxing::GreyscaleLuminanceSource(pixels, width, height, 0, 0, width, height);
+	}
 
-			// Wait for an image and then retrieve it. A timeout of 5000 ms is used.
-			camera.RetrieveResult(5000, ptrGrabResult, TimeoutHandling_ThrowException);
+	std::string GetName() { return m_path; }
+	void Start(uint32_t frames) { m_remaining = frames; }
+
+	bool Grab(zxing::Ref<zxing::LuminanceSource> &frame)
+	{
+		if (m_remaining == 0)
+			return false;
+		m_remaining--;
+		frame = m_frame;
+		return true;
+	}
+};
+
+// Grabs from every source on a thread of its own and decodes all their frames on one shared pool. Results carry
+// the source's index and come out in frame order per source.
+class Station : public zxing::multi::DecodePool::Listener
+{
+private:
+	std::vector<FrameSource*> m_sources;
+	std::vector<uint64_t> m_found;
+	std::vector<uint64_t> m_notFound;
+	std::mutex m_console;
 
-			// Image grabbed successfully?
-			if (ptrGrabResult->GrabSucceeded())
+	void Acquire(zxing::multi::DecodePool *pool, int source, int cpu, uint32_t frames)
+	{
+		if (cpu >= 0)
+			zxing::multi::DecodePool::pinCurrentThread(std::vector<int>(1, cpu));
+		try
+		{
+			m_sources[source]->Start(frames);
+			zxing::Ref<zxing::LuminanceSource> frame;
+			while (m_sources[source]->Grab(frame))
 			{
-				cout << endl;
-				cout << "Image Received: " << ptrGrabResult->GetBlockID() << endl;
-
-				// use pylon to convert whatever format the incoming image is to Mono8
-				Pylon::CImageFormatConverter fc;
-				fc.OutputPixelFormat = Pylon::PixelType_Mono8;
-				Pylon::CPylonImage pylonImage;
-				if (fc.ImageHasDestinationFormat(ptrGrabResult))
-					pylonImage.AttachGrabResultBuffer(ptrGrabResult);
-				else
-					fc.Convert(pylonImage, ptrGrabResult);
-#ifdef PYLON_WIN_BUILD
-				Pylon::DisplayImage(0, pylonImage);
+				pool->submit(source, frame);
+				frame = zxing::Ref<zxing::LuminanceSource>();
+			}
+		}
+		catch (GenICam::GenericException &e)
+		{
+			std::lock_guard<std::mutex> lock(m_console);
+			cerr << "[" << source << "] " << m_sources[source]->GetName() << " stopped: " << e.GetDescription() << endl;
+		}
+	}
+
+public:
+	~Station()
+	{
+		for (size_t i = 0; i < m_sources.size(); i++)
+			delete m_sources[i];
+	}
+
+	// Takes ownership of the source
+	void Add(FrameSource *source)
+	{
+		m_sources.push_back(source);
+		m_found.push_back(0);
+		m_notFound.push_back(0);
+	}
+
+	size_t GetSourceCount() const { return m_sources.size(); }
+
+	void decoded(const zxing::multi::DecodePool::Outcome &outcome)
+	{
+		std::lock_guard<std::mutex> lock(m_console);
+		cout << "[" << outcome.source << "] Frame " << outcome.frame << ": ";
+		if (!outcome.result.empty())
+		{
+			m_found[outcome.source]++;
+			zxing::ArrayRef<zxing::Ref<zxing::ResultPoint>> pts = outcome.result->getResultPoints();
+			cout << "Barcode Found: X: " << pts[0]->getX() << " Y: " << pts[0]->getY() << " Data: " << outcome.result->getText()->getText() << endl;
+		}
+		else
+		{
+			m_notFound[outcome.source]++;
+			cout << "Barcode Not Found: " << outcome.error << endl;
+		}
+	}
+
+	void Run(uint32_t framesPerSource)
+	{
+		int cpus = (int)std::thread::hardware_concurrency();
+		int sources = (int)m_sources.size();
+		std::vector<int> decodeCpus;
+		if (c_pinThreads)
+		{
+			for (int cpu = sources; cpu < cpus; cpu++)
+				decodeCpus.push_back(cpu);
+		}
+
+		zxing::multi::DecodePool pool(SharedDecoderHints(), *this, c_decodeThreads, decodeCpus, c_decodeBudgetMs, c_maxPendingPerSource);
+
+		std::vector<std::thread> acquisition;
+		for (int i = 0; i < sources; i++)
+		{
+			pool.addSource();
+			cout << "[" << i << "] " << m_sources[i]->GetName() << endl;
+		}
+		cout << "Decoding on " << pool.getThreads() << " threads" << endl;
+		for (int i = 0; i < sources; i++)
+		{
+			int cpu = c_pinThreads && cpus > 0 ? i % cpus : -1;
+			acquisition.push_back(std::thread(&Station::Acquire, this, &pool, i, cpu, framesPerSource));
+		}
+		for (size_t i = 0; i < acquisition.size(); i++)
+			acquisition[i].join();
+		pool.drain();
+
+		cout << endl;
+		for (int i = 0; i < sources; i++)
+			cout << "[" << i << "] Found: " << m_found[i] << " Not found: " << m_notFound[i] << " Failed grabs: " << m_sources[i]->GetFailedGrabs() << endl;
+	}
+};
+
+// Every attached camera when c_allCameras is set, plus one stand-in per image file named on the command line
+static void RunStation(int argc, char* argv[])
+{
+	Station station;
+	if (c_allCameras)
+	{
+		CTlFactory &factory = CTlFactory::GetInstance();
+		DeviceInfoList_t devices;
+		factory.EnumerateDevices(devices);
+		for (size_t i = 0; i < devices.size(); i++)
+			station.Add(new CameraSource(factory.CreateDevice(devices[i])));
+	}
+	for (int i = 1; i < argc; i++)
+		station.Add(new FileSource(argv[i]));
+	if (station.GetSourceCount() == 0)
+	{
+		cerr << "No cameras or image files to decode." << endl;
+		return;
+	}
+	station.Run(c_countOfImagesToGrab);
+}
+
+#ifndef PYLON_WIN_BUILD
+static volatile sig_atomic_t s_stopService = 0;
+
+static void StopService(int)
+{
+	s_stopService = 1;
+}
+
+// Decodes frames for other processes until interrupted or terminated
+static void RunService(const char *path)
+{
+	signal(SIGINT, StopService);
+	signal(SIGTERM, StopService);
+	try
+	{
+		DecodeServer server(path, SharedDecoderHints(), c_decodeThreads, c_decodeBudgetMs);
+		cout << "Serving on " << path << endl;
+		server.Run(&s_stopService);
+
+		DecodeServer::Statistics stats = server.GetStatistics();
+		cout << "Connections: " << stats.Connections << " Frames: " << stats.Frames << " Found: " << stats.Found
+			<< " Rejected: " << stats.Rejected << endl;
+	}
+	catch (std::exception &e)
+	{
+		cerr << "Decode service stopped: " << e.what() << endl;
+	}
+}
+#else
+static void RunService(const char *path)
+{
+	cerr << "The decode service needs UNIX domain sockets." << endl;
+}
 #endif
-				// Todo for Linux:
-				// We can bring back some OpenCV code here to display the image since Pylon::DisplayImage does not support Linux.
-				
-				BarcodeReader myBarcodeReader;
-				BarcodeReader::BRResult myResult;
 
-				myResult = myBarcodeReader.ReadImage(pylonImage);
+// One camera on the calling thread, decoded frame by frame as it is grabbed
+static void RunFirstCamera()
+{
+	// Create an instant camera object with the camera device found first.
+	CInstantCamera camera(CTlFactory::GetInstance().CreateFirstDevice());
+
+	// Print the model name of the camera.
+	cout << "Using device " << camera.GetDeviceInfo().GetModelName() << endl;
+
+	camera.Open();
+	ConfigureCamera(camera);
+
+	int64_t width = GenApi::CIntegerPtr(camera.GetNodeMap().GetNode("Width"))->GetValue();
+	int64_t height = GenApi::CIntegerPtr(camera.GetNodeMap().GetNode("Height"))->GetValue();
+
+	BarcodeReader myBarcodeReader;
+
+	// The parameter MaxNumBuffer can be used to control the count of buffers
+	// allocated for grabbing. The default value of this parameter is 10.
+	camera.MaxNumBuffer = 5;
+
+	// Start the grabbing of c_countOfImagesToGrab images.
+	// The camera device is parameterized with a default configuration which
+	// sets up free-running continuous acquisition.
+	camera.StartGrabbing(c_countOfImagesToGrab);
+
+	// This smart pointer will receive the grab result data.
+	CGrabResultPtr ptrGrabResult;
+
+	// Camera.StopGrabbing() is called automatically by the RetrieveResult() method
+	// when c_countOfImagesToGrab images have been retrieved.
+	while (camera.IsGrabbing())
+	{
+		camera.ExecuteSoftwareTrigger();
+
+		// Wait for an image and then retrieve it. A timeout of 5000 ms is used.
+		camera.RetrieveResult(5000, ptrGrabResult, TimeoutHandling_ThrowException);
+
+		// Image grabbed successfully?
+		if (ptrGrabResult->GrabSucceeded())
+		{
+			cout << endl;
+			cout << "Image Received: " << ptrGrabResult->GetBlockID() << endl;
 
-				if (myResult.BarcodeFound == true)
+#ifdef PYLON_WIN_BUILD
+			Pylon::DisplayImage(0, ptrGrabResult);
+#endif
+			// Todo for Linux:
+			// We can bring back some OpenCV code here to display the image since Pylon::DisplayImage does not support Linux.
+			
+			if (c_lineScanCamera)
+			{
+				std::vector<BarcodeReader::BRResult> found = myBarcodeReader.ReadLines(ptrGrabResult);
+				for (size_t i = 0; i < found.size(); i++)
 				{
 					cout << "Barcode Found: " << endl;
-					cout << " Location : " << "X: " << myResult.XLocation << " Y: " << myResult.YLocation << endl;
-					cout << " Data     : " << myResult.BarcodeData << endl;
+					cout << " Location : " << "X: " << found[i].XLocation << " Y: " << found[i].YLocation << endl;
+					cout << " Data     : " << found[i].BarcodeData << endl;
 				}
-				else
-					cout << "Barcode Not Found: " << myResult.ErrorMessage << endl;
+				continue;
 			}
-			else
+
+			BarcodeReader::BRResult myResult;
+
+			// Mono, Bayer, RGB and YUV frames are decoded straight from the grab buffer
+			myResult = myBarcodeReader.ReadImage(ptrGrabResult);
+
+			if (myResult.FromCache)
+				cout << "Scene unchanged, previous result:" << endl;
+			if (myResult.BarcodeFound == true)
 			{
-				cout << "Error: " << ptrGrabResult->GetErrorCode() << " " << ptrGrabResult->GetErrorDescription() << endl;
+				cout << "Barcode Found: " << endl;
+				cout << " Location : " << "X: " << myResult.XLocation << " Y: " << myResult.YLocation << endl;
+				cout << " Data     : " << myResult.BarcodeData << endl;
 			}
+			else
+				cout << "Barcode Not Found: " << myResult.ErrorMessage << endl;
+			cout << " Quality  : " << "Contrast: " << myResult.Contrast << " Sharpness: " << myResult.Sharpness << endl;
+		}
+		else
+		{
+			static const zxing::Metrics::Counter dropped = DroppedFrames("failed_grab");
+			dropped.add();
+			cout << "Error: " << ptrGrabResult->GetErrorCode() << " " << ptrGrabResult->GetErrorDescription() << endl;
 		}
 	}
+
+	const BarcodeReader::BRStatistics &stats = myBarcodeReader.GetStatistics();
+	cout << endl << "Frames: " << stats.Frames << " Skipped: " << stats.Skipped
+		<< " Partial decodes: " << stats.PartialDecodes << " Full decodes: " << stats.FullDecodes
+		<< " Cache hits: " << stats.CacheHits << " Poor quality: " << stats.PoorQuality << endl;
+}
+
+int main(int argc, char* argv[])
+{
+	// The exit code of the sample application.
+	int exitCode = 0;
+
+	// Automagically call PylonInitialize and PylonTerminate to ensure the pylon runtime system
+	// is initialized during the lifetime of this object.
+	Pylon::PylonAutoInitTerm autoInitTerm;
+
+	bool serve = argc > 1 && strcmp(argv[1], c_serveOption) == 0;
+
+#ifndef PYLON_WIN_BUILD
+	std::unique_ptr<MetricsServer> metrics;
+	if (c_metricsPort > 0 || c_metricsLogIntervalS > 0)
+		metrics.reset(new MetricsServer(c_metricsPort, c_metricsLogIntervalS, cout));
+#endif
+	if (c_traceAlways)
+		zxing::Trace::start();
+
+	try
+	{
+		if (serve)
+			RunService(argc > 2 ? argv[2] : BR_DEFAULT_SOCKET);
+		// Several cameras, or image files standing in for them, share one decode pool
+		else if (c_allCameras || argc > 1)
+			RunStation(argc, argv);
+		else
+			RunFirstCamera();
+	}
 	catch (GenICam::GenericException &e)
 	{
 		// Error handling.
@@ -300,6 +867,10 @@ int main(int argc, char* argv[])
 		exitCode = 1;
 	}
 
+	// A service has no one at the console to press Enter
+	if (serve)
+		return exitCode;
+
 	// Comment the following two lines to disable waiting on exit.
 	cerr << endl << "Press Enter to exit." << endl;
 	while (cin.get() != '\n');
@@ -0,0 +1,273 @@
+/* decodeclient.cpp - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+	*/
+
+#include "decodeclient.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <vector>
+
+namespace
+{
+	enum SlotState
+	{
+		SLOT_FREE,
+		// Handed out by BRAcquireSlot and not submitted yet
+		SLOT_ACQUIRED,
+		SLOT_IN_FLIGHT
+	};
+
+	struct Slot
+	{
+		SlotState State;
+		uint32_t Request;
+	};
+
+	int BytesPerPixel(int pixelFormat)
+	{
+		switch (pixelFormat)
+		{
+		case BR_RGB8:
+		case BR_BGR8:
+			return 3;
+		case BR_YUV422_YUYV:
+		case BR_YUV422_UYVY:
+			return 2;
+		default:
+			return 1;
+		}
+	}
+}
+
+struct BRClient
+{
+	int Fd;
+	unsigned char *Ring;
+	uint64_t RingBytes;
+	uint64_t SlotBytes;
+	std::vector<Slot> Slots;
+	uint32_t NextRequest;
+	uint32_t InFlight;
+};
+
+BRClient *BRConnect(const char *path, uint32_t slots, uint64_t slotBytes)
+{
+	if (path == NULL)
+		path = BR_DEFAULT_SOCKET;
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (slots == 0 || slots > BR_MAX_SLOTS || slotBytes == 0 || strlen(path) >= sizeof(address.sun_path))
+	{
+		errno = EINVAL;
+		return NULL;
+	}
+	strcpy(address.sun_path, path);
+
+	// A memfd rather than a named segment: nothing is left behind if the client dies, and the service can be
+	// promised that the ring will not shrink under its mapping
+	uint64_t ringBytes = slots * slotBytes;
+	int ring = memfd_create("barcodereader-ring", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (ring < 0)
+		return NULL;
+	void *base = MAP_FAILED;
+	if (ftruncate(ring, (off_t)ringBytes) == 0 && fcntl(ring, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) == 0)
+		base = mmap(NULL, (size_t)ringBytes, PROT_READ | PROT_WRITE, MAP_SHARED, ring, 0);
+	int fd = base == MAP_FAILED ? -1 : socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (fd < 0 || connect(fd, (sockaddr*)&address, sizeof(address)) < 0)
+	{
+		int error = errno;
+		if (fd >= 0)
+			close(fd);
+		if (base != MAP_FAILED)
+			munmap(base, (size_t)ringBytes);
+		close(ring);
+		errno = error;
+		return NULL;
+	}
+
+	BRHelloMessage hello;
+	memset(&hello, 0, sizeof(hello));
+	hello.Type = BR_HELLO;
+	hello.Version = BR_PROTOCOL_VERSION;
+	hello.Slots = slots;
+	hello.SlotBytes = slotBytes;
+	iovec data;
+	data.iov_base = &hello;
+	data.iov_len = sizeof(hello);
+	char control[CMSG_SPACE(sizeof(int))];
+	memset(control, 0, sizeof(control));
+	msghdr header;
+	memset(&header, 0, sizeof(header));
+	header.msg_iov = &data;
+	header.msg_iovlen = 1;
+	header.msg_control = control;
+	header.msg_controllen = sizeof(control);
+	cmsghdr *rights = CMSG_FIRSTHDR(&header);
+	rights->cmsg_level = SOL_SOCKET;
+	rights->cmsg_type = SCM_RIGHTS;
+	rights->cmsg_len = CMSG_LEN(sizeof(int));
+	memcpy(CMSG_DATA(rights), &ring, sizeof(int));
+
+	BRHelloMessage reply;
+	bool attached = sendmsg(fd, &header, MSG_NOSIGNAL) == (ssize_t)sizeof(hello) &&
+		recv(fd, &reply, sizeof(reply), 0) == (ssize_t)sizeof(reply) && reply.Type == BR_HELLO && reply.Slots == slots;
+	// The service holds its own mapping now
+	close(ring);
+	if (!attached)
+	{
+		close(fd);
+		munmap(base, (size_t)ringBytes);
+		errno = ECONNREFUSED;
+		return NULL;
+	}
+
+	BRClient *client = new BRClient();
+	client->Fd = fd;
+	client->Ring = (unsigned char*)base;
+	client->RingBytes = ringBytes;
+	client->SlotBytes = slotBytes;
+	Slot unused = { SLOT_FREE, 0 };
+	client->Slots.assign(slots, unused);
+	client->NextRequest = 1;
+	client->InFlight = 0;
+	return client;
+}
+
+void BRDisconnect(BRClient *client)
+{
+	if (client == NULL)
+		return;
+	close(client->Fd);
+	munmap(client->Ring, (size_t)client->RingBytes);
+	delete client;
+}
+
+void *BRAcquireSlot(BRClient *client, uint32_t *slot)
+{
+	for (uint32_t i = 0; i < client->Slots.size(); i++)
+	{
+		if (client->Slots[i].State == SLOT_FREE)
+		{
+			client->Slots[i].State = SLOT_ACQUIRED;
+			*slot = i;
+			return client->Ring + i * client->SlotBytes;
+		}
+	}
+	return NULL;
+}
+
+int BRSubmit(BRClient *client, uint32_t slot, int width, int height, int stride, int pixelFormat, uint32_t *request)
+{
+	if (slot >= client->Slots.size() || client->Slots[slot].State != SLOT_ACQUIRED)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	BRSubmitMessage submit;
+	memset(&submit, 0, sizeof(submit));
+	submit.Type = BR_SUBMIT;
+	submit.Request = client->NextRequest++;
+	submit.Slot = slot;
+	submit.Width = width;
+	submit.Height = height;
+	submit.Stride = stride;
+	submit.PixelFormat = pixelFormat;
+	if (send(client->Fd, &submit, sizeof(submit), MSG_NOSIGNAL) != (ssize_t)sizeof(submit))
+		return -1;
+	client->Slots[slot].State = SLOT_IN_FLIGHT;
+	client->Slots[slot].Request = submit.Request;
+	client->InFlight++;
+	if (request != NULL)
+		*request = submit.Request;
+	return 0;
+}
+
+int BRSubmitFrame(BRClient *client, const void *pixels, int width, int height, int stride, int pixelFormat, uint32_t *request)
+{
+	size_t rowBytes = (size_t)width * BytesPerPixel(pixelFormat);
+	if (width <= 0 || height <= 0 || (size_t)stride < rowBytes || rowBytes * height > client->SlotBytes)
+	{
+		errno = EINVAL;
+		return -1;
+	}
+	uint32_t slot;
+	unsigned char *frame = (unsigned char*)BRAcquireSlot(client, &slot);
+	if (frame == NULL)
+	{
+		errno = EBUSY;
+		return -1;
+	}
+	// Rows are packed in the slot
+	for (int y = 0; y < height; y++)
+		memcpy(frame + y * rowBytes, (const unsigned char*)pixels + (size_t)y * stride, rowBytes);
+	if (BRSubmit(client, slot, width, height, (int)rowBytes, pixelFormat, request) < 0)
+	{
+		client->Slots[slot].State = SLOT_FREE;
+		return -1;
+	}
+	return 0;
+}
+
+int BRReceive(BRClient *client, int timeoutMs, BRDecodeResult *result)
+{
+	pollfd ready;
+	ready.fd = client->Fd;
+	ready.events = POLLIN;
+	int polled = poll(&ready, 1, timeoutMs);
+	if (polled == 0)
+		return 0;
+	if (polled < 0)
+		return errno == EINTR ? 0 : -1;
+
+	BRResultMessage reply;
+	ssize_t size = recv(client->Fd, &reply, sizeof(reply), 0);
+	if (size < (ssize_t)BR_RESULT_HEADER_BYTES || reply.Type != BR_RESULT ||
+		reply.TextLength > BR_MAX_TEXT || (size_t)size < BR_RESULT_HEADER_BYTES + reply.TextLength)
+		return -1;
+
+	result->Request = reply.Request;
+	result->Status = reply.Status;
+	result->BarcodeFormat = reply.BarcodeFormat;
+	result->X = reply.X;
+	result->Y = reply.Y;
+	result->Truncated = reply.Truncated != 0;
+	memcpy(result->Text, reply.Text, reply.TextLength);
+	result->Text[reply.TextLength] = '\0';
+
+	for (uint32_t i = 0; i < client->Slots.size(); i++)
+	{
+		if (client->Slots[i].State == SLOT_IN_FLIGHT && client->Slots[i].Request == reply.Request)
+		{
+			client->Slots[i].State = SLOT_FREE;
+			client->InFlight--;
+			break;
+		}
+	}
+	return 1;
+}
+
+uint32_t BRGetInFlight(const BRClient *client)
+{
+	return client->InFlight;
+}
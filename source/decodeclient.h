@@ -0,0 +1,73 @@
+/* decodeclient.h - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	Client of the decode service (barcodereader --serve). It needs neither zxing nor pylon, and its plain C
+	interface can be loaded from other languages, for example with Python's ctypes.
+
+	A client is not thread safe; give each thread its own.
+	*/
+
+#ifndef DECODE_CLIENT_H
+#define DECODE_CLIENT_H
+
+#include "decodeprotocol.h"
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct BRClient BRClient;
+
+typedef struct BRDecodeResult
+{
+	uint32_t Request;
+	// One of BRStatus
+	int Status;
+	// zxing::BarcodeFormat, -1 when nothing was found
+	int BarcodeFormat;
+	float X;
+	float Y;
+	int Truncated;
+	// The symbol's text when found, otherwise why not
+	char Text[BR_MAX_TEXT + 1];
+} BRDecodeResult;
+
+// Connects to the service at path, BR_DEFAULT_SOCKET when NULL, with a ring of slots frames of up to slotBytes
+// each. NULL on failure, with errno set.
+BRClient *BRConnect(const char *path, uint32_t slots, uint64_t slotBytes);
+void BRDisconnect(BRClient *client);
+
+// A free slot to write a frame into and its index, or NULL when every slot is in flight
+void *BRAcquireSlot(BRClient *client, uint32_t *slot);
+// Submits the frame written into an acquired slot; 0 on success, -1 on failure. *request identifies its result.
+int BRSubmit(BRClient *client, uint32_t slot, int width, int height, int stride, int pixelFormat, uint32_t *request);
+// Copies the frame into a free slot and submits it; -1 as well when no slot is free
+int BRSubmitFrame(BRClient *client, const void *pixels, int width, int height, int stride, int pixelFormat, uint32_t *request);
+
+// Waits up to timeoutMs, forever when negative, for the next result and frees its slot. 1 when a result was
+// received, 0 on timeout, -1 when the connection failed.
+int BRReceive(BRClient *client, int timeoutMs, BRDecodeResult *result);
+
+// Frames submitted and not yet answered
+uint32_t BRGetInFlight(const BRClient *client);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DECODE_CLIENT_H
@@ -0,0 +1,196 @@
+/* decodeload.cpp - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	Load generator for the decode service. Each client thread connects on its own, keeps all its slots in flight
+	with the same frame and reports throughput and latency once every client is done:
+
+	decodeload [-s socket] [-c clients] [-n frames per client] [-k slots per client] [frame.pgm]
+
+	Without a frame, a 1280x960 frame of noise is sent, which measures the cost of finding nothing.
+	*/
+
+#include "decodeclient.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+typedef chrono::steady_clock Clock;
+
+struct Frame
+{
+	int Width = 0;
+	int Height = 0;
+	vector<unsigned char> Pixels;
+};
+
+struct Totals
+{
+	mutex Lock;
+	vector<double> LatenciesMs;
+	uint64_t Found = 0;
+	uint64_t NotFound = 0;
+	uint64_t TimedOut = 0;
+	uint64_t Rejected = 0;
+	uint64_t Failed = 0;
+};
+
+// Binary PGM, 8 bits per pixel
+static bool LoadPgm(const char *path, Frame &frame)
+{
+	ifstream in(path, ios::binary);
+	string magic;
+	int maxValue = 0;
+	in >> magic >> frame.Width >> frame.Height >> maxValue;
+	if (!in || magic != "P5" || maxValue > 255 || frame.Width <= 0 || frame.Height <= 0)
+		return false;
+	in.get();
+	frame.Pixels.resize((size_t)frame.Width * frame.Height);
+	in.read((char*)&frame.Pixels[0], frame.Pixels.size());
+	return (bool)in;
+}
+
+static void RunClient(const char *path, const Frame &frame, int frames, uint32_t slots, Totals &totals)
+{
+	BRClient *client = BRConnect(path, slots, frame.Pixels.size());
+	if (client == NULL)
+	{
+		perror("BRConnect");
+		lock_guard<mutex> lock(totals.Lock);
+		totals.Failed += frames;
+		return;
+	}
+
+	vector<Clock::time_point> sent(frames + 1);
+	vector<double> latencies;
+	uint64_t found = 0, notFound = 0, timedOut = 0, rejected = 0;
+	int submitted = 0, answered = 0;
+	while (answered < submitted || submitted < frames)
+	{
+		while (submitted < frames && BRGetInFlight(client) < slots)
+		{
+			uint32_t request;
+			if (BRSubmitFrame(client, &frame.Pixels[0], frame.Width, frame.Height, frame.Width, BR_MONO8, &request) < 0)
+				break;
+			// Requests count from 1
+			sent[request] = Clock::now();
+			submitted++;
+		}
+		BRDecodeResult result;
+		int received = BRReceive(client, 5000, &result);
+		if (received <= 0)
+		{
+			fprintf(stderr, "Connection lost after %d of %d frames\n", answered, frames);
+			break;
+		}
+		latencies.push_back(chrono::duration<double, milli>(Clock::now() - sent[result.Request]).count());
+		answered++;
+		switch (result.Status)
+		{
+		case BR_FOUND: found++; break;
+		case BR_NOT_FOUND: notFound++; break;
+		case BR_TIMED_OUT: timedOut++; break;
+		default: rejected++; break;
+		}
+	}
+	BRDisconnect(client);
+
+	lock_guard<mutex> lock(totals.Lock);
+	totals.LatenciesMs.insert(totals.LatenciesMs.end(), latencies.begin(), latencies.end());
+	totals.Found += found;
+	totals.NotFound += notFound;
+	totals.TimedOut += timedOut;
+	totals.Rejected += rejected;
+	totals.Failed += frames - answered;
+}
+
+static double Percentile(const vector<double> &sorted, double p)
+{
+	if (sorted.empty())
+		return 0;
+	return sorted[min(sorted.size() - 1, (size_t)(p * sorted.size()))];
+}
+
+int main(int argc, char* argv[])
+{
+	const char *path = BR_DEFAULT_SOCKET;
+	int clients = 4;
+	int frames = 200;
+	uint32_t slots = 4;
+	int option;
+	while ((option = getopt(argc, argv, "s:c:n:k:")) != -1)
+	{
+		switch (option)
+		{
+		case 's': path = optarg; break;
+		case 'c': clients = atoi(optarg); break;
+		case 'n': frames = atoi(optarg); break;
+		case 'k': slots = (uint32_t)atoi(optarg); break;
+		default:
+			fprintf(stderr, "Usage: %s [-s socket] [-c clients] [-n frames per client] [-k slots per client] [frame.pgm]\n", argv[0]);
+			return 2;
+		}
+	}
+
+	Frame frame;
+	if (optind < argc)
+	{
+		if (!LoadPgm(argv[optind], frame))
+		{
+			fprintf(stderr, "Cannot read %s as a binary PGM\n", argv[optind]);
+			return 1;
+		}
+	}
+	else
+	{
+		frame.Width = 1280;
+		frame.Height = 960;
+		frame.Pixels.resize((size_t)frame.Width * frame.Height);
+		srand(1);
+		for (size_t i = 0; i < frame.Pixels.size(); i++)
+			frame.Pixels[i] = (unsigned char)(96 + rand() % 64);
+	}
+
+	Totals totals;
+	Clock::time_point start = Clock::now();
+	vector<thread> threads;
+	for (int i = 0; i < clients; i++)
+		threads.push_back(thread(RunClient, path, cref(frame), frames, slots, ref(totals)));
+	for (size_t i = 0; i < threads.size(); i++)
+		threads[i].join();
+	double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+	sort(totals.LatenciesMs.begin(), totals.LatenciesMs.end());
+	size_t answered = totals.LatenciesMs.size();
+	printf("Clients: %d Slots: %u Frame: %dx%d\n", clients, slots, frame.Width, frame.Height);
+	printf("Frames: %zu in %.2f s, %.1f frames/s\n", answered, seconds, answered / seconds);
+	printf("Latency ms: p50 %.1f p95 %.1f p99 %.1f max %.1f\n", Percentile(totals.LatenciesMs, 0.5),
+		Percentile(totals.LatenciesMs, 0.95), Percentile(totals.LatenciesMs, 0.99),
+		answered > 0 ? totals.LatenciesMs.back() : 0.0);
+	printf("Found: %llu Not found: %llu Timed out: %llu Rejected: %llu Failed: %llu\n",
+		(unsigned long long)totals.Found, (unsigned long long)totals.NotFound, (unsigned long long)totals.TimedOut,
+		(unsigned long long)totals.Rejected, (unsigned long long)totals.Failed);
+	return totals.Failed > 0 ? 1 : 0;
+}
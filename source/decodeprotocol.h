@@ -0,0 +1,128 @@
+/* decodeprotocol.h - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+
+	Messages between the decode service and its clients.
+
+	A client puts its frames in a shared memory ring of equal slots and passes the ring's file descriptor to the
+	service once, with its BRHelloMessage. The ring must be a memfd sealed with F_SEAL_SHRINK: the service maps it,
+	and a ring that could shrink under it would crash the service rather than the client. After that only
+	descriptors and results travel over the socket, one message per SOCK_SEQPACKET packet:
+
+	client                                          service
+	BRHelloMessage + ring fd (SCM_RIGHTS)   ->
+	                                        <-      BRHelloMessage (Slots is 0 if refused)
+	BRSubmitMessage                         ->
+	BRSubmitMessage                         ->
+	                                        <-      BRResultMessage
+	                                        <-      BRResultMessage
+
+	Results for one client come back in the order its frames were submitted; only rejected descriptors are
+	answered straight away. A slot may be written again once the result for the frame in it has arrived. A client
+	that leaves its results unread until the socket is full is disconnected. Everything is in host byte order; the
+	service is local only.
+	*/
+
+#ifndef DECODE_PROTOCOL_H
+#define DECODE_PROTOCOL_H
+
+#include <stdint.h>
+
+#define BR_PROTOCOL_VERSION 1
+
+// Where the service listens unless told otherwise
+#define BR_DEFAULT_SOCKET "/tmp/barcodereader.sock"
+
+// Most slots a client may have in flight
+#define BR_MAX_SLOTS 64
+
+// Longest text a result carries; longer symbols are cut short and flagged
+#define BR_MAX_TEXT 4096
+
+enum BRMessageType
+{
+	BR_HELLO = 1,
+	BR_SUBMIT = 2,
+	BR_RESULT = 3
+};
+
+// Same values as zxing::CameraLuminanceSource::PixelFormat
+enum BRPixelFormat
+{
+	BR_MONO8 = 0,
+	BR_BAYER_RG8 = 1,
+	BR_BAYER_BG8 = 2,
+	BR_BAYER_GR8 = 3,
+	BR_BAYER_GB8 = 4,
+	BR_RGB8 = 5,
+	BR_BGR8 = 6,
+	BR_YUV422_YUYV = 7,
+	BR_YUV422_UYVY = 8
+};
+
+typedef struct BRHelloMessage
+{
+	uint32_t Type;
+	uint32_t Version;
+	uint32_t Slots;
+	uint32_t Reserved;
+	// Slot i starts i * SlotBytes into the ring
+	uint64_t SlotBytes;
+} BRHelloMessage;
+
+typedef struct BRSubmitMessage
+{
+	uint32_t Type;
+	// Chosen by the client and echoed in the result
+	uint32_t Request;
+	uint32_t Slot;
+	int32_t Width;
+	int32_t Height;
+	// Bytes from one row to the next
+	int32_t Stride;
+	int32_t PixelFormat;
+	int32_t Reserved;
+} BRSubmitMessage;
+
+enum BRStatus
+{
+	BR_FOUND = 0,
+	BR_NOT_FOUND = 1,
+	// The frame ran out of decode budget
+	BR_TIMED_OUT = 2,
+	// The descriptor did not fit the client's ring; the frame was not decoded
+	BR_REJECTED = 3
+};
+
+typedef struct BRResultMessage
+{
+	uint32_t Type;
+	uint32_t Request;
+	int32_t Status;
+	// zxing::BarcodeFormat of the symbol when found
+	int32_t BarcodeFormat;
+	float X;
+	float Y;
+	// Bytes of Text actually sent; the packet ends there
+	uint32_t TextLength;
+	// Set when the symbol's text was longer than BR_MAX_TEXT
+	uint32_t Truncated;
+	// The symbol's text when found, otherwise why not. Not terminated.
+	char Text[BR_MAX_TEXT];
+} BRResultMessage;
+
+#define BR_RESULT_HEADER_BYTES (sizeof(BRResultMessage) - BR_MAX_TEXT)
+
+#endif // DECODE_PROTOCOL_H
@@ -0,0 +1,421 @@
+/* decodeserver.cpp - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+	*/
+
+#include "decodeserver.h"
+#include "decodeprotocol.h"
+
+#include "zxing/common/CameraLuminanceSource.h"
+#include "zxing/ResultPoint.h"
+#include "zxing/Exception.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <algorithm>
+#include <deque>
+#include <stdexcept>
+
+namespace
+{
+	// A client's frames, mapped read-only for as long as the client or any of its frames is around
+	class SharedRing : public zxing::Counted
+	{
+	private:
+		void *m_base;
+		size_t m_size;
+
+	public:
+		SharedRing(void *base, size_t size) : m_base(base), m_size(size) {}
+		~SharedRing() { munmap(m_base, m_size); }
+
+		const unsigned char *GetSlot(uint32_t slot, uint64_t slotBytes) const
+		{
+			return (const unsigned char*)m_base + slot * slotBytes;
+		}
+	};
+
+	// A frame read in place from a client's ring, which it keeps mapped until the decode worker lets go of it
+	class SharedFrame : public zxing::CameraLuminanceSource
+	{
+	private:
+		zxing::Ref<SharedRing> m_ring;
+
+	public:
+		SharedFrame(zxing::Ref<SharedRing> ring, const void *data, int width, int height, int stride, zxing::CameraLuminanceSource::PixelFormat format)
+			: zxing::CameraLuminanceSource(data, width, height, stride, format), m_ring(ring)
+		{
+		}
+	};
+}
+
+class DecodeServer::Client : public zxing::Counted
+{
+public:
+	int Fd;
+	// -1 until the client's ring is attached
+	int Source;
+	zxing::Ref<SharedRing> Ring;
+	uint32_t Slots;
+	uint64_t SlotBytes;
+
+	// Guards everything below, and sending on Fd
+	std::mutex Lock;
+	bool Open;
+	// Requests handed to the pool, oldest first; their results come back in the same order
+	std::deque<uint32_t> Requests;
+
+	Client(int fd) : Fd(fd), Source(-1), Slots(0), SlotBytes(0), Open(true) {}
+};
+
+DecodeServer::DecodeServer(const std::string &path, const zxing::DecodeHints &hints, int threads, int budgetMs)
+	: m_path(path), m_listener(-1),
+	m_rejectedFrames(zxing::Metrics::counter("barcodereader_frames_dropped_total", "Frames that were never decoded, by reason",
+		"reason=\"rejected\"")),
+	m_connectedClients(zxing::Metrics::gauge("barcodereader_service_clients", "Clients connected to the decode service"))
+{
+	sockaddr_un address;
+	memset(&address, 0, sizeof(address));
+	address.sun_family = AF_UNIX;
+	if (path.size() >= sizeof(address.sun_path))
+		throw std::runtime_error("Socket path too long: " + path);
+	strcpy(address.sun_path, path.c_str());
+
+	m_listener = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+	if (m_listener < 0)
+		throw std::runtime_error(std::string("socket: ") + strerror(errno));
+	// A socket left behind by a service that did not shut down cleanly
+	unlink(path.c_str());
+	if (bind(m_listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(m_listener, 16) < 0)
+	{
+		std::string why = strerror(errno);
+		close(m_listener);
+		throw std::runtime_error("Cannot listen on " + path + ": " + why);
+	}
+
+	// Every client's frames in flight fit in its ring, so submitting never waits
+	m_pool = new zxing::multi::DecodePool(hints, *this, threads, std::vector<int>(), budgetMs, BR_MAX_SLOTS);
+}
+
+DecodeServer::~DecodeServer()
+{
+	// Frames still in the pool are answered first, while the clients are still known
+	m_pool = zxing::Ref<zxing::multi::DecodePool>();
+	close(m_listener);
+	unlink(m_path.c_str());
+}
+
+DecodeServer::Statistics DecodeServer::GetStatistics()
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	return m_statistics;
+}
+
+void DecodeServer::Run(volatile sig_atomic_t *stop)
+{
+	std::vector<zxing::Ref<Client> > connected;
+	while (!*stop)
+	{
+		std::vector<pollfd> fds(connected.size() + 1);
+		fds[0].fd = m_listener;
+		fds[0].events = POLLIN;
+		for (size_t i = 0; i < connected.size(); i++)
+		{
+			fds[i + 1].fd = connected[i]->Fd;
+			fds[i + 1].events = POLLIN;
+		}
+		// Woken regularly to notice *stop
+		if (poll(&fds[0], fds.size(), 200) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			throw std::runtime_error(std::string("poll: ") + strerror(errno));
+		}
+
+		// Descriptors from every client that has sent any are queued in one pass, so the workers take them as a batch
+		std::vector<zxing::Ref<Client> > remaining;
+		for (size_t i = 0; i < connected.size(); i++)
+		{
+			if (fds[i + 1].revents != 0 && !Receive(connected[i]))
+				Close(connected[i]);
+			else
+				remaining.push_back(connected[i]);
+		}
+		connected.swap(remaining);
+
+		if (fds[0].revents & POLLIN)
+		{
+			int fd = accept4(m_listener, NULL, NULL, SOCK_CLOEXEC);
+			if (fd >= 0)
+			{
+				connected.push_back(zxing::Ref<Client>(new Client(fd)));
+				m_connectedClients.add(1);
+				std::lock_guard<std::mutex> lock(m_lock);
+				m_statistics.Connections++;
+			}
+		}
+	}
+
+	for (size_t i = 0; i < connected.size(); i++)
+		Close(connected[i]);
+}
+
+// False once the client has hung up or broken the protocol
+bool DecodeServer::Receive(zxing::Ref<Client> client)
+{
+	union
+	{
+		BRHelloMessage hello;
+		BRSubmitMessage submit;
+	} message;
+	char control[CMSG_SPACE(sizeof(int))];
+	iovec data;
+	data.iov_base = &message;
+	data.iov_len = sizeof(message);
+	msghdr header;
+	memset(&header, 0, sizeof(header));
+	header.msg_iov = &data;
+	header.msg_iovlen = 1;
+	header.msg_control = control;
+	header.msg_controllen = sizeof(control);
+
+	ssize_t size = recvmsg(client->Fd, &header, MSG_CMSG_CLOEXEC | MSG_DONTWAIT);
+	if (size < 0 && (errno == EAGAIN || errno == EINTR))
+		return true;
+	if (size < (ssize_t)sizeof(uint32_t))
+		return false;
+
+	int fd = -1;
+	for (cmsghdr *c = CMSG_FIRSTHDR(&header); c != NULL; c = CMSG_NXTHDR(&header, c))
+	{
+		if (c->cmsg_level == SOL_SOCKET && c->cmsg_type == SCM_RIGHTS)
+			memcpy(&fd, CMSG_DATA(c), sizeof(int));
+	}
+
+	uint32_t type = message.hello.Type;
+	if (type == BR_HELLO && client->Ring.empty())
+	{
+		Hello(client, &message, (size_t)size, fd);
+		return !client->Ring.empty();
+	}
+	if (fd >= 0)
+		close(fd);
+	if (type == BR_SUBMIT && !client->Ring.empty())
+	{
+		Submit(client, &message, (size_t)size);
+		return true;
+	}
+	return false;
+}
+
+void DecodeServer::Hello(zxing::Ref<Client> client, const void *message, size_t size, int fd)
+{
+	BRHelloMessage hello;
+	memcpy(&hello, message, sizeof(hello));
+	uint64_t ringBytes = (uint64_t)hello.Slots * hello.SlotBytes;
+	struct stat ring;
+	bool accepted = size == sizeof(hello) && hello.Version == BR_PROTOCOL_VERSION &&
+		hello.Slots > 0 && hello.Slots <= BR_MAX_SLOTS && hello.SlotBytes > 0 &&
+		fd >= 0 && fstat(fd, &ring) == 0 && (uint64_t)ring.st_size >= ringBytes &&
+		(fcntl(fd, F_GET_SEALS) & F_SEAL_SHRINK) != 0;
+	if (accepted)
+	{
+		void *base = mmap(NULL, (size_t)ringBytes, PROT_READ, MAP_SHARED, fd, 0);
+		if (base != MAP_FAILED)
+		{
+			client->Ring = new SharedRing(base, (size_t)ringBytes);
+			client->Slots = hello.Slots;
+			client->SlotBytes = hello.SlotBytes;
+		}
+	}
+	if (fd >= 0)
+		close(fd);
+
+	BRHelloMessage reply = hello;
+	reply.Slots = client->Ring.empty() ? 0 : client->Slots;
+	send(client->Fd, &reply, sizeof(reply), MSG_NOSIGNAL);
+	if (client->Ring.empty())
+		return;
+
+	std::lock_guard<std::mutex> lock(m_lock);
+	if (m_freeSources.empty())
+	{
+		client->Source = m_pool->addSource();
+		m_clients.resize(client->Source + 1);
+	}
+	else
+	{
+		client->Source = m_freeSources.back();
+		m_freeSources.pop_back();
+	}
+	m_clients[client->Source] = client;
+}
+
+void DecodeServer::Submit(zxing::Ref<Client> client, const void *message, size_t size)
+{
+	BRSubmitMessage submit;
+	memcpy(&submit, message, sizeof(submit));
+	if (size != sizeof(submit) || submit.PixelFormat < BR_MONO8 || submit.PixelFormat > BR_YUV422_UYVY ||
+		submit.Width <= 0 || submit.Height <= 0 || submit.Slot >= client->Slots)
+	{
+		Reject(client, submit.Request, "Bad frame descriptor");
+		return;
+	}
+	zxing::CameraLuminanceSource::PixelFormat format = (zxing::CameraLuminanceSource::PixelFormat)submit.PixelFormat;
+	uint64_t rowBytes = (uint64_t)submit.Width * zxing::CameraLuminanceSource::bytesPerPixel(format);
+	if (submit.Stride < 0 || (uint64_t)submit.Stride < rowBytes ||
+		(uint64_t)(submit.Height - 1) * submit.Stride + rowBytes > client->SlotBytes)
+	{
+		Reject(client, submit.Request, "Frame does not fit its slot");
+		return;
+	}
+
+	zxing::Ref<zxing::LuminanceSource> frame;
+	try
+	{
+		frame = new SharedFrame(client->Ring, client->Ring->GetSlot(submit.Slot, client->SlotBytes),
+			submit.Width, submit.Height, submit.Stride, format);
+	}
+	catch (zxing::Exception &e)
+	{
+		Reject(client, submit.Request, e.what());
+		return;
+	}
+
+	bool full;
+	{
+		std::lock_guard<std::mutex> lock(client->Lock);
+		full = client->Requests.size() >= client->Slots;
+		if (!full)
+			client->Requests.push_back(submit.Request);
+	}
+	if (full)
+	{
+		Reject(client, submit.Request, "More frames in flight than slots");
+		return;
+	}
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_statistics.Frames++;
+	}
+	m_pool->submit(client->Source, frame);
+}
+
+// Rejections are answered straight away, ahead of results for frames still being decoded
+void DecodeServer::Reject(zxing::Ref<Client> client, uint32_t request, const char *why)
+{
+	BRResultMessage reply;
+	memset(&reply, 0, BR_RESULT_HEADER_BYTES);
+	reply.Type = BR_RESULT;
+	reply.Request = request;
+	reply.Status = BR_REJECTED;
+	reply.BarcodeFormat = -1;
+	reply.TextLength = (uint32_t)std::min(strlen(why), (size_t)BR_MAX_TEXT);
+	memcpy(reply.Text, why, reply.TextLength);
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		m_statistics.Rejected++;
+	}
+	m_rejectedFrames.add();
+	std::lock_guard<std::mutex> lock(client->Lock);
+	Reply(client, &reply, BR_RESULT_HEADER_BYTES + reply.TextLength);
+}
+
+// Called with client->Lock held, often from a pool worker, so it must never wait on the client. A client that
+// has stopped reading its results is shut down; Run() then sees the hangup and closes it.
+void DecodeServer::Reply(zxing::Ref<Client> client, const void *message, size_t size)
+{
+	if (!client->Open)
+		return;
+	ssize_t sent;
+	do
+		sent = send(client->Fd, message, size, MSG_NOSIGNAL | MSG_DONTWAIT);
+	while (sent < 0 && errno == EINTR);
+	if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+		shutdown(client->Fd, SHUT_RDWR);
+}
+
+void DecodeServer::decoded(const zxing::multi::DecodePool::Outcome &outcome)
+{
+	zxing::Ref<Client> client;
+	{
+		std::lock_guard<std::mutex> lock(m_lock);
+		client = m_clients[outcome.source];
+		if (!outcome.result.empty())
+			m_statistics.Found++;
+	}
+
+	BRResultMessage reply;
+	memset(&reply, 0, BR_RESULT_HEADER_BYTES);
+	reply.Type = BR_RESULT;
+	reply.BarcodeFormat = -1;
+	std::string text = outcome.error;
+	if (!outcome.result.empty())
+	{
+		reply.Status = BR_FOUND;
+		reply.BarcodeFormat = outcome.result->getBarcodeFormat();
+		zxing::ArrayRef<zxing::Ref<zxing::ResultPoint> > pts = outcome.result->getResultPoints();
+		if (pts && !pts->empty())
+		{
+			reply.X = pts[0]->getX();
+			reply.Y = pts[0]->getY();
+		}
+		text = outcome.result->getText()->getText();
+	}
+	else
+		reply.Status = outcome.timedOut ? BR_TIMED_OUT : BR_NOT_FOUND;
+	reply.Truncated = text.size() > BR_MAX_TEXT;
+	reply.TextLength = (uint32_t)std::min(text.size(), (size_t)BR_MAX_TEXT);
+	memcpy(reply.Text, text.data(), reply.TextLength);
+
+	bool release;
+	{
+		std::lock_guard<std::mutex> lock(client->Lock);
+		reply.Request = client->Requests.front();
+		client->Requests.pop_front();
+		Reply(client, &reply, BR_RESULT_HEADER_BYTES + reply.TextLength);
+		release = !client->Open && client->Requests.empty();
+	}
+	if (release)
+		Release(client->Source);
+}
+
+void DecodeServer::Close(zxing::Ref<Client> client)
+{
+	bool release;
+	{
+		std::lock_guard<std::mutex> lock(client->Lock);
+		client->Open = false;
+		close(client->Fd);
+		m_connectedClients.add(-1);
+		release = client->Source >= 0 && client->Requests.empty();
+	}
+	if (release)
+		Release(client->Source);
+}
+
+void DecodeServer::Release(int source)
+{
+	std::lock_guard<std::mutex> lock(m_lock);
+	m_clients[source] = zxing::Ref<Client>();
+	m_freeSources.push_back(source);
+}
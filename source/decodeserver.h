@@ -0,0 +1,79 @@
+/* decodeserver.h - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+	*/
+
+#ifndef DECODE_SERVER_H
+#define DECODE_SERVER_H
+
+#include "zxing/multi/DecodePool.h"
+#include "zxing/common/Metrics.h"
+
+#include <signal.h>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// The decode service: clients connect over a UNIX socket and pass frames through shared memory, see
+// decodeprotocol.h. Frames from every client are queued on one DecodePool, whose workers keep their readers warm
+// from one request to the next; each client is one of the pool's sources, so its results come back in order.
+class DecodeServer : public zxing::multi::DecodePool::Listener
+{
+public:
+	struct Statistics
+	{
+		uint64_t Connections = 0;
+		uint64_t Frames = 0;
+		uint64_t Found = 0;
+		uint64_t Rejected = 0;
+	};
+
+	// threads and budgetMs as for DecodePool
+	DecodeServer(const std::string &path, const zxing::DecodeHints &hints, int threads, int budgetMs);
+	~DecodeServer();
+
+	// Serves until *stop becomes nonzero, which a signal handler may set
+	void Run(volatile sig_atomic_t *stop);
+
+	Statistics GetStatistics();
+
+	void decoded(const zxing::multi::DecodePool::Outcome &outcome);
+
+private:
+	class Client;
+
+	std::string m_path;
+	int m_listener;
+	zxing::Ref<zxing::multi::DecodePool> m_pool;
+
+	// Clients by pool source; the source of a client that has gone is reused once its last frame is answered
+	std::mutex m_lock;
+	std::vector<zxing::Ref<Client> > m_clients;
+	std::vector<int> m_freeSources;
+	Statistics m_statistics;
+	zxing::Metrics::Counter m_rejectedFrames;
+	zxing::Metrics::Gauge m_connectedClients;
+
+	void Accept();
+	bool Receive(zxing::Ref<Client> client);
+	void Hello(zxing::Ref<Client> client, const void *message, size_t size, int fd);
+	void Submit(zxing::Ref<Client> client, const void *message, size_t size);
+	void Reject(zxing::Ref<Client> client, uint32_t request, const char *why);
+	void Reply(zxing::Ref<Client> client, const void *message, size_t size);
+	void Close(zxing::Ref<Client> client);
+	void Release(int source);
+};
+
+#endif // DECODE_SERVER_H
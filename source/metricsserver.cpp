@@ -0,0 +1,223 @@
+/* metricsserver.cpp - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+	*/
+
+#include "metricsserver.h"
+
+#include "zxing/common/Metrics.h"
+#include "zxing/common/Trace.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <string.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <stdlib.h>
+#include <algorithm>
+#include <chrono>
+#include <sstream>
+#include <string>
+
+typedef std::chrono::steady_clock Clock;
+
+// Longest trace /trace records, so a mistyped window does not stop the metrics for long
+static const int c_maxTraceMs = 10000;
+
+MetricsServer::MetricsServer(int port, int logIntervalS, std::ostream &log)
+	: m_listener(-1), m_logIntervalS(logIntervalS), m_log(log)
+{
+	if (pipe2(m_stop, O_CLOEXEC) < 0)
+	{
+		m_log << "Metrics disabled: " << strerror(errno) << std::endl;
+		m_stop[0] = m_stop[1] = -1;
+		return;
+	}
+
+	if (port > 0)
+	{
+		sockaddr_in address;
+		memset(&address, 0, sizeof(address));
+		address.sin_family = AF_INET;
+		address.sin_port = htons((uint16_t)port);
+		// Only for a scraper on this machine, or one reaching it through a proxy
+		address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+		int yes = 1;
+		m_listener = socket(AF_INET, SOCK_STREAM | SOCK_CLOEXEC, 0);
+		if (m_listener < 0 || setsockopt(m_listener, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes)) < 0 ||
+			bind(m_listener, (sockaddr*)&address, sizeof(address)) < 0 || listen(m_listener, 8) < 0)
+		{
+			m_log << "Metrics not served on port " << port << ": " << strerror(errno) << std::endl;
+			if (m_listener >= 0)
+				close(m_listener);
+			m_listener = -1;
+		}
+	}
+
+	if (m_listener >= 0 || m_logIntervalS > 0)
+		m_thread = std::thread(&MetricsServer::Run, this);
+}
+
+MetricsServer::~MetricsServer()
+{
+	if (m_thread.joinable())
+	{
+		char stop = 1;
+		while (write(m_stop[1], &stop, 1) < 0 && errno == EINTR);
+		m_thread.join();
+	}
+	if (m_listener >= 0)
+		close(m_listener);
+	if (m_stop[0] >= 0)
+	{
+		close(m_stop[0]);
+		close(m_stop[1]);
+	}
+}
+
+void MetricsServer::Run()
+{
+	Clock::time_point nextLog = Clock::now() + std::chrono::seconds(m_logIntervalS);
+	for (;;)
+	{
+		int timeoutMs = -1;
+		if (m_logIntervalS > 0)
+			timeoutMs = (int)std::max<long long>(0, std::chrono::duration_cast<std::chrono::milliseconds>(nextLog - Clock::now()).count());
+
+		pollfd fds[2];
+		fds[0].fd = m_stop[0];
+		fds[0].events = POLLIN;
+		// poll skips a negative descriptor, so a log-only server waits on the pipe alone
+		fds[1].fd = m_listener;
+		fds[1].events = POLLIN;
+		if (poll(fds, 2, timeoutMs) < 0)
+		{
+			if (errno == EINTR)
+				continue;
+			m_log << "Metrics stopped: " << strerror(errno) << std::endl;
+			return;
+		}
+		if (fds[0].revents != 0)
+			return;
+
+		if (fds[1].revents & POLLIN)
+		{
+			int connection = accept4(m_listener, NULL, NULL, SOCK_CLOEXEC);
+			if (connection >= 0)
+			{
+				Answer(connection);
+				close(connection);
+			}
+		}
+
+		if (m_logIntervalS > 0 && Clock::now() >= nextLog)
+		{
+			// One write, so it does not interleave with other threads' lines
+			std::ostringstream snapshot;
+			snapshot << "Metrics:" << std::endl << zxing::Metrics::snapshot();
+			m_log << snapshot.str() << std::flush;
+			nextLog += std::chrono::seconds(m_logIntervalS);
+		}
+	}
+}
+
+void MetricsServer::Answer(int connection)
+{
+	// A scraper that sends its request slowly, or never, cannot hold up the log for long
+	timeval timeout = { 1, 0 };
+	setsockopt(connection, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+	std::string request;
+	char buffer[1024];
+	while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192)
+	{
+		ssize_t size = recv(connection, buffer, sizeof(buffer), 0);
+		if (size <= 0)
+			return;
+		request.append(buffer, size);
+	}
+
+	// Request line: method, target, version
+	std::istringstream line(request.substr(0, request.find("\r\n")));
+	std::string method, target;
+	line >> method >> target;
+	size_t query = target.find('?');
+	std::string path = target.substr(0, query);
+
+	std::string status = "200 OK";
+	std::string contentType = "text/plain; version=0.0.4; charset=utf-8";
+	std::string body;
+	if (method != "GET" && method != "HEAD")
+	{
+		status = "405 Method Not Allowed";
+		body = "Only GET and HEAD are supported\n";
+	}
+	else if (path == "/metrics")
+		body = zxing::Metrics::scrape();
+	else if (path == "/trace")
+	{
+		int windowMs = 1000;
+		if (query != std::string::npos && target.compare(query, 4, "?ms=") == 0)
+			windowMs = atoi(target.c_str() + query + 4);
+		contentType = "application/json";
+		body = CaptureTrace(std::min(std::max(windowMs, 1), c_maxTraceMs));
+	}
+	else
+	{
+		status = "404 Not Found";
+		body = "Metrics are served at /metrics and traces at /trace?ms=N\n";
+	}
+
+	std::ostringstream response;
+	response << "HTTP/1.1 " << status << "\r\n"
+		<< "Content-Type: " << contentType << "\r\n"
+		<< "Content-Length: " << body.size() << "\r\n"
+		<< "Connection: close\r\n\r\n";
+	if (method != "HEAD")
+		response << body;
+	std::string bytes = response.str();
+	for (size_t sent = 0; sent < bytes.size();)
+	{
+		ssize_t size = send(connection, bytes.data() + sent, bytes.size() - sent, MSG_NOSIGNAL);
+		if (size < 0 && errno == EINTR)
+			continue;
+		if (size <= 0)
+			return;
+		sent += size;
+	}
+}
+
+std::string MetricsServer::CaptureTrace(int windowMs)
+{
+	if (!zxing::Trace::recording())
+	{
+		zxing::Trace::start();
+		// Cut short by the destructor, with what was recorded so far
+		pollfd stop;
+		stop.fd = m_stop[0];
+		stop.events = POLLIN;
+		Clock::time_point end = Clock::now() + std::chrono::milliseconds(windowMs);
+		for (Clock::time_point now = Clock::now(); now < end; now = Clock::now())
+		{
+			int remainingMs = (int)std::chrono::duration_cast<std::chrono::milliseconds>(end - now).count() + 1;
+			if (poll(&stop, 1, remainingMs) > 0)
+				break;
+		}
+		zxing::Trace::stop();
+	}
+	return zxing::Trace::exportChromeTrace(windowMs);
+}
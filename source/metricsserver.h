@@ -0,0 +1,53 @@
+/* metricsserver.h - mbreit
+
+	Copyright 2017 - 2019 Matthew Breit <matt.breit@gmail.com>
+
+	Licensed under the Apache License, Version 2.0 (the "License");
+	you may not use this file except in compliance with the License.
+	You may obtain a copy of the License at
+
+	http://www.apache.org/licenses/LICENSE-2.0
+
+	Unless required by applicable law or agreed to in writing, software
+	distributed under the License is distributed on an "AS IS" BASIS,
+	WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+	See the License for the specific language governing permissions and
+	limitations under the License.
+	*/
+
+#ifndef METRICS_SERVER_H
+#define METRICS_SERVER_H
+
+#include <ostream>
+#include <string>
+#include <thread>
+
+// Serves zxing::Metrics to Prometheus over HTTP at /metrics on a loopback port, and writes a snapshot of them to a
+// log at a fixed interval, both from a thread of its own. Scrapes are answered one at a time; each takes a moment
+// under the metrics' lock and none of the decoding threads wait on it.
+//
+// /trace?ms=N answers with the zxing::Trace spans of the last N milliseconds, 1000 by default, as Chrome trace-event
+// JSON. Unless a trace is already being recorded, one is recorded for the next N milliseconds first, during which
+// nothing else is answered or logged. Spans are only recorded by code built with ZXING_TRACE.
+class MetricsServer
+{
+public:
+	// Nothing is served when port is 0 or cannot be bound, which is reported to the log; nothing is logged when
+	// logIntervalS is 0
+	MetricsServer(int port, int logIntervalS, std::ostream &log);
+	~MetricsServer();
+
+private:
+	int m_listener;
+	int m_logIntervalS;
+	std::ostream &m_log;
+	// Written to by the destructor to wake the thread
+	int m_stop[2];
+	std::thread m_thread;
+
+	void Run();
+	void Answer(int connection);
+	std::string CaptureTrace(int windowMs);
+};
+
+#endif // METRICS_SERVER_H